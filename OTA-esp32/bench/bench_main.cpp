@@ -0,0 +1,1368 @@
+// Host benchmark harness for the native environment.
+//
+//   pio run -e native && .pio/build/native/program
+//
+// Runs the firmware's setup()/loop() against the simulated HAL and reports
+// simulated time (what the ESP32 would spend, I2C/flash/radio included),
+// host CPU time, bus traffic and heap allocations for the hot paths.
+
+#include <Arduino.h>
+#include <Update.h>
+#include <WebServer.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <sim.h>
+
+#include <mbedtls/sha256.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "config.h"
+#include "display.h"
+#include "menu.h"
+#include "settings.h"
+#include "signal_history.h"
+#include "wifi_scanner.h"
+
+void setup();
+void loop();
+
+extern Display* display;
+extern WiFiScanner* wifiScanner;
+extern Menu* menu;
+extern WebServer server;
+extern Settings settings;
+
+namespace {
+
+const unsigned long LOOP_PERIOD_US = NET_LOOP_DELAY_MS * 1000;  // the delay at the end of loop()
+
+// Measures one region: simulated time, host time, I2C and heap deltas.
+class Probe {
+public:
+    Probe() { restart(); }
+
+    void restart() {
+        start = sim::now();
+        hostStart = std::chrono::steady_clock::now();
+        Wire.resetStats();
+        heapStart = sim::heap();
+        sim::resetHeapPeak();
+        heapStart.peakBytes = heapStart.bytesInUse;
+    }
+
+    uint64_t simStart() const { return start; }
+    uint64_t simUs() const { return sim::now() - start; }
+    double hostUs() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                         hostStart)
+            .count();
+    }
+    unsigned long i2cBytes() const { return Wire.stats().bytes; }
+    unsigned long i2cTransactions() const { return Wire.stats().transactions; }
+    size_t allocations() const { return sim::heap().allocations - heapStart.allocations; }
+    size_t peakHeap() const { return sim::heap().peakBytes - heapStart.peakBytes; }
+
+private:
+    uint64_t start;
+    std::chrono::steady_clock::time_point hostStart;
+    sim::HeapStats heapStart;
+};
+
+void report(const char* scenario, const char* metric, double value, const char* unit) {
+    printf("%-16s %-28s %14.2f %s\n", scenario, metric, value, unit);
+}
+
+int failedChecks = 0;
+
+// A metric that must hold: reported as 1 or 0 like the others, and a 0
+// makes the run exit non-zero
+void check(const char* scenario, const char* metric, bool passed) {
+    report(scenario, metric, passed ? 1 : 0, "");
+    if (!passed) {
+        fprintf(stderr, "FAILED: %s %s\n", scenario, metric);
+        failedChecks++;
+    }
+}
+
+// A quick click: held just past the debounce window, so the release edge
+// counts and the next loop() sees the whole press.
+void pressButton(uint8_t pin) {
+    sim::setPin(pin, LOW);
+    sim::advance(INPUT_DEBOUNCE_MS * 1000ULL);
+    sim::setPin(pin, HIGH);
+}
+
+// Runs loop() for a stretch of simulated time.
+void idle(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        loop();
+    }
+}
+
+// Runs loop() until everything queued on the server has been answered and
+// the harness clock has caught up with the answer; a server task may have
+// served it ahead of the harness.
+void serve(WebServer& on, const std::function<void()>& eachLoop = nullptr) {
+    while (on.simPending() || sim::now() < on.simLastResponse().doneAt) {
+        loop();
+        if (eachLoop) {
+            eachLoop();
+        }
+    }
+}
+
+// Runs loop() until the debounce window has passed so the next press
+// counts, and lets the UI task finish with everything up to now.
+void settle() {
+    idle(INPUT_DEBOUNCE_MS + 30);
+    sim::settleTasks();
+}
+
+void benchBoot() {
+    Probe probe;
+    unsigned long readsBefore = sim::calls("Preferences.get");
+    setup();
+    report("boot", "nvs_reads", sim::calls("Preferences.get") - readsBefore, "");
+    report("boot", "setup_sim", probe.simUs() / 1000.0, "ms");
+    display->sync();
+    report("boot", "setup_i2c_bytes", probe.i2cBytes(), "B");
+    report("boot", "setup_allocations", probe.allocations(), "");
+}
+
+void benchMenuRedraw() {
+    const int presses = 50;
+    uint64_t simTotal = 0, simMax = 0;
+    double hostTotal = 0;
+    unsigned long bytesTotal = 0;
+    uint64_t latencyTotal = 0, frameTotal = 0;
+    size_t allocTotal = 0;
+    unsigned long rowsBefore = display->listRowsDrawn();
+    for (int i = 0; i < presses; i++) {
+        settle();
+        Probe probe;
+        menu->handleDownButton();
+        uint64_t us = probe.simUs();
+        simTotal += us;
+        simMax = us > simMax ? us : simMax;
+        hostTotal += probe.hostUs();
+        allocTotal += probe.allocations();
+        // Pixels go out on the display task; wait for them to count the bus
+        display->sync();
+        bytesTotal += probe.i2cBytes();
+        latencyTotal += display->latencyTimeUs();
+        frameTotal += display->frameTimeUs();
+    }
+    report("menu.redraw", "sim_avg", simTotal / 1000.0 / presses, "ms");
+    report("menu.redraw", "sim_max", simMax / 1000.0, "ms");
+    report("menu.redraw", "host_avg", hostTotal / presses, "us");
+    report("menu.redraw", "pixel_latency_avg", latencyTotal / 1000.0 / presses, "ms");
+    report("menu.redraw", "frame_avg", frameTotal / 1000.0 / presses, "ms");
+    report("menu.redraw", "i2c_bytes_per_press", bytesTotal / double(presses), "B");
+    report("menu.redraw", "allocs_per_press", allocTotal / double(presses), "");
+    report("menu.redraw", "rows_drawn_per_press",
+           (display->listRowsDrawn() - rowsBefore) / double(presses), "");
+}
+
+// The status bar redraws once a second while connected (drawn directly, as
+// the bench device is not associated); only the uptime minutes change.
+void benchStatusBar() {
+    const int ticks = 10;
+    uint64_t simTotal = 0;
+    unsigned long bytesTotal = 0;
+    for (int i = 0; i < ticks; i++) {
+        sim::advance(60ULL * 1000000);
+        Probe probe;
+        display->drawStatusBar("bench", 80, 40.0f);
+        simTotal += probe.simUs();
+        display->sync();
+        bytesTotal += probe.i2cBytes();
+    }
+    report("menu.status_bar", "sim_avg", simTotal / 1000.0 / ticks, "ms");
+    report("menu.status_bar", "i2c_bytes_per_tick", bytesTotal / double(ticks), "B");
+}
+
+// Runs loop() with a button held down for the given time.
+void holdButton(uint8_t pin, unsigned long ms) {
+    sim::setPin(pin, LOW);
+    idle(ms);
+}
+
+// Button edges go through the ISR ring with per-pin debounce, so presses
+// on two buttons close together both count; held buttons repeat (arrows)
+// or go back (SELECT). Starts and ends in the main menu.
+void benchInput() {
+    while (menu->getSelectedIndex() != 3) {
+        pressButton(BUTTON_DOWN);
+        settle();
+    }
+    // DOWN onto "System Info", SELECT 20 ms later
+    sim::setPin(BUTTON_DOWN, LOW);
+    sim::advance(20000);
+    sim::setPin(BUTTON_SELECT, LOW);
+    sim::advance(INPUT_DEBOUNCE_MS * 1000ULL);
+    sim::setPin(BUTTON_DOWN, HIGH);
+    sim::setPin(BUTTON_SELECT, HIGH);
+    settle();
+    report("input", "two_buttons_20ms_apart", menu->getState() == SYSTEM_INFO_MENU ? 2 : 1, "");
+
+    holdButton(BUTTON_SELECT, INPUT_LONG_PRESS_MS + 50);
+    bool backWhileHeld = menu->getState() == MAIN_MENU;
+    sim::setPin(BUTTON_SELECT, HIGH);
+    settle();
+    report("input", "long_press_back", backWhileHeld ? 1 : 0, "");
+
+    int moves = 0;
+    int index = menu->getSelectedIndex();
+    sim::setPin(BUTTON_DOWN, LOW);
+    unsigned long start = millis();
+    while (millis() - start < 1000) {
+        loop();
+        if (menu->getSelectedIndex() != index) {
+            index = menu->getSelectedIndex();
+            moves++;
+        }
+    }
+    sim::setPin(BUTTON_DOWN, HIGH);
+    settle();
+    report("input", "moves_per_1s_hold", moves, "");
+}
+
+// Starts from the freshly booted main menu, where "Scan WiFi" is highlighted.
+void benchScan() {
+    // The scanner rate-limits to one scan per WIFI_SCAN_INTERVAL since boot.
+    while (millis() < WIFI_SCAN_INTERVAL) {
+        loop();
+    }
+    Probe total;
+    pressButton(BUTTON_SELECT);
+    uint64_t worstLoop = 0, worstInFlight = 0;
+    int iterations = 0;
+    bool started = false;
+    do {
+        bool inFlight = wifiScanner->isScanning();
+        started = started || inFlight;
+        Probe iteration;
+        loop();
+        uint64_t us = iteration.simUs();
+        worstLoop = us > worstLoop ? us : worstLoop;
+        // Iterations that only polled the radio (no press handling, no list draw)
+        if (inFlight && wifiScanner->isScanning() && us > worstInFlight) {
+            worstInFlight = us;
+        }
+        iterations++;
+        // The UI task asks for the scan; loop() starts it a pass or two later
+    } while (total.simUs() < 6000000 && (!started || wifiScanner->isScanning()));
+    sim::settleTasks();
+    report("wifi.scan", "networks", wifiScanner->getNetworkCount(), "");
+    report("wifi.scan", "scan_to_list_sim", total.simUs() / 1000.0, "ms");
+    report("wifi.scan", "worst_loop_sim", worstLoop / 1000.0, "ms");
+    report("wifi.scan", "worst_loop_over_period", (worstLoop - LOOP_PERIOD_US) / 1000.0, "ms");
+    report("wifi.scan", "in_flight_loop_max", worstInFlight / 1000.0, "ms");
+    report("wifi.scan", "loop_iterations", iterations, "");
+    report("wifi.scan", "allocations", total.allocations(), "");
+
+    // Leave the list through the strongest (secured) entry, back to the main
+    // menu once its hint has been up for 2 s.
+    settle();
+    pressButton(BUTTON_SELECT);
+    idle(2000);
+    settle();
+}
+
+// Synthetic application image with roughly the entropy mix of a real
+// ESP32 build: instruction words from a limited opcode set, string tables
+// and incompressible constant/data sections.
+std::string makeFirmwareImage(size_t size) {
+    static const char* const strings[] = {
+        "WiFi connect failed: %s\n", "Update Success: %u\n", "E (%u) %s: %s\n",
+        "esp32-ota", "/update", "text/html", "HomeNet", "nvs_flash_init", "[%s] %d dBm"};
+    std::string image(size, '\0');
+    uint32_t x = 2463534242u;
+    auto next = [&x]() {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    };
+    size_t i = 0;
+    while (i < size) {
+        uint32_t kind = next() % 10;
+        size_t run = 256 + next() % 1024;
+        for (size_t end = std::min(size, i + run); i < end;) {
+            if (kind < 6) {
+                // 3-byte instruction: one of 48 opcodes, register operands
+                uint32_t op = next();
+                image[i++] = static_cast<char>(0x20 + (op % 48) * 3);
+                if (i < end) image[i++] = static_cast<char>((op >> 8) & 0x1F);
+                if (i < end) image[i++] = static_cast<char>((op >> 16) & 0x07);
+            } else if (kind < 8) {
+                const char* str = strings[next() % (sizeof(strings) / sizeof(strings[0]))];
+                for (; *str && i < end; str++) {
+                    image[i++] = *str;
+                }
+                if (i < end) image[i++] = '\0';
+            } else {
+                image[i++] = static_cast<char>(next());
+            }
+        }
+    }
+    image[0] = static_cast<char>(ESP_IMAGE_HEADER_MAGIC);
+    return image;
+}
+
+std::string gzipCompress(const std::string& data) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = out.size();
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+std::string gzipDecompress(const std::string& data) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    inflateInit2(&stream, 15 + 16);
+    std::string out;
+    char buffer[4096];
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    int status;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (status == Z_OK);
+    inflateEnd(&stream);
+    return status == Z_STREAM_END ? out : std::string();
+}
+
+// Next release of makeFirmwareImage(): a function inserted mid-image, code
+// after it relocated (embedded addresses shift), a version string edited.
+std::string makeNextRelease(const std::string& image, size_t insertAt, size_t inserted) {
+    std::string next = image.substr(0, insertAt);
+    uint32_t x = 88172645u;
+    for (size_t i = 0; i < inserted; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        next += static_cast<char>(x);
+    }
+    next += image.substr(insertAt);
+    for (size_t i = insertAt + inserted; i + 64 < next.size(); i += 61) {
+        next[i] = static_cast<char>(next[i] + static_cast<char>(inserted));
+    }
+    memcpy(&next[next.size() * 4 / 5], "v1.0.1-rc2 build 2026-10-17", 27);
+    return next;
+}
+
+void appendLE32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out += static_cast<char>(v >> (8 * i));
+    }
+}
+
+uint32_t crc32Of(const std::string& data) {
+    return crc32(0, reinterpret_cast<const Bytef*>(data.data()), data.size());
+}
+
+// Delta patch in the tools/make_delta.py format for a known alignment:
+// target[0, insertAt) and target[insertAt + inserted, end) come from the
+// source with diff bytes, the inserted run is sent as extra bytes.
+std::string makeDeltaPatch(const std::string& source, const std::string& target,
+                           size_t insertAt, size_t inserted) {
+    std::string patch = "DLT1";
+    appendLE32(patch, source.size());
+    appendLE32(patch, crc32Of(source));
+    appendLE32(patch, target.size());
+    appendLE32(patch, crc32Of(target));
+    size_t tail = source.size() - insertAt;
+    appendLE32(patch, insertAt);
+    appendLE32(patch, inserted);
+    appendLE32(patch, 0);
+    for (size_t i = 0; i < insertAt; i++) {
+        patch += static_cast<char>(target[i] - source[i]);
+    }
+    patch += target.substr(insertAt, inserted);
+    appendLE32(patch, tail);
+    appendLE32(patch, 0);
+    appendLE32(patch, 0);
+    for (size_t i = 0; i < tail; i++) {
+        patch += static_cast<char>(target[insertAt + inserted + i] - source[insertAt + i]);
+    }
+    return patch;
+}
+
+// Uploads payload through /update, checks that the flashed image equals
+// expected and returns the simulated seconds it took.
+double runUpload(const char* scenario, const std::string& payload, const std::string& expected,
+               const std::function<void(size_t)>& progress = nullptr,
+               const std::function<void()>& eachLoop = nullptr) {
+    WebServer::SimRequest request;
+    {
+        sim::Untracked untracked;
+        request.method = HTTP_POST;
+        request.uri = "/update";
+        request.filename = "firmware.bin";
+        request.body = payload;
+        request.onProgress = progress;
+    }
+    Probe probe;
+    server.simQueue(request);
+    unsigned long restartsBefore = sim::calls("ESP.restart");
+    serve(server, eachLoop);
+    // From the request to the response, on whichever thread served it
+    double seconds = (server.simLastResponse().doneAt - probe.simStart()) / 1e6;
+    // The UI task kept drawing the status bar meanwhile; count its heap use too
+    sim::settleTasks();
+    const std::vector<uint8_t>& written = Update.simImage();
+    bool intact = written.size() == expected.size() &&
+                  memcmp(written.data(), expected.data(), expected.size()) == 0;
+    report(scenario, "image_size", expected.size() / 1024.0, "KiB");
+    report(scenario, "bytes_on_air", payload.size() / 1024.0, "KiB");
+    report(scenario, "total_sim", seconds * 1000.0, "ms");
+    report(scenario, "throughput", expected.size() / 1024.0 / seconds, "KiB/s");
+    report(scenario, "host", probe.hostUs() / 1000.0, "ms");
+    report(scenario, "allocations", probe.allocations(), "");
+    report(scenario, "peak_heap", probe.peakHeap(), "B");
+    check(scenario, "image_intact", intact);
+    report(scenario, "restart_requested", sim::calls("ESP.restart") - restartsBefore, "");
+    report(scenario, "response_code", server.simLastResponse().code, "");
+    return seconds;
+}
+
+// Baselines for what progress events cost: ota.upload and ota.slow_link
+double plainUploadSeconds = 0;
+double slowUploadSeconds = 0;
+
+void benchOtaUpload() {
+    WiFi.begin("HomeNet", "password123");
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < 4000) {
+        loop();
+    }
+    loop();
+
+    std::string image;
+    std::string compressed;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+        compressed = gzipCompress(image);
+    }
+    plainUploadSeconds = runUpload("ota.upload", image, image);
+    runUpload("ota.gzip", compressed, image);
+    report("ota.gzip", "ratio", compressed.size() / double(image.size()), "");
+
+    // Congested 2.4 GHz link: the radio, not flash, is the bottleneck
+    uint32_t linkBefore = sim::costs().linkBitsPerSecond;
+    sim::costs().linkBitsPerSecond = 500000;
+    slowUploadSeconds = runUpload("ota.slow_link", image, image);
+    runUpload("ota.slow_gzip", compressed, image);
+    sim::costs().linkBitsPerSecond = linkBefore;
+}
+
+// DOWN pressed halfway through an upload. While loop() also ran the
+// menu, the press waited for handleClient() to take in the whole image;
+// the UI task answers on its own core and the upload keeps its pace.
+// The upload runs on the OTA server task (or inside loop() with
+// HTTP_SERVER_TASKS 0), so the press is looked for from both sides.
+void benchUiDuringUpload() {
+    std::string image;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+    }
+    int indexBefore = menu->getSelectedIndex();
+    uint64_t pressedAt = 0;
+    uint64_t shownAt = 0;
+    bool released = false;
+    auto lookForPixel = [&]() {
+        sim::settleTasks();  // no-op on a task thread
+        if (!shownAt && menu->getSelectedIndex() != indexBefore) {
+            shownAt = display->shownAtUs();
+        }
+    };
+    runUpload("ota.ui_busy", image, image, [&](size_t received) {
+        if (!pressedAt && received >= image.size() / 2) {
+            sim::setPin(BUTTON_DOWN, LOW);
+            pressedAt = sim::now();
+            lookForPixel();
+        } else if (pressedAt && !released &&
+                   sim::now() - pressedAt >= INPUT_DEBOUNCE_MS * 1000ULL) {
+            sim::setPin(BUTTON_DOWN, HIGH);
+            released = true;
+        }
+    }, [&]() {
+        if (pressedAt) {
+            lookForPixel();
+        }
+    });
+    uint64_t loopWait = sim::now() - pressedAt;
+    settle();
+    report("ota.ui_busy", "press_to_pixel", (shownAt - pressedAt) / 1000.0, "ms");
+    report("ota.ui_busy", "press_wait_for_loop", loopWait / 1000.0, "ms");
+    report("ota.ui_busy", "menu_moved", menu->getSelectedIndex() != indexBefore ? 1 : 0, "");
+}
+
+size_t jsonField(const std::string& json, const char* name) {
+    std::string key = std::string("\"") + name + "\":";
+    size_t pos = json.find(key);
+    return pos == std::string::npos ? 0 : strtoul(json.c_str() + pos + key.size(), nullptr, 10);
+}
+
+// Appends the tools/sign_firmware.py trailer, signed with the key the
+// simulation made for this run
+std::string signImage(const std::string& image) {
+    uint8_t sig[OTA_SIG_TRAILER_SIZE - 8];
+    size_t length = sim::sign(reinterpret_cast<const uint8_t*>(image.data()), image.size(), sig,
+                              sizeof(sig));
+    std::string trailer = "OSG1";
+    trailer += static_cast<char>(length);
+    trailer += static_cast<char>(length >> 8);
+    trailer += std::string(2, '\0');
+    trailer += std::string(reinterpret_cast<const char*>(sig), length);
+    trailer.resize(OTA_SIG_TRAILER_SIZE, '\0');
+    return image + trailer;
+}
+
+void benchOtaSigned() {
+    std::string image;
+    std::string signedImage;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+        signedImage = signImage(image);
+    }
+
+    // Hash cost on its own, against the flash rate it has to keep up with
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    Probe hash;
+    mbedtls_sha256_starts_ret(&sha, 0);
+    mbedtls_sha256_update_ret(&sha, reinterpret_cast<const unsigned char*>(image.data()),
+                              image.size());
+    unsigned char digest[32];
+    mbedtls_sha256_finish_ret(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    double flashSeconds = image.size() / 4096.0 *
+                          (sim::costs().flashEraseSectorUs + sim::costs().flashProgramSectorUs) / 1e6;
+    report("ota.signed", "sha_sim_throughput", image.size() / 1024.0 / (hash.simUs() / 1e6), "KiB/s");
+    report("ota.signed", "sha_host_throughput", image.size() / 1024.0 / (hash.hostUs() / 1e6), "KiB/s");
+    report("ota.signed", "sha_share_of_flash", hash.simUs() / 1e6 / flashSeconds * 100.0, "%");
+
+    unsigned long verifiesBefore = sim::calls("mbedtls_pk_verify");
+    runUpload("ota.signed", signedImage, image);
+    report("ota.signed", "signature_checks", sim::calls("mbedtls_pk_verify") - verifiesBefore, "");
+
+    std::string tampered = signedImage;
+    tampered[tampered.size() / 2] ^= 0x01;
+    WebServer::SimRequest request;
+    {
+        sim::Untracked untracked;
+        request.method = HTTP_POST;
+        request.uri = "/update";
+        request.filename = "firmware.bin";
+        request.body = tampered;
+    }
+    server.simQueue(request);
+    serve(server);
+    check("ota.signed", "tampered_rejected", server.simLastResponse().body == "FAIL");
+}
+
+// Marginal link: the connection drops once, 70% into the image.
+void benchOtaResume() {
+    std::string image;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+    }
+    const size_t dropAt = image.size() * 7 / 10;
+    uint32_t linkBefore = sim::costs().linkBitsPerSecond;
+    sim::costs().linkBitsPerSecond = 500000;
+
+    // Plain POST: the dropped attempt is thrown away and sent again in full
+    Probe restart;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        WebServer::SimRequest request;
+        {
+            sim::Untracked untracked;
+            request.method = HTTP_POST;
+            request.uri = "/update";
+            request.filename = "firmware.bin";
+            request.body = image;
+            request.dropAfter = attempt == 0 ? dropAt : SIZE_MAX;
+        }
+        server.simQueue(request);
+        serve(server);
+    }
+    double restartSeconds = restart.simUs() / 1e6;
+    bool restartIntact = Update.simImage().size() == image.size() &&
+                         memcmp(Update.simImage().data(), image.data(), image.size()) == 0;
+
+    // PUT chunks: only the chunk in flight is resent; one chunk also
+    // arrives corrupted and is refused by its CRC
+    Probe probe;
+    unsigned long restartsBefore = sim::calls("ESP.restart");
+    size_t offset = 0;
+    size_t sent = 0;
+    int requests = 0;
+    bool dropped = false;
+    bool corrupted = false;
+    int conflicts = 0;
+    int crcRejects = 0;
+    while (offset < image.size() && requests < 1000) {
+        size_t n = std::min<size_t>(OTA_CHUNK_SIZE, image.size() - offset);
+        WebServer::SimRequest request;
+        {
+            sim::Untracked untracked;
+            request.method = HTTP_PUT;
+            request.uri = "/update";
+            request.contentType = "application/octet-stream";
+            request.body = image.substr(offset, n);
+            char query[64];
+            snprintf(query, sizeof(query), "offset=%zu&crc=%08x&total=%zu", offset,
+                     crc32Of(request.body), image.size());
+            request.query = query;
+            if (!dropped && offset + n > dropAt) {
+                request.dropAfter = dropAt - offset;
+                dropped = true;
+            } else if (!corrupted && offset > image.size() / 4) {
+                request.body[n / 2] ^= 0x40;
+                corrupted = true;
+            }
+        }
+        server.simQueue(request);
+        sent += std::min(n, request.dropAfter);
+        requests++;
+        serve(server);
+        const WebServer::SimResponse& response = server.simLastResponse();
+        if (response.code == 0) {
+            // No response: ask where to pick up
+            WebServer::SimRequest status;
+            status.uri = "/update/status";
+            server.simQueue(status);
+            requests++;
+            serve(server);
+            offset = jsonField(server.simLastResponse().body, "offset");
+            continue;
+        }
+        if (response.code == 409) {
+            conflicts++;
+        } else if (response.code == 400) {
+            crcRejects++;
+        } else if (response.code != 200) {
+            break;
+        }
+        offset = jsonField(response.body, "offset");
+    }
+    double seconds = probe.simUs() / 1e6;
+    const std::vector<uint8_t>& written = Update.simImage();
+    bool intact = written.size() == image.size() &&
+                  memcmp(written.data(), image.data(), image.size()) == 0;
+    sim::costs().linkBitsPerSecond = linkBefore;
+
+    report("ota.resume", "restart_total_sim", restartSeconds * 1000.0, "ms");
+    report("ota.resume", "restart_bytes_on_air", (dropAt + image.size()) / 1024.0, "KiB");
+    check("ota.resume", "restart_intact", restartIntact);
+    report("ota.resume", "total_sim", seconds * 1000.0, "ms");
+    report("ota.resume", "bytes_on_air", sent / 1024.0, "KiB");
+    report("ota.resume", "requests", requests, "");
+    report("ota.resume", "crc_rejects", crcRejects, "");
+    report("ota.resume", "conflicts", conflicts, "");
+    report("ota.resume", "peak_heap", probe.peakHeap(), "B");
+    check("ota.resume", "image_intact", intact);
+    report("ota.resume", "restart_requested", sim::calls("ESP.restart") - restartsBefore, "");
+}
+
+void benchOtaDelta() {
+    const size_t insertAt = 600 * 1024;
+    const size_t inserted = 512;
+    std::string image;
+    std::string next;
+    std::string patch;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+        next = makeNextRelease(image, insertAt, inserted);
+        patch = gzipCompress(makeDeltaPatch(image, next, insertAt, inserted));
+    }
+    sim::setRunningImage(reinterpret_cast<const uint8_t*>(image.data()), image.size());
+    unsigned long readsBefore = sim::calls("esp_partition_read");
+    runUpload("ota.delta", patch, next);
+    report("ota.delta", "source_reads", sim::calls("esp_partition_read") - readsBefore, "");
+
+    // After the reboot the same patch no longer matches the running image
+    sim::setRunningImage(reinterpret_cast<const uint8_t*>(next.data()), next.size());
+    std::vector<uint8_t> previous = Update.simImage();
+    WebServer::SimRequest request;
+    {
+        sim::Untracked untracked;
+        request.method = HTTP_POST;
+        request.uri = "/update";
+        request.filename = "update.dlt";
+        request.body = patch;
+    }
+    server.simQueue(request);
+    serve(server);
+    bool rejected = server.simLastResponse().body == "FAIL";
+    check("ota.delta", "wrong_base_rejected", rejected);
+}
+
+// Runs the network side until the scanner has no scan in flight
+void finishScans() {
+    do {
+        loop();
+    } while (wifiScanner->isScanning());
+}
+
+// Serves one GET and reports what it cost; a non-empty etag goes out as
+// If-None-Match
+WebServer::SimResponse fetch(WebServer* on, const char* scenario, const char* suffix,
+                             const char* uri, const std::string& etag) {
+    WebServer::SimRequest request;
+    {
+        sim::Untracked untracked;
+        request.uri = uri;
+        if (!etag.empty()) {
+            request.headers.push_back(std::make_pair("If-None-Match", etag));
+        }
+    }
+    on->simQueue(request);
+    Probe probe;
+    serve(*on);
+    sim::Untracked untracked;
+    const WebServer::SimResponse& response = on->simLastResponse();
+    std::string metric = std::string("code_") + suffix;
+    report(scenario, metric.c_str(), response.code, "");
+    metric = std::string("wire_bytes_") + suffix;
+    report(scenario, metric.c_str(), response.wireBytes, "B");
+    metric = std::string("peak_heap_") + suffix;
+    report(scenario, metric.c_str(), probe.peakHeap(), "B");
+    metric = std::string("allocations_") + suffix;
+    report(scenario, metric.c_str(), probe.allocations(), "");
+    return response;
+}
+
+WebServer::SimResponse fetchAp(const char* suffix, const char* uri, const std::string& etag) {
+    return fetch(WebServer::simOnPort(80), "ap.page", suffix, uri, etag);
+}
+
+std::string headerOf(const WebServer::SimResponse& response, const char* name) {
+    for (auto& h : response.headers) {
+        if (h.first == name) {
+            return h.second;
+        }
+    }
+    return "";
+}
+
+std::string etagOf(const WebServer::SimResponse& response) {
+    return headerOf(response, "ETag");
+}
+
+// A page from web_assets.h: gzip that inflates to HTML, cacheable
+void checkAsset(const char* scenario, const WebServer::SimResponse& response) {
+    sim::Untracked untracked;
+    bool gzip = headerOf(response, "Content-Encoding") == "gzip";
+    std::string html = gzipDecompress(response.body);
+    check(scenario, "gzip", gzip && html.find("</form>") != std::string::npos);
+    report(scenario, "html_bytes", html.size(), "B");
+    check(scenario, "cacheable",
+          headerOf(response, "Cache-Control").find("max-age=") != std::string::npos);
+}
+
+int countOf(const std::string& text, const char* needle) {
+    int count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+        count++;
+    }
+    return count;
+}
+
+// The AP setup page and the list it polls: the page once, the list with a
+// full scan, again unchanged (304), and with a short scan; the list
+// handler's heap use should not depend on its length. Last, a poll
+// interval of sweep steps that find nothing new still gets a 304.
+void benchApPage() {
+    static const sim::AccessPoint fewAccessPoints[] = {
+        {"HomeNet", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x01}, 6, -42, WIFI_AUTH_WPA2_PSK, "password123"},
+        {"CafeGuest", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x02}, 1, -55, WIFI_AUTH_OPEN, nullptr},
+    };
+
+    wifiScanner->enableAPMode(true);
+    finishScans();
+    loop();  // the first AP-mode pass forces a rescan
+    finishScans();
+    WebServer::SimResponse page = fetchAp("page", "/", "");
+    checkAsset("ap.page", page);
+    fetchAp("page_revalidate", "/", etagOf(page));
+
+    WebServer::SimResponse full = fetchAp("list_full", "/api/networks", "");
+    report("ap.page", "networks_full", countOf(full.body, "\"ssid\""), "");
+    fetchAp("list_unchanged", "/api/networks", etagOf(full));
+
+    sim::setAccessPoints(fewAccessPoints, 2);
+    wifiScanner->startScan();
+    finishScans();
+    WebServer::SimResponse few = fetchAp("list_few", "/api/networks", etagOf(full));
+    report("ap.page", "networks_few", countOf(few.body, "\"ssid\""), "");
+
+    // Quiet air: once a scan has emptied the list, the sweep steps after
+    // the next answer leave it as it is
+    sim::setAccessPoints(fewAccessPoints, 0);
+    finishScans();  // the sweep step the last answer started
+    wifiScanner->startScan();
+    finishScans();
+    WebServer::SimResponse quiet = fetchAp("list_quiet", "/api/networks", "");
+    unsigned long scansBefore = sim::calls("WiFi.scanNetworks");
+    idle(10000);  // setup.html polls every 10 s
+    report("ap.page", "sweep_steps_between_polls", sim::calls("WiFi.scanNetworks") - scansBefore,
+           "");
+    WebServer::SimResponse swept = fetchAp("list_after_sweep", "/api/networks", etagOf(quiet));
+    check("ap.page", "swept_list_unchanged", swept.code == 304);
+
+    sim::setAccessPoints(nullptr, 0);
+    wifiScanner->enableAPMode(false);
+}
+
+// The OTA server's upload form, fresh and revalidated
+void benchOtaPage() {
+    WebServer::SimResponse page = fetch(&server, "ota.page", "page", "/", "");
+    checkAsset("ota.page", page);
+    fetch(&server, "ota.page", "page_revalidate", "/", etagOf(page));
+}
+
+// Two clients at once: a phone asks the AP page for the network list
+// while a firmware upload is in flight on the OTA server. Served from one
+// loop(), the list waits for the whole upload; with a task per server it
+// is answered right away and the upload keeps its pace.
+void benchConcurrentClients() {
+    std::string image;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+    }
+    wifiScanner->enableAPMode(true);
+    finishScans();
+    WebServer* ap = WebServer::simOnPort(80);
+    uint64_t askedAt = 0;
+    runUpload("http.concurrent", image, image, [&](size_t received) {
+        if (!askedAt && received >= image.size() / 10) {
+            WebServer::SimRequest request;
+            {
+                sim::Untracked untracked;
+                request.uri = "/api/networks";
+            }
+            ap->simQueue(request);
+            askedAt = sim::now();
+        }
+    });
+    serve(*ap);
+    const WebServer::SimResponse& response = ap->simLastResponse();
+    report("http.concurrent", "second_client_code", response.code, "");
+    report("http.concurrent", "second_client_latency", (response.doneAt - askedAt) / 1000.0, "ms");
+    wifiScanner->enableAPMode(false);
+}
+
+// A rollout tool follows an upload on GET /update/events: how often it
+// hears from the device, what the events cost the upload, and the OLED
+// bar they drive. The gap between events bounds how fast a stall shows.
+// Flash sets the pace on a good link, so the cost is also measured on
+// the congested one, where every byte of air time counts.
+void benchOtaEvents() {
+    std::string image;
+    {
+        sim::Untracked untracked;
+        image = makeFirmwareImage(1300 * 1024);
+    }
+    WebServer::SimRequest request;
+    {
+        sim::Untracked untracked;
+        request.uri = "/update/events";
+    }
+    server.simQueue(request);
+    serve(server);
+    std::shared_ptr<SimStream> stream = server.simLastResponse().stream;
+    if (!stream) {
+        check("ota.events", "stream_opened", false);
+        return;
+    }
+    size_t openBytes = WiFiClient::simReceived(stream).size();
+
+    int barMax = -1;
+    double seconds = runUpload("ota.events", image, image, nullptr, [&]() {
+        sim::settleTasks();
+        barMax = std::max(barMax, display->progressShown());
+    });
+    settle();
+    bool barHidden = display->progressShown() < 0;
+
+    sim::Untracked untracked;
+    std::string events = WiFiClient::simReceived(stream);
+    uint64_t gapMax = 0;
+    int receiving = 0;
+    {
+        std::lock_guard<std::mutex> lock(stream->lock);
+        // Headers and the idle state went out on connect
+        for (size_t i = 3; i < stream->writes.size(); i++) {
+            gapMax = std::max(gapMax, stream->writes[i].first - stream->writes[i - 1].first);
+        }
+    }
+    receiving = countOf(events, "\"state\":\"receiving\"");
+    size_t eventBytes = events.size() - openBytes;
+    check("ota.events", "stream_opened", events.find("text/event-stream") != std::string::npos);
+    report("ota.events", "events", countOf(events, "event: progress"), "");
+    report("ota.events", "receiving_events", receiving, "");
+    check("ota.events", "final_done", events.find("\"state\":\"done\"") != std::string::npos);
+    report("ota.events", "event_gap_max", gapMax / 1000.0, "ms");
+    report("ota.events", "event_bytes", eventBytes, "B");
+    report("ota.events", "air_share", eventBytes * 100.0 / image.size(), "%");
+    report("ota.events", "throughput_cost", (seconds / plainUploadSeconds - 1) * 100.0, "%");
+    report("ota.events", "oled_bar_max", barMax, "%");
+    report("ota.events", "oled_bar_hidden", barHidden ? 1 : 0, "");
+
+    uint32_t linkBefore = sim::costs().linkBitsPerSecond;
+    sim::costs().linkBitsPerSecond = 500000;
+    double slowSeconds = runUpload("ota.events_slow", image, image);
+    sim::costs().linkBitsPerSecond = linkBefore;
+    report("ota.events_slow", "throughput_cost", (slowSeconds / slowUploadSeconds - 1) * 100.0, "%");
+    WiFiClient::simClose(stream);
+}
+
+// The same room scanned over and over, each reading +/-4 dB off: how much
+// the list moves from one scan to the next as shown (smoothed, in
+// smoothed order) against what the raw readings alone would show.
+void benchSignalHistory() {
+    const int scans = 20;
+    std::vector<std::string> shownOrder, rawOrder;
+    std::map<std::string, int> shownRssi, rawRssi;
+    int shownMoves = 0, rawMoves = 0;
+    double shownChange = 0, rawChange = 0;
+    int changes = 0;
+    size_t allocations = 0;
+    for (int scan = 0; scan < scans; scan++) {
+        sim::advance(WIFI_SCAN_INTERVAL * 1000ULL);
+        Probe probe;
+        wifiScanner->startScan();
+        finishScans();
+        allocations += probe.allocations();
+
+        sim::Untracked untracked;
+        NetworkInfo nets[MAX_NETWORKS];
+        int count = 0;
+        while (count < MAX_NETWORKS && wifiScanner->getNetwork(count, nets[count])) {
+            count++;
+        }
+        std::vector<std::pair<int, std::string>> byRaw;
+        std::vector<std::string> shown;
+        for (int i = 0; i < count; i++) {
+            std::string ssid = nets[i].ssid;
+            shown.push_back(ssid);
+            byRaw.push_back(std::make_pair(-nets[i].rssiLast, ssid));
+            if (shownRssi.count(ssid)) {
+                shownChange += std::abs(nets[i].rssi - shownRssi[ssid]);
+                rawChange += std::abs(nets[i].rssiLast - rawRssi[ssid]);
+                changes++;
+            }
+            shownRssi[ssid] = nets[i].rssi;
+            rawRssi[ssid] = nets[i].rssiLast;
+        }
+        std::stable_sort(byRaw.begin(), byRaw.end(),
+                         [](const std::pair<int, std::string>& a,
+                            const std::pair<int, std::string>& b) { return a.first < b.first; });
+        std::vector<std::string> raw;
+        for (auto& entry : byRaw) {
+            raw.push_back(entry.second);
+        }
+        if (scan > 0) {
+            for (size_t i = 0; i < shown.size() && i < shownOrder.size(); i++) {
+                shownMoves += shown[i] != shownOrder[i];
+            }
+            for (size_t i = 0; i < raw.size() && i < rawOrder.size(); i++) {
+                rawMoves += raw[i] != rawOrder[i];
+            }
+        }
+        shownOrder = shown;
+        rawOrder = raw;
+    }
+    report("wifi.signal", "moved_per_scan", shownMoves / double(scans - 1), "");
+    report("wifi.signal", "moved_per_scan_raw", rawMoves / double(scans - 1), "");
+    report("wifi.signal", "rssi_change_avg", shownChange / changes, "dB");
+    report("wifi.signal", "rssi_change_avg_raw", rawChange / changes, "dB");
+    report("wifi.signal", "history_bytes", sizeof(SignalHistory), "B");
+    report("wifi.signal", "allocations_per_scan", allocations / double(scans), "");
+}
+
+// The portal left up for 30 s while AP mode keeps the list fresh one
+// channel at a time: how long the radio is away at a stretch, against
+// the full scan it replaces, whether the AP ever goes down, and whether
+// the sweep still finds everything a full scan does.
+void benchApSweep() {
+    Probe fullScan;
+    wifiScanner->enableAPMode(true);
+    finishScans();
+    uint64_t fullScanUs = fullScan.simUs();
+    int fullCount = wifiScanner->getNetworkCount();
+
+    uint64_t downtimeStart = sim::apDowntimeUs();
+    Probe probe;
+    uint64_t away = 0, longest = 0, scanStart = 0;
+    int scans = 0;
+    bool scanning = false;
+    while (probe.simUs() < 30000000) {
+        loop();
+        bool now = wifiScanner->isScanning();
+        if (now && !scanning) {
+            scanStart = sim::now();
+            scans++;
+        } else if (!now && scanning) {
+            away += sim::now() - scanStart;
+            longest = std::max(longest, sim::now() - scanStart);
+        }
+        scanning = now;
+    }
+    finishScans();
+    int count = wifiScanner->getNetworkCount();
+    report("wifi.sweep", "full_scan", fullScanUs / 1000.0, "ms");
+    report("wifi.sweep", "channel_scans", scans, "");
+    report("wifi.sweep", "off_channel_max", longest / 1000.0, "ms");
+    report("wifi.sweep", "radio_share", away * 100.0 / probe.simUs(), "%");
+    report("wifi.sweep", "ap_downtime", (sim::apDowntimeUs() - downtimeStart) / 1000.0, "ms");
+    report("wifi.sweep", "networks_full_scan", fullCount, "");
+    report("wifi.sweep", "networks_swept", count, "");
+    report("wifi.sweep", "allocations", probe.allocations(), "");
+    wifiScanner->enableAPMode(false);
+}
+
+// A phone on the portal for a minute: the page polls the list every
+// 10 s and the user clicks around every few seconds. A request that comes
+// in while the radio is on another channel waits for it; how long the
+// phone ever waits, and how much sweeping still gets done.
+void benchApPortal() {
+    static const unsigned long clickGaps[] = { 1200, 3100, 1700, 2500, 4000, 1500, 2200, 3600 };
+    const int gapCount = sizeof(clickGaps) / sizeof(clickGaps[0]);
+
+    wifiScanner->enableAPMode(true);
+    finishScans();
+    WebServer* ap = WebServer::simOnPort(80);
+    uint64_t downtimeStart = sim::apDowntimeUs();
+    Probe probe;
+    unsigned long nextPoll = 0, nextClick = clickGaps[0];
+    int click = 0, requests = 0, waited = 0, scans = 0;
+    uint64_t worst = 0, total = 0;
+    bool scanning = false;
+    std::function<void()> watch = [&]() {
+        bool now = wifiScanner->isScanning();
+        scans += now && !scanning;
+        scanning = now;
+    };
+    while (probe.simUs() < 60000000) {
+        unsigned long at = probe.simUs() / 1000;
+        const char* uri = nullptr;
+        if (at >= nextPoll) {
+            uri = "/api/networks";
+            nextPoll += 10000;
+        } else if (at >= nextClick) {
+            uri = "/";
+            nextClick += clickGaps[++click % gapCount];
+        }
+        if (uri) {
+            WebServer::SimRequest request;
+            {
+                sim::Untracked untracked;
+                request.uri = uri;
+            }
+            uint64_t queuedAt = sim::now();
+            ap->simQueue(request);
+            serve(*ap, watch);
+            uint64_t latency = ap->simLastResponse().doneAt - queuedAt;
+            worst = std::max(worst, latency);
+            total += latency;
+            requests++;
+            waited += sim::radioHeardAt(queuedAt) > queuedAt;
+        }
+        loop();
+        watch();
+    }
+    finishScans();
+    report("ap.portal", "requests", requests, "");
+    report("ap.portal", "requests_waited", waited, "");
+    report("ap.portal", "latency_max", worst / 1000.0, "ms");
+    report("ap.portal", "latency_avg", total / 1000.0 / requests, "ms");
+    report("ap.portal", "channel_scans", scans, "");
+    report("ap.portal", "ap_downtime", (sim::apDowntimeUs() - downtimeStart) / 1000.0, "ms");
+    report("ap.portal", "allocations_per_request", probe.allocations() / double(requests), "");
+    wifiScanner->enableAPMode(false);
+}
+
+// The portal's connect form, first with a wrong password and then the
+// right one. The phone asks for the network list right behind the form:
+// how long the portal leaves it waiting, how long until the page's
+// /api/connect polls tell how it went, and the time to an IP address.
+void benchPortalConnect() {
+    wifiScanner->enableAPMode(true);
+    finishScans();
+    WebServer* ap = WebServer::simOnPort(80);
+    auto get = [&](const char* uri) {
+        WebServer::SimRequest request;
+        {
+            sim::Untracked untracked;
+            request.uri = uri;
+        }
+        uint64_t queuedAt = sim::now();
+        ap->simQueue(request);
+        serve(*ap);
+        return ap->simLastResponse().doneAt - queuedAt;
+    };
+    auto attempt = [&](const char* name, const char* password) {
+        WebServer::SimRequest form;
+        {
+            sim::Untracked untracked;
+            form.method = HTTP_POST;
+            form.uri = "/connect";
+            form.contentType = "application/x-www-form-urlencoded";
+            form.body = std::string("ssid=HomeNet&password=") + password;
+        }
+        uint64_t postedAt = sim::now();
+        ap->simQueue(form);
+        uint64_t listLatency = get("/api/networks");
+
+        uint64_t worstLoop = 0;
+        std::string state = "connecting";
+        while (state == "connecting" && sim::now() - postedAt < 15000000) {
+            unsigned long lastPoll = millis();
+            while (millis() - lastPoll < 1000) {  // the page polls once a second
+                Probe iteration;
+                loop();
+                worstLoop = std::max(worstLoop, iteration.simUs());
+            }
+            get("/api/connect");
+            sim::Untracked untracked;
+            const std::string& body = ap->simLastResponse().body;
+            size_t at = body.find("\"state\":\"");
+            state = at == std::string::npos ? "none" : body.substr(at + 9, body.find('"', at + 9) - at - 9);
+        }
+        std::string metric = std::string("list_latency_") + name;
+        report("wifi.connect", metric.c_str(), listLatency / 1000.0, "ms");
+        metric = std::string("page_knows_") + name;
+        report("wifi.connect", metric.c_str(), (sim::now() - postedAt) / 1000.0, "ms");
+        metric = std::string("worst_loop_") + name;
+        report("wifi.connect", metric.c_str(), worstLoop / 1000.0, "ms");
+        return state;
+    };
+
+    check("wifi.connect", "failed_wrong_password", attempt("wrong", "nope") == "failed");
+    // The attempt's own failure, not a leave event still queued from before it
+    check("wifi.connect", "failed_auth_reason",
+          ap->simLastResponse().body.find("\"reason\":202") != std::string::npos);
+    unsigned long restartsBefore = sim::calls("ESP.restart");
+    check("wifi.connect", "connected", attempt("right", "password123") == "connected");
+    char ssid[33];
+    wifiScanner->getConnectedSSID(ssid, sizeof(ssid));
+    check("wifi.connect", "connected_ssid", strcmp(ssid, "HomeNet") == 0);
+    report("wifi.connect", "time_to_ip", wifiScanner->lastTimeToIp(), "ms");
+    // A setting changed just before the restart is written, not lost
+    settings.setBrightness((settings.brightness() + 1) % BRIGHTNESS_LEVELS);
+    unsigned long writesBefore = sim::calls("Preferences.put");
+    idle(WIFI_RESTART_DELAY_MS + 100);
+    report("wifi.connect", "restarted", sim::calls("ESP.restart") - restartsBefore, "");
+    check("wifi.connect", "settings_written", sim::calls("Preferences.put") - writesBefore == 1);
+    wifiScanner->enableAPMode(false);
+}
+
+// The connect a restart makes, from WiFi.begin() to an IP: with nothing
+// cached (the station scans every channel for the SSID first), with the
+// BSSID and channel the last connect cached, and with a cache left stale
+// by an access point that moved, which costs the short try before the
+// full connect. Then what /metrics says about it. Last, a move where the
+// short try hears nothing back and times out: the fallback has to get
+// past the leave event its own WiFi.disconnect() queued.
+void benchFastReconnect() {
+    static const sim::AccessPoint moved[] = {
+        {"HomeNet", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x01}, 11, -42, WIFI_AUTH_WPA2_PSK, "password123"},
+    };
+    auto reboot = [&](const char* name) {
+        WiFi.disconnect();
+        idle(100);
+        unsigned long writesBefore = sim::calls("Preferences.put");
+        uint64_t start = sim::now();
+        if (!wifiScanner->reconnect()) {
+            wifiScanner->connect("HomeNet", "password123");
+        }
+        while (wifiScanner->getConnectState() == CONNECT_PENDING && sim::now() - start < 20000000) {
+            loop();
+        }
+        std::string metric = std::string("connected_") + name;
+        check("wifi.reconnect", metric.c_str(), wifiScanner->getConnectState() == CONNECT_OK);
+        metric = std::string("time_to_ip_") + name;
+        report("wifi.reconnect", metric.c_str(), (sim::now() - start) / 1000.0, "ms");
+        metric = std::string("nvs_writes_") + name;
+        report("wifi.reconnect", metric.c_str(), sim::calls("Preferences.put") - writesBefore, "");
+    };
+
+    wifiScanner->forgetNetwork();
+    reboot("uncached");
+    reboot("cached");
+    sim::setAccessPoints(moved, 1);
+    reboot("stale");
+    reboot("recached");
+
+    WebServer::SimResponse metrics = fetch(&server, "wifi.reconnect", "metrics", "/metrics", "");
+    {
+        sim::Untracked untracked;
+        report("wifi.reconnect", "metrics_lines", countOf(metrics.body, "\n"), "");
+        check("wifi.reconnect", "metrics_fast",
+              metrics.body.find("fast_reconnect 1") != std::string::npos);
+    }
+
+    sim::setAccessPoints(nullptr, 0);
+    reboot("moved_back");
+
+    uint32_t missBefore = sim::costs().connectMissMs;
+    sim::costs().connectMissMs = WIFI_CACHE_CONNECT_TIMEOUT + 2000;
+    sim::setAccessPoints(moved, 1);
+    reboot("stale_timeout");
+    sim::costs().connectMissMs = missBefore;
+    sim::setAccessPoints(nullptr, 0);
+    reboot("home");
+}
+
+// Five presses on "Screen Brightness" in a row, as someone looking for the
+// right level would: one NVS write once they stop, not five. Then the
+// next boot's load, all settings in one read.
+void benchSettings() {
+    const int presses = 5;
+    holdButton(BUTTON_SELECT, INPUT_LONG_PRESS_MS + 50);
+    sim::setPin(BUTTON_SELECT, HIGH);
+    settle();
+    while (menu->getSelectedIndex() != 5) {  // "Settings"
+        pressButton(BUTTON_DOWN);
+        settle();
+    }
+    pressButton(BUTTON_SELECT);
+    settle();
+    check("settings", "in_menu", menu->getState() == SETTINGS_MENU);
+
+    uint8_t expected = (settings.brightness() + presses) % BRIGHTNESS_LEVELS;
+    unsigned long writesBefore = sim::calls("Preferences.put");
+    for (int i = 0; i < presses; i++) {
+        pressButton(BUTTON_SELECT);
+        idle(1100);  // past the notification the menu shows for each
+    }
+    sim::settleTasks();
+    report("settings", "writes_while_pressing", sim::calls("Preferences.put") - writesBefore, "");
+    idle(SETTINGS_COMMIT_DELAY_MS + 100);
+    sim::settleTasks();
+    report("settings", "writes_after", sim::calls("Preferences.put") - writesBefore, "");
+
+    Settings reloaded;
+    unsigned long readsBefore = sim::calls("Preferences.get");
+    Probe probe;
+    reloaded.begin();
+    report("settings", "load", probe.simUs(), "us");
+    report("settings", "load_reads", sim::calls("Preferences.get") - readsBefore, "");
+    check("settings", "brightness_kept", reloaded.brightness() == expected);
+
+    holdButton(BUTTON_SELECT, INPUT_LONG_PRESS_MS + 50);
+    sim::setPin(BUTTON_SELECT, HIGH);
+    settle();
+}
+
+// Down the whole scan list and back up, one press at a time: every entry
+// gets its turn on screen, highlighted, however long the list is.
+void benchMenuScroll() {
+    while (menu->getSelectedIndex() != 0) {  // "Scan WiFi"
+        pressButton(BUTTON_UP);
+        settle();
+    }
+    pressButton(BUTTON_SELECT);
+    settle();
+    finishScans();
+    settle();
+    int count = wifiScanner->getNetworkCount();
+    report("menu.scroll", "networks", count, "");
+
+    int presses = 0, hidden = 0;
+    uint64_t simTotal = 0;
+    double hostTotal = 0;
+    unsigned long bytesTotal = 0;
+    unsigned long rowsBefore = display->listRowsDrawn();
+    for (int step = 1; step >= -1; step -= 2) {
+        for (int i = 1; i < count; i++) {
+            Probe probe;
+            if (step > 0) {
+                menu->handleDownButton();
+            } else {
+                menu->handleUpButton();
+            }
+            simTotal += probe.simUs();
+            hostTotal += probe.hostUs();
+            display->sync();
+            bytesTotal += probe.i2cBytes();
+            presses++;
+            int row = menu->getSelectedIndex() - menu->getFirstRow();
+            hidden += row < 0 || row >= MENU_VISIBLE_ROWS;
+        }
+        check("menu.scroll", step > 0 ? "reached_last" : "reached_first",
+              menu->getSelectedIndex() == (step > 0 ? count - 1 : 0));
+    }
+    report("menu.scroll", "highlight_hidden", hidden, "");
+    report("menu.scroll", "sim_avg", simTotal / 1000.0 / presses, "ms");
+    report("menu.scroll", "host_avg", hostTotal / presses, "us");
+    report("menu.scroll", "i2c_bytes_per_press", bytesTotal / double(presses), "B");
+    report("menu.scroll", "rows_drawn_per_press",
+           (display->listRowsDrawn() - rowsBefore) / double(presses), "");
+
+    holdButton(BUTTON_SELECT, INPUT_LONG_PRESS_MS + 50);
+    sim::setPin(BUTTON_SELECT, HIGH);
+    settle();
+}
+
+}  // namespace
+
+// Scenarios share one booted device and run in order; each leaves the UI
+// where the next one expects it. Exits 1 if any check() failed.
+int main() {
+    benchBoot();
+    benchScan();
+    benchMenuRedraw();
+    benchStatusBar();
+    benchInput();
+    benchOtaUpload();
+    benchUiDuringUpload();
+    benchOtaDelta();
+    benchOtaResume();
+    benchOtaSigned();
+    benchApPage();
+    benchOtaPage();
+    benchConcurrentClients();
+    benchOtaEvents();
+    benchSignalHistory();
+    benchApSweep();
+    benchApPortal();
+    benchPortalConnect();
+    benchFastReconnect();
+    benchSettings();
+    benchMenuScroll();
+    sim::stopTasks();
+    return failedChecks == 0 ? 0 : 1;
+}
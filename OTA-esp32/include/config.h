@@ -6,27 +6,103 @@
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
 #define SCREEN_ADDRESS 0x3C
+#define OLED_I2C_CLOCK 1000000     // fast-mode plus; 400000 for panels that can't keep up
+#define OLED_DIRTY_GAP 10          // unchanged columns worth resending to save a window
+#define OLED_ASYNC_FLUSH 1         // push frames from a background task
+#define OLED_TASK_STACK 3072
+#define OLED_TASK_PRIORITY 1
+#define OLED_TASK_CORE 0
+#define MENU_VISIBLE_ROWS 6        // 8 px rows below the title bar
+#define MENU_ROW_SIZE 32           // bytes for one formatted row
 
 // Button Pins
 #define BUTTON_UP 2
 #define BUTTON_DOWN 0
 #define BUTTON_SELECT 4
 
+// Button Input
+#define INPUT_DEBOUNCE_MS 50
+#define INPUT_LONG_PRESS_MS 600      // SELECT held this long goes back
+#define INPUT_REPEAT_DELAY_MS 400    // UP/DOWN held this long starts repeating
+#define INPUT_REPEAT_INTERVAL_MS 80
+
+// Task Layout: loop() runs scans and connects on core 1, next to one task
+// per web server; the UI task runs the menu, buttons and display on core 0
+#define UI_TASK_STACK 6144
+#define UI_TASK_PRIORITY 3         // above the OTA writer, so a press never waits behind flash
+#define UI_TASK_CORE 0
+#define UI_QUEUE_LENGTH 16         // button edges and network events for the UI task
+#define NET_QUEUE_LENGTH 4         // scan/connect/AP requests for loop()
+#define NET_LOOP_DELAY_MS 1        // loop() pause between passes
+#define HTTP_SERVER_TASKS 1        // each web server on its own task; 0 polls them from loop()
+#define HTTP_TASK_STACK 6144       // the upload and page handlers run here
+#define HTTP_TASK_PRIORITY 1
+#define HTTP_TASK_CORE 1
+#define HTTP_POLL_MS 1             // server task pause between handleClient() polls
+
 // AP Mode Settings
 #define AP_SSID "ESP32-Config"
 #define AP_PASSWORD "12345678"
 #define AP_CHANNEL 1
 #define AP_MAX_CONNECTIONS 1
 #define AP_IP_OCTET 1  // Will create IP 192.168.1.1
+#define AP_JSON_CHUNK_SIZE 512  // network rows per chunk of /api/networks, on the stack
+
+// Web pages (web/, built into include/web_assets.h by tools/build_web.py)
+#define WEB_CACHE_CONTROL "public, max-age=86400"  // then revalidated by ETag
 
 // WiFi Settings
 #define WIFI_SCAN_INTERVAL 10000  // ms
+#define WIFI_SCAN_TIMEOUT 5000    // ms, abandon a scan that never completes
+#define WIFI_CONNECT_TIMEOUT 10000  // ms, give up on a connect that never gets an IP
+#define WIFI_RESTART_DELAY_MS 2000  // after a portal connect, so the page can show it
+#define WIFI_CACHE_NAMESPACE "wifi"     // NVS home of the fast-reconnect cache
+#define WIFI_CACHE_CONNECT_TIMEOUT 3000 // ms for the cached connect before a full one
+#define WIFI_CACHE_STATIC_IP 0          // 1: reuse the cached lease and skip DHCP
 #define MAX_NETWORKS 20
+#define SIGNAL_HISTORY_SLOTS 64   // access points remembered across scans
+#define SIGNAL_HISTORY_WAYS 8     // slots an access point may take, from its hash
+#define SIGNAL_HISTORY_DEPTH 8    // RSSI samples kept for min/max
+#define SIGNAL_HISTORY_EXPIRE 30  // scans unheard before an access point starts over
+#define SIGNAL_EWMA_SHIFT 2       // each sample moves the average 1/4 of the way
+#define WIFI_SWEEP_CHANNELS 13    // AP mode rescans channels 1..N a few at a time
+#define WIFI_SWEEP_BURST 1        // channels scanned back to back per step
+#define WIFI_SWEEP_STEP_MS 750    // between steps; 13 steps make a sweep of ~10 s
+#define WIFI_SWEEP_DWELL_MS 100   // ms per channel
+#define WIFI_SWEEP_PASSIVE false  // listen for beacons instead of probing
+#define WIFI_PORTAL_ACTIVE_MS 15000  // a portal answer this recent means a phone is on it
+#define WIFI_SWEEP_BUSY_BURST 3   // channels per step while it is, right after an answer
 
 // OTA Settings
 #define OTA_PORT 8080
 #define OTA_HOSTNAME "esp32-ota"
 #define OTA_PASSWORD "admin"
+#define OTA_BUFFER_SIZE 4096      // one flash sector per pipeline buffer
+#define OTA_WRITER_STACK 6144      // room for the inflater's Huffman setup
+#define OTA_WRITER_PRIORITY 2
+#define OTA_WRITER_CORE 0         // loop() and the HTTP receive path run on core 1
+#define OTA_INFLATE_WINDOW 32768  // deflate back-reference limit; only allocated for gzip uploads
+#define OTA_INFLATE_FLUSH 4096    // inflated bytes per Update.write(), divides the window
+#define OTA_DELTA_SOURCE_BLOCK 4096  // running-partition read size when applying a delta
+#define OTA_CHUNK_SIZE 16384      // largest PUT /update chunk, staged in RAM until its CRC checks
+#define OTA_SESSION_TIMEOUT 120000  // ms before an abandoned resumable update is dropped
+#define OTA_PROGRESS_INTERVAL_MS 250  // progress events and OLED bar steps while data flows
+#define OTA_EVENT_CLIENTS 2       // GET /update/events listeners; another replaces the oldest
+#define OTA_EVENT_SIZE 128        // one formatted progress event, on the stack
+
+// Image signing (tools/sign_firmware.py). Signed images are always checked
+// against OTA_PUBLIC_KEY_PEM, and unsigned ones are refused unless
+// OTA_REQUIRE_SIGNATURE is 0. No key ships with the source:
+// "tools/sign_firmware.py --new-key" makes one in tools/keys/ (kept out of
+// git) along with the ota_signing_key.h that defines OTA_PUBLIC_KEY_PEM,
+// and the build stops until it exists.
+#ifndef OTA_REQUIRE_SIGNATURE
+#define OTA_REQUIRE_SIGNATURE 1
+#endif
+#define OTA_SIG_TRAILER_SIZE 80
+#if __has_include("ota_signing_key.h")
+#include "ota_signing_key.h"
+#endif
 
 // Display Update Intervals
 #define STATUS_BAR_UPDATE_INTERVAL 1000
@@ -37,5 +113,8 @@
 #define SCREEN_TIMEOUT_OPTIONS {30, 60, 120, 300} // seconds
 #define DEFAULT_BRIGHTNESS 2
 #define DEFAULT_SCREEN_TIMEOUT 60
+#define SETTINGS_NAMESPACE "settings"  // NVS namespace of the settings blob
+#define SETTINGS_VERSION 1             // bump when Settings::Values changes meaning
+#define SETTINGS_COMMIT_DELAY_MS 3000  // quiet time after a change before it is written
 
 #endif
@@ -0,0 +1,303 @@
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include <esp_partition.h>
+#include <functional>
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+#include "crc32.h"
+
+// Rebuilds a new firmware image from the running app partition plus a
+// binary delta made by tools/make_delta.py. The patch is a header followed
+// by bsdiff-style records:
+//
+//   header: "DLT1", source size, source CRC-32, target size, target CRC-32
+//   record: diff length, extra length, source seek (signed)
+//           diff bytes  - added to the source bytes at the current position
+//           extra bytes - copied to the output unchanged
+//
+// All integers are 32-bit little endian. Patch bytes are pushed in with
+// write() in pieces of any size. Source bytes are read from flash one
+// OTA_DELTA_SOURCE_BLOCK at a time, and output goes to the Sink in
+// OTA_BUFFER_SIZE pieces, so the patch never has to fit in RAM.
+class DeltaPatch {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t length)> Sink;
+
+    static bool isPatch(const uint8_t* data, size_t length) {
+        return length >= 4 && data[0] == 'D' && data[1] == 'L' && data[2] == 'T' && data[3] == '1';
+    }
+
+    DeltaPatch(const esp_partition_t* source, Sink output) :
+        partition(source),
+        sink(output),
+        state(STATE_HEADER),
+        error(nullptr),
+        fieldLength(0),
+        sourceBlock(SIZE_MAX),
+        outLength(0),
+        sourcePos(0),
+        produced(0),
+        crc(0) {
+        sourceBuf = new uint8_t[OTA_DELTA_SOURCE_BLOCK];
+        outBuf = new uint8_t[OTA_BUFFER_SIZE];
+    }
+
+    ~DeltaPatch() {
+        delete[] sourceBuf;
+        delete[] outBuf;
+    }
+
+    bool write(const uint8_t* data, size_t length) {
+        while (length > 0 && state != STATE_FAILED) {
+            size_t used;
+            switch (state) {
+                case STATE_HEADER:
+                case STATE_CONTROL: used = readFields(data, length); break;
+                case STATE_DIFF:    used = applyDiff(data, length); break;
+                case STATE_EXTRA:   used = copyExtra(data, length); break;
+                default:            used = 0; fail("data after end of patch"); break;
+            }
+            data += used;
+            length -= used;
+        }
+        return state != STATE_FAILED;
+    }
+
+    // True once the whole target has been produced and its CRC matches
+    bool finish() {
+        if (state == STATE_FAILED) {
+            return false;
+        }
+        if (state != STATE_DONE) {
+            return fail("patch truncated");
+        }
+        if (crc != targetCrc) {
+            return fail("target CRC mismatch");
+        }
+        return true;
+    }
+
+    const char* errorString() {
+        return error ? error : "OK";
+    }
+
+    size_t targetSize() {
+        return targetLength;
+    }
+
+private:
+    enum State {
+        STATE_HEADER,
+        STATE_CONTROL,
+        STATE_DIFF,
+        STATE_EXTRA,
+        STATE_DONE,
+        STATE_FAILED
+    };
+
+    static const size_t HEADER_SIZE = 20;
+    static const size_t CONTROL_SIZE = 12;
+
+    const esp_partition_t* partition;
+    Sink sink;
+    State state;
+    const char* error;
+
+    uint8_t fields[HEADER_SIZE];
+    size_t fieldLength;
+
+    uint8_t* sourceBuf;
+    size_t sourceBlock;  // partition offset held in sourceBuf
+    uint8_t* outBuf;
+    size_t outLength;
+
+    uint32_t sourceLength;
+    uint32_t sourceCrc;
+    uint32_t targetLength;
+    uint32_t targetCrc;
+
+    size_t sourcePos;
+    size_t produced;
+    uint32_t diffLeft;
+    uint32_t extraLeft;
+    int32_t seek;
+    uint32_t crc;
+
+    static uint32_t le32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    bool fail(const char* why) {
+        error = why;
+        state = STATE_FAILED;
+        return false;
+    }
+
+    size_t readFields(const uint8_t* data, size_t length) {
+        size_t need = (state == STATE_HEADER ? HEADER_SIZE : CONTROL_SIZE) - fieldLength;
+        size_t n = length < need ? length : need;
+        memcpy(fields + fieldLength, data, n);
+        fieldLength += n;
+        if (n == need) {
+            fieldLength = 0;
+            if (state == STATE_HEADER) {
+                parseHeader();
+            } else {
+                parseControl();
+            }
+        }
+        return n;
+    }
+
+    void parseHeader() {
+        if (!isPatch(fields, HEADER_SIZE)) {
+            fail("bad magic");
+            return;
+        }
+        sourceLength = le32(fields + 4);
+        sourceCrc = le32(fields + 8);
+        targetLength = le32(fields + 12);
+        targetCrc = le32(fields + 16);
+        if (sourceLength > partition->size) {
+            fail("source larger than partition");
+            return;
+        }
+
+        // Refuse a patch made against a different base image
+        uint32_t actual = 0;
+        for (size_t offset = 0; offset < sourceLength; offset += OTA_DELTA_SOURCE_BLOCK) {
+            size_t n = sourceLength - offset;
+            n = n < OTA_DELTA_SOURCE_BLOCK ? n : OTA_DELTA_SOURCE_BLOCK;
+            if (esp_partition_read(partition, offset, sourceBuf, n) != ESP_OK) {
+                fail("source read failed");
+                return;
+            }
+            actual = crc32Update(actual, sourceBuf, n);
+        }
+        sourceBlock = SIZE_MAX;
+        if (actual != sourceCrc) {
+            fail("running image does not match patch source");
+            return;
+        }
+        state = targetLength == 0 ? STATE_DONE : STATE_CONTROL;
+    }
+
+    void parseControl() {
+        diffLeft = le32(fields);
+        extraLeft = le32(fields + 4);
+        seek = (int32_t)le32(fields + 8);
+        if (diffLeft > sourceLength - sourcePos ||
+            (uint64_t)diffLeft + extraLeft > targetLength - produced) {
+            fail("record out of range");
+            return;
+        }
+        nextState();
+    }
+
+    // Moves on once the current diff or extra run is used up
+    void nextState() {
+        if (diffLeft > 0) {
+            state = STATE_DIFF;
+        } else if (extraLeft > 0) {
+            state = STATE_EXTRA;
+        } else {
+            int64_t pos = (int64_t)sourcePos + seek;
+            if (pos < 0 || pos > (int64_t)sourceLength) {
+                fail("seek out of range");
+                return;
+            }
+            sourcePos = (size_t)pos;
+            if (produced == targetLength) {
+                flushOutput();
+                if (state != STATE_FAILED) {
+                    state = STATE_DONE;
+                }
+            } else {
+                state = STATE_CONTROL;
+            }
+        }
+    }
+
+    // Points at sourcePos inside the cached block, loading it if needed
+    const uint8_t* sourceAt(size_t* available) {
+        size_t block = sourcePos - sourcePos % OTA_DELTA_SOURCE_BLOCK;
+        if (block != sourceBlock) {
+            size_t n = partition->size - block;
+            n = n < OTA_DELTA_SOURCE_BLOCK ? n : OTA_DELTA_SOURCE_BLOCK;
+            if (esp_partition_read(partition, block, sourceBuf, n) != ESP_OK) {
+                fail("source read failed");
+                return nullptr;
+            }
+            sourceBlock = block;
+        }
+        *available = OTA_DELTA_SOURCE_BLOCK - (sourcePos - block);
+        return sourceBuf + (sourcePos - block);
+    }
+
+    size_t applyDiff(const uint8_t* data, size_t length) {
+        size_t used = 0;
+        while (used < length && diffLeft > 0 && state != STATE_FAILED) {
+            size_t available;
+            const uint8_t* source = sourceAt(&available);
+            if (!source) {
+                return used;
+            }
+            size_t n = length - used;
+            n = n < diffLeft ? n : diffLeft;
+            n = n < available ? n : available;
+            n = n < OTA_BUFFER_SIZE - outLength ? n : OTA_BUFFER_SIZE - outLength;
+            uint8_t* out = outBuf + outLength;
+            for (size_t i = 0; i < n; i++) {
+                out[i] = source[i] + data[used + i];
+            }
+            used += n;
+            diffLeft -= n;
+            sourcePos += n;
+            emitted(n);
+        }
+        if (diffLeft == 0 && state == STATE_DIFF) {
+            nextState();
+        }
+        return used;
+    }
+
+    size_t copyExtra(const uint8_t* data, size_t length) {
+        size_t used = 0;
+        while (used < length && extraLeft > 0 && state != STATE_FAILED) {
+            size_t n = length - used;
+            n = n < extraLeft ? n : extraLeft;
+            n = n < OTA_BUFFER_SIZE - outLength ? n : OTA_BUFFER_SIZE - outLength;
+            memcpy(outBuf + outLength, data + used, n);
+            used += n;
+            extraLeft -= n;
+            emitted(n);
+        }
+        if (extraLeft == 0 && state == STATE_EXTRA) {
+            nextState();
+        }
+        return used;
+    }
+
+    void emitted(size_t n) {
+        outLength += n;
+        produced += n;
+        if (outLength == OTA_BUFFER_SIZE) {
+            flushOutput();
+        }
+    }
+
+    void flushOutput() {
+        if (outLength == 0) {
+            return;
+        }
+        crc = crc32Update(crc, outBuf, outLength);
+        if (!sink(outBuf, outLength)) {
+            fail("write failed");
+        }
+        outLength = 0;
+    }
+};
+
+#endif
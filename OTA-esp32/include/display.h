@@ -5,22 +5,48 @@
 #include <Adafruit_SSD1306.h>
 #include <Wire.h>
 #include "config.h"
+#include "display_transport.h"
+#include "list_view.h"
 
+// Draws into the driver's framebuffer; DisplayTransport pushes only what
+// changed, off the calling task, so a highlight move or a clock tick costs
+// a fraction of a full 1 KB frame and never stalls loop().
 class Display {
 private:
     Adafruit_SSD1306* display;
+    DisplayTransport* transport;
+    ListView* list;
     unsigned long lastStatusUpdate;
     unsigned long notificationEndTime;
     bool notificationActive;
     String currentNotification;
     uint8_t brightness;
+    int progress;  // percent on the bar along the bottom edge, -1 when hidden
+
+    // Below the last menu row and left of the scrollbar, so the menu stays
+    // readable and usable while an update runs
+    void drawProgressBar() {
+        const int width = SCREEN_WIDTH - 4;
+        const int top = SCREEN_HEIGHT - 3;
+        display->fillRect(0, top, width, 3, SSD1306_BLACK);
+        if (progress >= 0) {
+            display->drawRect(0, top, width, 3, SSD1306_WHITE);
+            display->fillRect(0, top, width * progress / 100, 3, SSD1306_WHITE);
+        }
+    }
 
 public:
     Display() {
-        display = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+        // Keep the bus at OLED_I2C_CLOCK; the driver would drop it to
+        // 100 kHz after every command
+        display = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET,
+                                       OLED_I2C_CLOCK, OLED_I2C_CLOCK);
+        transport = new DisplayTransport(&Wire, SCREEN_ADDRESS);
+        list = new ListView(display);
         lastStatusUpdate = 0;
         notificationActive = false;
         brightness = DEFAULT_BRIGHTNESS;
+        progress = -1;
     }
 
     bool begin() {
@@ -30,6 +56,7 @@ public:
         display->clearDisplay();
         display->setTextColor(SSD1306_WHITE);
         display->dim(brightness < BRIGHTNESS_LEVELS/2);
+        transport->begin();
         return true;
     }
 
@@ -43,19 +70,21 @@ public:
         display->setTextSize(1);
         display->setCursor(2, 4);
         display->print(message);
-        display->display();
+        list->invalidate(0, max(16, display->getCursorY() + 8));
+        flush();
     }
 
-    void drawStatusBar(const String& wifiStatus, int signalStrength, float cpuTemp) {
+    void drawStatusBar(const char* wifiStatus, int signalStrength, float cpuTemp) {
         if (millis() - lastStatusUpdate < STATUS_BAR_UPDATE_INTERVAL) {
             return;
         }
         
         display->fillRect(0, 0, SCREEN_WIDTH, 8, SSD1306_BLACK);
+        list->invalidate(0, 8);
         display->setTextSize(1);
         
         // WiFi icon and strength (left side)
-        if (wifiStatus != "") {
+        if (wifiStatus[0] != '\0') {
             // Draw WiFi icon (simplified)
             display->drawPixel(2, 6, SSD1306_WHITE);
             display->drawLine(0, 4, 4, 4, SSD1306_WHITE);
@@ -81,55 +110,92 @@ public:
         display->print(cpuTemp, 0);
         display->print("C");
         
-        display->display();
+        flush();
         lastStatusUpdate = millis();
     }
 
-    void drawMenu(const char* title, const char** items, int itemCount, int selectedIndex) {
-        display->clearDisplay();
-        
-        // Draw title
-        display->setTextSize(1);
-        display->setCursor(0, 0);
-        display->print(title);
-        display->drawLine(0, 9, SCREEN_WIDTH-1, 9, SSD1306_WHITE);
-
-        // Draw menu items
-        for(int i = 0; i < itemCount && i < 6; i++) {
-            display->setCursor(2, 12 + i*8);
-            if(i == selectedIndex) {
-                display->fillRect(0, 11 + i*8, SCREEN_WIDTH, 9, SSD1306_WHITE);
-                display->setTextColor(SSD1306_BLACK);
-                display->print(items[i]);
-                display->setTextColor(SSD1306_WHITE);
-            } else {
-                display->print(items[i]);
-            }
-        }
-        
-        // Draw scrollbar if needed
-        if(itemCount > 6) {
-            display->drawRect(SCREEN_WIDTH-3, 11, 3, 53, SSD1306_WHITE);
-            int scrollHeight = 53 * (6.0/itemCount);
-            int scrollPos = 11 + (53-scrollHeight) * (selectedIndex/(itemCount-1.0));
-            display->fillRect(SCREEN_WIDTH-3, scrollPos, 3, scrollHeight, SSD1306_WHITE);
+    // A list of itemCount rows under title, selected highlighted (-1 for
+    // none) and scrolled into view; see ListView. Only rows that changed
+    // are drawn, and nothing is sent when none did.
+    void drawList(const char* title, int itemCount, int selected,
+                  const ListView::RowProvider& rows) {
+        if (list->show(title, itemCount, selected, rows)) {
+            flush();
         }
-        
-        display->display();
+    }
+
+    // The list shown next starts at its top
+    void resetList() {
+        list->reset();
+    }
+
+    // Scrolls a list without a highlight; false at its end
+    bool scrollList(int delta) {
+        return list->scroll(delta);
+    }
+
+    int listFirstRow() {
+        return list->firstRow();
+    }
+
+    unsigned long listRowsDrawn() {
+        return list->rowsDrawn();
     }
 
     void setBrightness(uint8_t level) {
         brightness = level;
+        transport->lockBus();
         display->dim(brightness < BRIGHTNESS_LEVELS/2);
+        transport->unlockBus();
     }
 
     void clear() {
         display->clearDisplay();
-        display->display();
+        list->invalidate(0, SCREEN_HEIGHT);
+        drawProgressBar();
+        flush();
+    }
+
+    // Only the bar's columns on the last page go out; -1 hides it
+    void showProgress(int percent) {
+        if (percent == progress) {
+            return;
+        }
+        progress = percent;
+        drawProgressBar();
+        flush();
+    }
+
+    int progressShown() {
+        return progress;
+    }
+
+    // Hands the framebuffer to the transport; returns before it is on the bus
+    void flush() {
+        transport->submit(display->getBuffer());
+    }
+
+    // Blocks until everything drawn so far has reached the panel
+    void sync() {
+        transport->sync();
+    }
+
+    unsigned long frameTimeUs() {
+        return transport->frameTimeUs();
+    }
+
+    unsigned long latencyTimeUs() {
+        return transport->latencyTimeUs();
+    }
+
+    unsigned long shownAtUs() {
+        return transport->shownAtUs();
     }
 
     ~Display() {
+        delete list;
         delete display;
+        delete transport;
     }
 };
 
@@ -0,0 +1,272 @@
+#ifndef DISPLAY_TRANSPORT_H
+#define DISPLAY_TRANSPORT_H
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+#include <atomic>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "config.h"
+
+// Moves SSD1306 frames over I2C. submit() copies the frame and returns; a
+// background task diffs it against a shadow of what the panel shows and
+// sends only the changed column runs, each through a PAGEADDR/COLUMNADDR
+// window, with pixel data packed into transactions as large as the Wire
+// buffer. Runs with the same columns on adjacent pages share one window.
+// Frames are handed over through a lock-free triple buffer, so submit()
+// never waits for the task, and frames submitted while one is still on
+// the bus are coalesced: the task always sends the latest. With
+// OLED_ASYNC_FLUSH 0 the same work runs inline in submit().
+class DisplayTransport {
+private:
+    static const int PAGES = (SCREEN_HEIGHT + 7) / 8;
+    static const int FRAME_SIZE = SCREEN_WIDTH * PAGES;
+    static const int MAX_RUNS = SCREEN_WIDTH / (OLED_DIRTY_GAP + 2) + 1;
+    static const uint8_t FRESH = 0x80;  // set on the handover slot by submit()
+
+    struct Run {
+        uint8_t startCol;
+        uint8_t endCol;
+    };
+
+    TwoWire* wire;
+    uint8_t address;
+    uint8_t* shadow;     // what the panel shows, owned by the sender
+    uint8_t* frames[3];  // being filled, handed over, being sent
+    unsigned long submitTime[3];
+    unsigned long sequence[3];
+    uint8_t fillIndex;   // owned by submit()
+    uint8_t sendIndex;   // owned by the sender
+    std::atomic<uint8_t> handover;
+    bool shadowValid;
+    SemaphoreHandle_t busLock;
+    SemaphoreHandle_t frameDone;
+    TaskHandle_t task;
+    volatile unsigned long submitted;
+    volatile unsigned long shown;
+    volatile unsigned long frameUs;
+    volatile unsigned long latencyUs;
+    volatile unsigned long shownUs;
+
+    static void taskLoop(void* arg) {
+        static_cast<DisplayTransport*>(arg)->run();
+    }
+
+    void run() {
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (!(handover.load() & FRESH)) {
+                continue;
+            }
+            sendIndex = handover.exchange(sendIndex) & ~FRESH;
+            transmit();
+            shown = sequence[sendIndex];
+            xSemaphoreGive(frameDone);
+        }
+    }
+
+    void transmit() {
+        xSemaphoreTake(busLock, portMAX_DELAY);
+        unsigned long start = micros();
+        sendChanges();
+        unsigned long end = micros();
+        xSemaphoreGive(busLock);
+        frameUs = end - start;
+        latencyUs = end - submitTime[sendIndex];
+        shownUs = end;
+    }
+
+    void sendChanges() {
+        if (!shadowValid) {
+            // Nothing to diff against yet
+            sendWindow(0, PAGES - 1, 0, SCREEN_WIDTH - 1);
+            shadowValid = true;
+            return;
+        }
+
+        Run runs[PAGES][MAX_RUNS];
+        int counts[PAGES];
+        for (int page = 0; page < PAGES; page++) {
+            counts[page] = findRuns(page, runs[page]);
+        }
+        for (int page = 0; page < PAGES; page++) {
+            for (int i = 0; i < counts[page]; i++) {
+                Run run = runs[page][i];
+                int last = page;
+                while (counts[page] == 1 && last + 1 < PAGES && counts[last + 1] == 1 &&
+                       runs[last + 1][0].startCol == run.startCol &&
+                       runs[last + 1][0].endCol == run.endCol) {
+                    counts[++last] = 0;
+                }
+                sendWindow(page, last, run.startCol, run.endCol);
+            }
+        }
+    }
+
+    // Changed column runs on one page. A run extends across short unchanged
+    // gaps, since a new window costs more than resending a few bytes.
+    int findRuns(int page, Run* runs) {
+        const uint8_t* row = frames[sendIndex] + page * SCREEN_WIDTH;
+        const uint8_t* panel = shadow + page * SCREEN_WIDTH;
+        int count = 0;
+        int col = 0;
+        while (col < SCREEN_WIDTH) {
+            if (row[col] == panel[col]) {
+                col++;
+                continue;
+            }
+            int end = col;
+            for (int next = col + 1; next < SCREEN_WIDTH && next - end <= OLED_DIRTY_GAP; next++) {
+                if (row[next] != panel[next]) {
+                    end = next;
+                }
+            }
+            runs[count].startCol = col;
+            runs[count].endCol = end;
+            count++;
+            col = end + 1;
+        }
+        return count;
+    }
+
+    // One command transaction for the window, then its pixels streamed in
+    // transactions filled to the Wire buffer
+    void sendWindow(int firstPage, int lastPage, int startCol, int endCol) {
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x00);
+        wire->write((uint8_t)SSD1306_PAGEADDR);
+        wire->write((uint8_t)firstPage);
+        wire->write((uint8_t)lastPage);
+        wire->write((uint8_t)SSD1306_COLUMNADDR);
+        wire->write((uint8_t)startCol);
+        wire->write((uint8_t)endCol);
+        wire->endTransmission();
+
+        size_t width = endCol - startCol + 1;
+        size_t room = 0;
+        bool open = false;
+        for (int page = firstPage; page <= lastPage; page++) {
+            const uint8_t* data = frames[sendIndex] + page * SCREEN_WIDTH + startCol;
+            memcpy(shadow + page * SCREEN_WIDTH + startCol, data, width);
+            size_t remaining = width;
+            while (remaining > 0) {
+                if (room == 0) {
+                    if (open) {
+                        wire->endTransmission();
+                    }
+                    open = true;
+                    wire->beginTransmission(address);
+                    wire->write((uint8_t)0x40);
+                    room = I2C_BUFFER_LENGTH - 1;
+                }
+                size_t n = min(remaining, room);
+                wire->write(data, n);
+                data += n;
+                remaining -= n;
+                room -= n;
+            }
+        }
+        wire->endTransmission();
+    }
+
+public:
+    DisplayTransport(TwoWire* twi, uint8_t i2cAddress) :
+        wire(twi),
+        address(i2cAddress),
+        fillIndex(0),
+        sendIndex(1),
+        handover(2),
+        shadowValid(false),
+        task(nullptr),
+        submitted(0),
+        shown(0),
+        frameUs(0),
+        latencyUs(0),
+        shownUs(0) {
+        shadow = new uint8_t[FRAME_SIZE];
+        for (int i = 0; i < 3; i++) {
+            frames[i] = new uint8_t[FRAME_SIZE];
+            submitTime[i] = 0;
+            sequence[i] = 0;
+        }
+        busLock = xSemaphoreCreateMutex();
+        frameDone = xSemaphoreCreateBinary();
+    }
+
+    ~DisplayTransport() {
+        if (task) {
+            vTaskDelete(task);
+        }
+        vSemaphoreDelete(busLock);
+        vSemaphoreDelete(frameDone);
+        delete[] shadow;
+        for (int i = 0; i < 3; i++) {
+            delete[] frames[i];
+        }
+    }
+
+    void begin() {
+#if OLED_ASYNC_FLUSH
+        if (!task) {
+            xTaskCreatePinnedToCore(taskLoop, "oled_flush", OLED_TASK_STACK, this,
+                                    OLED_TASK_PRIORITY, &task, OLED_TASK_CORE);
+        }
+#endif
+    }
+
+    // Hands a frame over for sending; never waits for the bus
+    void submit(const uint8_t* frame) {
+        memcpy(frames[fillIndex], frame, FRAME_SIZE);
+        submitTime[fillIndex] = micros();
+        sequence[fillIndex] = submitted + 1;
+#if OLED_ASYNC_FLUSH
+        fillIndex = handover.exchange(fillIndex | FRESH) & ~FRESH;
+        submitted++;
+        if (task) {
+            xTaskNotifyGive(task);
+        }
+#else
+        uint8_t filled = fillIndex;
+        fillIndex = sendIndex;
+        sendIndex = filled;
+        transmit();
+        submitted++;
+        shown = submitted;
+#endif
+    }
+
+    // Waits until every submitted frame is on the panel
+    void sync() {
+        while (shown != submitted) {
+            xSemaphoreTake(frameDone, portMAX_DELAY);
+        }
+    }
+
+    // Serialises other traffic (contrast, power) with frame pushes
+    void lockBus() {
+        xSemaphoreTake(busLock, portMAX_DELAY);
+    }
+
+    void unlockBus() {
+        xSemaphoreGive(busLock);
+    }
+
+    // Bus time of the last frame sent
+    unsigned long frameTimeUs() {
+        return frameUs;
+    }
+
+    // From submit() of the last frame sent to its last byte on the bus
+    unsigned long latencyTimeUs() {
+        return latencyUs;
+    }
+
+    // micros() when the last frame sent was complete on the panel
+    unsigned long shownAtUs() {
+        return shownUs;
+    }
+};
+
+#endif
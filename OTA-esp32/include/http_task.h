@@ -0,0 +1,80 @@
+#ifndef HTTP_TASK_H
+#define HTTP_TASK_H
+
+#include <Arduino.h>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "config.h"
+
+// Runs one web server's polling on a task of its own, so a request that
+// takes seconds (an upload, a blocking handler) holds up only that server:
+// the other port and loop() keep going. The work function calls the
+// server's handleClient() plus anything that must not race its handlers.
+// Between polls the task sleeps HTTP_POLL_MS, or until stop() wakes it.
+// With HTTP_SERVER_TASKS 0 nothing is started and loop() calls poll().
+class HttpTask {
+public:
+    typedef std::function<void()> Work;
+
+    HttpTask(const char* taskName, Work work) :
+        name(taskName),
+        work(work),
+        task(nullptr),
+        stopping(false) {
+        stopped = xSemaphoreCreateBinary();
+    }
+
+    ~HttpTask() {
+        stop();
+        vSemaphoreDelete(stopped);
+    }
+
+    void start() {
+#if HTTP_SERVER_TASKS
+        if (!task) {
+            stopping = false;
+            xTaskCreatePinnedToCore(taskLoop, name, HTTP_TASK_STACK, this, HTTP_TASK_PRIORITY,
+                                    &task, HTTP_TASK_CORE);
+        }
+#endif
+    }
+
+    // Waits for the request in progress, if any, to finish
+    void stop() {
+        if (!task) {
+            return;
+        }
+        stopping = true;
+        xTaskNotifyGive(task);
+        xSemaphoreTake(stopped, portMAX_DELAY);
+        task = nullptr;
+    }
+
+    // Inline polling for HTTP_SERVER_TASKS 0; does nothing otherwise
+    void poll() {
+#if !HTTP_SERVER_TASKS
+        work();
+#endif
+    }
+
+private:
+    const char* name;
+    Work work;
+    TaskHandle_t task;
+    volatile bool stopping;
+    SemaphoreHandle_t stopped;
+
+    static void taskLoop(void* arg) {
+        HttpTask* self = static_cast<HttpTask*>(arg);
+        while (!self->stopping) {
+            self->work();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HTTP_POLL_MS));
+        }
+        xSemaphoreGive(self->stopped);
+        vTaskDelete(NULL);
+    }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef IMAGE_VERIFIER_H
+#define IMAGE_VERIFIER_H
+
+#include <functional>
+#include <mbedtls/pk.h>
+#include <mbedtls/sha256.h>
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+
+#ifndef OTA_PUBLIC_KEY_PEM
+#error "No OTA signing key: run tools/sign_firmware.py --new-key"
+#endif
+
+// Authenticates an OTA image while it streams to flash. A signed image is
+// the firmware followed by a trailer made by tools/sign_firmware.py:
+//
+//   "OSG1", DER signature length (16-bit LE), 2 reserved bytes,
+//   ECDSA P-256 signature over SHA-256(firmware), zero padded to 72 bytes
+//
+// The last OTA_SIG_TRAILER_SIZE bytes are held back in a delay line, so the
+// trailer never reaches flash. Everything before it is hashed on its way
+// to the Sink, and finish() checks the signature before Update.end().
+class ImageVerifier {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t length)> Sink;
+
+    enum Result {
+        VERIFY_OK,
+        VERIFY_UNSIGNED,
+        VERIFY_BAD_SIGNATURE,
+        VERIFY_BAD_KEY
+    };
+
+    ImageVerifier() : held(0) {
+        mbedtls_sha256_init(&sha);
+    }
+
+    ~ImageVerifier() {
+        mbedtls_sha256_free(&sha);
+    }
+
+    void begin(Sink output) {
+        sink = output;
+        held = 0;
+        mbedtls_sha256_starts_ret(&sha, 0);
+    }
+
+    bool write(const uint8_t* data, size_t length) {
+        if (held + length <= OTA_SIG_TRAILER_SIZE) {
+            memcpy(tail + held, data, length);
+            held += length;
+            return true;
+        }
+        // Release whatever no longer fits in the delay line, oldest first
+        size_t release = held + length - OTA_SIG_TRAILER_SIZE;
+        size_t fromTail = release < held ? release : held;
+        if (fromTail > 0) {
+            if (!emit(tail, fromTail)) {
+                return false;
+            }
+            memmove(tail, tail + fromTail, held - fromTail);
+            held -= fromTail;
+        }
+        size_t fromData = release - fromTail;
+        if (fromData > 0 && !emit(data, fromData)) {
+            return false;
+        }
+        memcpy(tail + held, data + fromData, length - fromData);
+        held += length - fromData;
+        return true;
+    }
+
+    // Flushes an unsigned image's last bytes, or checks the signature
+    Result finish() {
+        if (held < OTA_SIG_TRAILER_SIZE || memcmp(tail, "OSG1", 4) != 0) {
+            emit(tail, held);
+            held = 0;
+            return VERIFY_UNSIGNED;
+        }
+        uint8_t hash[32];
+        mbedtls_sha256_finish_ret(&sha, hash);
+        size_t sigLength = tail[4] | (tail[5] << 8);
+        if (sigLength > OTA_SIG_TRAILER_SIZE - 8) {
+            return VERIFY_BAD_SIGNATURE;
+        }
+
+        mbedtls_pk_context pk;
+        mbedtls_pk_init(&pk);
+        Result result = VERIFY_OK;
+        const char* key = OTA_PUBLIC_KEY_PEM;
+        if (mbedtls_pk_parse_public_key(&pk, (const unsigned char*)key, strlen(key) + 1) != 0) {
+            result = VERIFY_BAD_KEY;
+        } else if (mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, hash, sizeof(hash), tail + 8,
+                                     sigLength) != 0) {
+            result = VERIFY_BAD_SIGNATURE;
+        }
+        mbedtls_pk_free(&pk);
+        return result;
+    }
+
+    static const char* resultString(Result result) {
+        switch (result) {
+            case VERIFY_OK:            return "signature OK";
+            case VERIFY_UNSIGNED:      return "image is not signed";
+            case VERIFY_BAD_SIGNATURE: return "signature check failed";
+            default:                   return "public key invalid";
+        }
+    }
+
+private:
+    mbedtls_sha256_context sha;
+    Sink sink;
+    uint8_t tail[OTA_SIG_TRAILER_SIZE];
+    size_t held;
+
+    bool emit(const uint8_t* data, size_t length) {
+        mbedtls_sha256_update_ret(&sha, data, length);
+        return sink(data, length);
+    }
+};
+
+#endif
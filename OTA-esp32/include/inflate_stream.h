@@ -0,0 +1,418 @@
+#ifndef INFLATE_STREAM_H
+#define INFLATE_STREAM_H
+
+#include <functional>
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+#include "crc32.h"
+
+// Streaming gzip decoder (RFC 1951/1952) for OTA uploads. Input arrives in
+// blocks pulled from a Source as the decoder needs them; output is pushed
+// to a Sink from a single OTA_INFLATE_WINDOW ring that doubles as the
+// back-reference window, so memory stays bounded no matter how large the
+// image is. Output is flushed every OTA_INFLATE_FLUSH bytes so flash
+// programming keeps pace with the network instead of bursting per
+// window. The gzip CRC-32 and length trailer are verified at the end.
+class InflateStream {
+public:
+    // Hands out the next input block; returns false at end of input
+    typedef std::function<bool(const uint8_t** data, size_t* length)> Source;
+    // Consumes decoded output; returns false to abort
+    typedef std::function<bool(const uint8_t* data, size_t length)> Sink;
+
+    static bool isGzip(const uint8_t* data, size_t length) {
+        return length >= 2 && data[0] == 0x1F && data[1] == 0x8B;
+    }
+
+    InflateStream() : window(nullptr) {}
+
+    ~InflateStream() {
+        delete[] window;
+    }
+
+    // Decodes one gzip member starting with the block in data/length
+    bool run(const uint8_t* data, size_t length, Source nextBlock, Sink output) {
+        if (!window) {
+            window = new uint8_t[OTA_INFLATE_WINDOW];
+        }
+        in = data;
+        inLength = length;
+        source = nextBlock;
+        sink = output;
+        bitBuffer = 0;
+        bitCount = 0;
+        windowPos = 0;
+        flushedPos = 0;
+        outTotal = 0;
+        crc = 0;
+        failed = false;
+        fixedBuilt = false;
+
+        if (!readHeader()) {
+            return false;
+        }
+
+        int last;
+        do {
+            last = bits(1);
+            int type = bits(2);
+            bool ok;
+            switch (type) {
+                case 0: ok = stored(); break;
+                case 1: ok = fixed(); break;
+                case 2: ok = dynamic(); break;
+                default: ok = false; break;
+            }
+            if (!ok || failed) {
+                return false;
+            }
+        } while (!last);
+
+        flushWindow();
+        if (failed) {
+            return false;
+        }
+
+        // Trailer is byte aligned: CRC-32 then ISIZE, both little endian
+        bitBuffer = 0;
+        bitCount = 0;
+        uint32_t expectedCrc = readLE32();
+        uint32_t expectedSize = readLE32();
+        return !failed && expectedCrc == crc && expectedSize == (uint32_t)outTotal;
+    }
+
+    size_t outputSize() {
+        return outTotal;
+    }
+
+private:
+    struct Huffman {
+        uint16_t count[16];   // number of codes of each length
+        uint16_t symbol[288]; // symbols ordered by code
+    };
+
+    uint8_t* window;
+    size_t windowPos;
+    size_t flushedPos;
+    size_t outTotal;
+    uint32_t crc;
+
+    const uint8_t* in;
+    size_t inLength;
+    Source source;
+    Sink sink;
+    uint32_t bitBuffer;
+    int bitCount;
+    bool failed;
+
+    Huffman lencode;
+    Huffman distcode;
+    bool fixedBuilt;
+
+    uint8_t nextByte() {
+        while (inLength == 0) {
+            if (failed || !source(&in, &inLength)) {
+                failed = true;  // stream ended early
+                return 0;
+            }
+        }
+        inLength--;
+        return *in++;
+    }
+
+    uint32_t readLE32() {
+        uint32_t v = nextByte();
+        v |= (uint32_t)nextByte() << 8;
+        v |= (uint32_t)nextByte() << 16;
+        v |= (uint32_t)nextByte() << 24;
+        return v;
+    }
+
+    uint32_t bits(int need) {
+        uint32_t val = bitBuffer;
+        while (bitCount < need) {
+            val |= (uint32_t)nextByte() << bitCount;
+            bitCount += 8;
+        }
+        bitBuffer = val >> need;
+        bitCount -= need;
+        return val & ((1UL << need) - 1);
+    }
+
+    bool readHeader() {
+        if (nextByte() != 0x1F || nextByte() != 0x8B || nextByte() != 8) {
+            return false;  // not gzip, or not deflate
+        }
+        uint8_t flags = nextByte();
+        for (int i = 0; i < 6; i++) {
+            nextByte();  // MTIME, XFL, OS
+        }
+        if (flags & 0xE0) {
+            return false;
+        }
+        if (flags & 0x04) {  // FEXTRA
+            uint16_t extra = nextByte();
+            extra |= nextByte() << 8;
+            while (extra-- && !failed) {
+                nextByte();
+            }
+        }
+        if (flags & 0x08) {  // FNAME
+            while (nextByte() != 0 && !failed) {
+            }
+        }
+        if (flags & 0x10) {  // FCOMMENT
+            while (nextByte() != 0 && !failed) {
+            }
+        }
+        if (flags & 0x02) {  // FHCRC
+            nextByte();
+            nextByte();
+        }
+        return !failed;
+    }
+
+    void flushWindow() {
+        size_t n = windowPos - flushedPos;
+        if (n > 0) {
+            crc = crc32Update(crc, window + flushedPos, n);
+            if (!sink(window + flushedPos, n)) {
+                failed = true;
+            }
+        }
+        flushedPos = windowPos;
+        if (windowPos == OTA_INFLATE_WINDOW) {
+            windowPos = flushedPos = 0;
+        }
+    }
+
+    void put(uint8_t b) {
+        window[windowPos++] = b;
+        outTotal++;
+        if (windowPos - flushedPos == OTA_INFLATE_FLUSH) {
+            flushWindow();
+        }
+    }
+
+    bool stored() {
+        // Discard the rest of the current byte
+        bitBuffer = 0;
+        bitCount = 0;
+        uint16_t len = nextByte();
+        len |= nextByte() << 8;
+        uint16_t nlen = nextByte();
+        nlen |= nextByte() << 8;
+        if (len != (uint16_t)~nlen) {
+            return false;
+        }
+        while (len > 0 && !failed) {
+            if (inLength == 0) {
+                nextByte();  // refill
+                in--;
+                inLength++;
+                if (failed) {
+                    return false;
+                }
+            }
+            // Copy straight from the input block, up to the next flush point
+            size_t room = OTA_INFLATE_FLUSH - (windowPos - flushedPos);
+            size_t n = len;
+            n = n < inLength ? n : inLength;
+            n = n < room ? n : room;
+            memcpy(window + windowPos, in, n);
+            in += n;
+            inLength -= n;
+            len -= n;
+            windowPos += n;
+            outTotal += n;
+            if (windowPos - flushedPos == OTA_INFLATE_FLUSH) {
+                flushWindow();
+            }
+        }
+        return !failed;
+    }
+
+    int decode(const Huffman& h) {
+        int code = 0;   // bits read so far
+        int first = 0;  // first code of this length
+        int index = 0;  // index of the first code of this length in symbol[]
+        for (int len = 1; len <= 15; len++) {
+            code |= bits(1);
+            int count = h.count[len];
+            if (code - count < first) {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        failed = true;  // ran out of codes
+        return -1;
+    }
+
+    // Returns 0 for a complete code, > 0 for incomplete, < 0 if oversubscribed
+    static int construct(Huffman& h, const uint8_t* length, int n) {
+        for (int len = 0; len <= 15; len++) {
+            h.count[len] = 0;
+        }
+        for (int sym = 0; sym < n; sym++) {
+            h.count[length[sym]]++;
+        }
+        if (h.count[0] == n) {
+            return 0;
+        }
+        int left = 1;
+        for (int len = 1; len <= 15; len++) {
+            left <<= 1;
+            left -= h.count[len];
+            if (left < 0) {
+                return left;
+            }
+        }
+        uint16_t offs[16];
+        offs[1] = 0;
+        for (int len = 1; len < 15; len++) {
+            offs[len + 1] = offs[len] + h.count[len];
+        }
+        for (int sym = 0; sym < n; sym++) {
+            if (length[sym] != 0) {
+                h.symbol[offs[length[sym]]++] = sym;
+            }
+        }
+        return left;
+    }
+
+    bool codes() {
+        static const uint16_t lbase[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t lext[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const uint16_t dbase[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+            8193, 12289, 16385, 24577};
+        static const uint8_t dext[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        int symbol;
+        do {
+            symbol = decode(lencode);
+            if (symbol < 0 || failed) {
+                return false;
+            }
+            if (symbol < 256) {
+                put(symbol);
+            } else if (symbol > 256) {
+                symbol -= 257;
+                if (symbol >= 29) {
+                    return false;
+                }
+                size_t len = lbase[symbol] + bits(lext[symbol]);
+                symbol = decode(distcode);
+                if (symbol < 0 || symbol >= 30) {
+                    return false;
+                }
+                size_t dist = dbase[symbol] + bits(dext[symbol]);
+                if (dist > outTotal || dist > OTA_INFLATE_WINDOW) {
+                    return false;  // reaches before the start of the output
+                }
+                while (len--) {
+                    put(window[(windowPos + OTA_INFLATE_WINDOW - dist) % OTA_INFLATE_WINDOW]);
+                }
+            }
+        } while (symbol != 256 && !failed);
+        return !failed;
+    }
+
+    bool fixed() {
+        if (!fixedBuilt) {
+            uint8_t lengths[288];
+            int sym = 0;
+            for (; sym < 144; sym++) lengths[sym] = 8;
+            for (; sym < 256; sym++) lengths[sym] = 9;
+            for (; sym < 280; sym++) lengths[sym] = 7;
+            for (; sym < 288; sym++) lengths[sym] = 8;
+            construct(lencode, lengths, 288);
+            for (sym = 0; sym < 30; sym++) lengths[sym] = 5;
+            construct(distcode, lengths, 30);
+            fixedBuilt = true;
+        }
+        return codes();
+    }
+
+    bool dynamic() {
+        static const uint8_t order[19] = {
+            16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        uint8_t lengths[286 + 30];
+
+        fixedBuilt = false;  // lencode/distcode get overwritten below
+        int nlen = bits(5) + 257;
+        int ndist = bits(5) + 1;
+        int ncode = bits(4) + 4;
+        if (nlen > 286 || ndist > 30) {
+            return false;
+        }
+
+        int index;
+        for (index = 0; index < ncode; index++) {
+            lengths[order[index]] = bits(3);
+        }
+        for (; index < 19; index++) {
+            lengths[order[index]] = 0;
+        }
+        if (construct(lencode, lengths, 19) != 0) {
+            return false;
+        }
+
+        index = 0;
+        while (index < nlen + ndist) {
+            int symbol = decode(lencode);
+            if (symbol < 0 || failed) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[index++] = symbol;
+            } else {
+                uint8_t len = 0;
+                if (symbol == 16) {
+                    if (index == 0) {
+                        return false;
+                    }
+                    len = lengths[index - 1];
+                    symbol = 3 + bits(2);
+                } else if (symbol == 17) {
+                    symbol = 3 + bits(3);
+                } else {
+                    symbol = 11 + bits(7);
+                }
+                if (index + symbol > nlen + ndist) {
+                    return false;
+                }
+                while (symbol--) {
+                    lengths[index++] = len;
+                }
+            }
+        }
+        if (lengths[256] == 0) {
+            return false;  // no end-of-block code
+        }
+
+        // Incomplete codes are only allowed for a single length
+        int err = construct(lencode, lengths, nlen);
+        if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1)) {
+            return false;
+        }
+        err = construct(distcode, lengths + nlen, ndist);
+        if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1)) {
+            return false;
+        }
+        return codes();
+    }
+};
+
+#endif
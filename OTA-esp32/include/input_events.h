@@ -0,0 +1,178 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+enum InputButton {
+    BTN_UP,
+    BTN_DOWN,
+    BTN_SELECT,
+    BTN_COUNT
+};
+
+enum InputAction {
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_SELECT,
+    ACTION_BACK
+};
+
+// Button input in two halves. The pin ISRs call edge() to drop contact
+// bounce per button and post what is left, timestamped, to the UI task's
+// queue; nothing is ever coalesced or shared between pins. The UI task
+// feeds each edge to apply() and calls poll() whenever nextTimer() comes
+// due, which together turn edges into actions:
+//
+//   UP/DOWN   on press, then repeated every INPUT_REPEAT_INTERVAL_MS once
+//             held for INPUT_REPEAT_DELAY_MS
+//   SELECT    on release; held for INPUT_LONG_PRESS_MS it is BACK instead
+class InputEvents {
+public:
+    struct Event {
+        InputAction action;
+        bool repeat;
+        unsigned long time;  // millis() of the edge or timer behind it
+    };
+
+    InputEvents() : dropped(0) {
+        for (int i = 0; i < BTN_COUNT; i++) {
+            lastEdge[i] = 0;
+            held[i] = false;
+            changedAt[i] = 0;
+            nextRepeat[i] = 0;
+            longSent[i] = false;
+        }
+    }
+
+    // ISR side: false for contact bounce, which poll() settles later
+    bool IRAM_ATTR edge(uint8_t button, unsigned long now) {
+        if (now - lastEdge[button] < INPUT_DEBOUNCE_MS) {
+            return false;
+        }
+        lastEdge[button] = now;
+        return true;
+    }
+
+    // ISR side: the edge did not fit in the UI queue
+    void IRAM_ATTR dropEdge() {
+        dropped++;
+    }
+
+    // UI side: one edge off the queue; true when it makes an action
+    bool apply(uint8_t button, bool pressed, unsigned long time, Event* event) {
+        if (pressed == held[button]) {
+            return false;
+        }
+        held[button] = pressed;
+        changedAt[button] = time;
+        if (pressed) {
+            longSent[button] = false;
+            nextRepeat[button] = time + INPUT_REPEAT_DELAY_MS;
+            if (button == BTN_SELECT) {
+                return false;  // wait to tell a click from a long press
+            }
+            return emit(button == BTN_UP ? ACTION_UP : ACTION_DOWN, false, time, event);
+        }
+        if (button == BTN_SELECT && !longSent[button]) {
+            return emit(ACTION_SELECT, false, time, event);
+        }
+        return false;
+    }
+
+    // UI side: returns one timed action at a time, false when none is due
+    bool poll(Event* event) {
+        unsigned long now = millis();
+        for (uint8_t button = 0; button < BTN_COUNT; button++) {
+            if (pollButton(button, now, event)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // UI side: ms until poll() may have something to do, -1 when nothing
+    // is pending, so the UI task can block on its queue until then
+    long nextTimer() {
+        unsigned long now = millis();
+        long wait = -1;
+        for (uint8_t button = 0; button < BTN_COUNT; button++) {
+            if (now - changedAt[button] < INPUT_DEBOUNCE_MS) {
+                wait = sooner(wait, changedAt[button] + INPUT_DEBOUNCE_MS - now);
+            }
+            if (!held[button]) {
+                continue;
+            }
+            if (button != BTN_SELECT) {
+                wait = sooner(wait, nextRepeat[button] - now);
+            } else if (!longSent[button]) {
+                wait = sooner(wait, changedAt[button] + INPUT_LONG_PRESS_MS - now);
+            }
+        }
+        return wait;
+    }
+
+    // Edges lost to a full UI queue since boot
+    unsigned long droppedEdges() {
+        return dropped;
+    }
+
+private:
+    // Written by the ISRs only
+    volatile unsigned long dropped;
+    unsigned long lastEdge[BTN_COUNT];
+
+    // Written by the UI task only
+    bool held[BTN_COUNT];
+    unsigned long changedAt[BTN_COUNT];
+    unsigned long nextRepeat[BTN_COUNT];
+    bool longSent[BTN_COUNT];
+
+    static uint8_t pinOf(uint8_t button) {
+        switch (button) {
+            case BTN_UP:   return BUTTON_UP;
+            case BTN_DOWN: return BUTTON_DOWN;
+            default:       return BUTTON_SELECT;
+        }
+    }
+
+    static long sooner(long wait, unsigned long due) {
+        long ms = (long)due < 0 ? 0 : (long)due;
+        return (wait < 0 || ms < wait) ? ms : wait;
+    }
+
+    bool pollButton(uint8_t button, unsigned long now, Event* event) {
+        // An edge inside the debounce window was ignored; once the window
+        // has passed, the pin level is the truth
+        bool level = digitalRead(pinOf(button)) == LOW;
+        if (level != held[button] && now - changedAt[button] >= INPUT_DEBOUNCE_MS) {
+            return apply(button, level, now, event);
+        }
+        if (!held[button]) {
+            return false;
+        }
+        if (button == BTN_SELECT) {
+            if (!longSent[button] && now - changedAt[button] >= INPUT_LONG_PRESS_MS) {
+                longSent[button] = true;
+                return emit(ACTION_BACK, false, now, event);
+            }
+            return false;
+        }
+        if ((long)(now - nextRepeat[button]) >= 0) {
+            // From now, not from the last deadline: a stalled UI task must
+            // not come back to a burst of repeats
+            nextRepeat[button] = now + INPUT_REPEAT_INTERVAL_MS;
+            return emit(button == BTN_UP ? ACTION_UP : ACTION_DOWN, true, now, event);
+        }
+        return false;
+    }
+
+    static bool emit(InputAction action, bool repeat, unsigned long time, Event* event) {
+        event->action = action;
+        event->repeat = repeat;
+        event->time = time;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <Adafruit_SSD1306.h>
+#include <functional>
+#include "config.h"
+
+// The menu list on the OLED: a title over a window of MENU_VISIBLE_ROWS
+// rows onto a list of any length. Rows are asked for only while they are
+// in the window, and a row is drawn again only when its text or highlight
+// differs from what the framebuffer already holds, so moving the highlight
+// redraws two or three rows and scrolling formats one window's worth.
+// Anything else drawn over the list must say so through invalidate().
+//
+// Row i spans y = 12 + 8i to 19 + 8i; its highlight starts one line
+// higher, over the descenders of the row above, as it always has. That
+// shared line is why a change to one row can mean redrawing a neighbour.
+class ListView {
+public:
+    // Returns the row's text: written into text, or a string of its own
+    typedef std::function<const char*(int index, char* text, size_t size)> RowProvider;
+
+    explicit ListView(Adafruit_SSD1306* gfx) :
+        gfx(gfx),
+        count(0),
+        first(0),
+        titleHash(0),
+        scrollbarShown(false),
+        scrollbarFirst(0),
+        scrollbarCount(0),
+        drawn(0) {
+        for (int i = 0; i < MENU_VISIBLE_ROWS; i++) {
+            rowHash[i] = 0;
+            rowLit[i] = false;
+        }
+        invalidate(0, SCREEN_HEIGHT);
+    }
+
+    // A different list: start at its top
+    void reset() {
+        first = 0;
+    }
+
+    // Moves the window of a list shown without a highlight; false when it
+    // is already at that end
+    bool scroll(int delta) {
+        int top = first + delta;
+        if (top < 0 || top > count - MENU_VISIBLE_ROWS) {
+            return false;
+        }
+        first = top;
+        return true;
+    }
+
+    int firstRow() {
+        return first;
+    }
+
+    // Rows drawn since boot, for the bench
+    unsigned long rowsDrawn() {
+        return drawn;
+    }
+
+    // Something else drew over lines top .. bottom - 1
+    void invalidate(int top, int bottom) {
+        if (top <= 10) {
+            titleValid = false;
+        }
+        for (int i = 0; i < MENU_VISIBLE_ROWS; i++) {
+            if (top <= 19 + i * 8 && bottom > 11 + i * 8) {
+                rowValid[i] = false;
+            }
+        }
+        if (bottom > 11) {
+            scrollbarValid = false;
+        }
+    }
+
+    // Brings the framebuffer up to date with itemCount rows from rows,
+    // selected highlighted (-1 for none) and kept in the window. Returns
+    // whether anything was drawn.
+    bool show(const char* title, int itemCount, int selected, const RowProvider& rows) {
+        count = itemCount;
+        if (selected >= 0) {
+            if (selected < first) {
+                first = selected;
+            } else if (selected >= first + MENU_VISIBLE_ROWS) {
+                first = selected - MENU_VISIBLE_ROWS + 1;
+            }
+        }
+        if (first > count - MENU_VISIBLE_ROWS) {
+            first = count > MENU_VISIBLE_ROWS ? count - MENU_VISIBLE_ROWS : 0;
+        }
+        int highlighted = selected >= 0 ? selected - first : -1;
+
+        gfx->setTextSize(1);
+        gfx->setTextWrap(false);
+        bool changed = false;
+        uint32_t hash = hashOf(title);
+        if (!titleValid || hash != titleHash) {
+            gfx->fillRect(0, 0, SCREEN_WIDTH, 11, SSD1306_BLACK);
+            gfx->setCursor(0, 0);
+            gfx->print(title);
+            gfx->drawLine(0, 9, SCREEN_WIDTH-1, 9, SSD1306_WHITE);
+            titleHash = hash;
+            titleValid = true;
+            changed = true;
+        }
+
+        bool scrollbar = count > MENU_VISIBLE_ROWS;
+        if (scrollbarShown && !scrollbar) {
+            // The rows ran under it; draw them whole again
+            gfx->fillRect(SCREEN_WIDTH-3, 11, 3, 53, SSD1306_BLACK);
+            invalidate(11, SCREEN_HEIGHT);
+            scrollbarShown = false;
+            changed = true;
+        }
+
+        const char* text[MENU_VISIBLE_ROWS];
+        char buffers[MENU_VISIBLE_ROWS][MENU_ROW_SIZE];
+        bool dirty[MENU_VISIBLE_ROWS];
+        for (int i = 0; i < MENU_VISIBLE_ROWS; i++) {
+            text[i] = first + i < count ? rows(first + i, buffers[i], sizeof(buffers[i])) : nullptr;
+            hash = text[i] ? hashOf(text[i]) | 1 : 0;
+            dirty[i] = !rowValid[i] || hash != rowHash[i] || rowLit[i] != (i == highlighted);
+            rowHash[i] = hash;
+        }
+        for (int i = 1; i < MENU_VISIBLE_ROWS; i++) {
+            // A highlight leaving row i uncovers the descenders of row i - 1
+            if (rowLit[i] && i != highlighted) {
+                dirty[i - 1] = true;
+            }
+        }
+        if (highlighted > 0 && dirty[highlighted - 1]) {
+            dirty[highlighted] = true;  // which clears the highlight's top line
+        }
+
+        // The highlight goes last, over its neighbour's line
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < MENU_VISIBLE_ROWS; i++) {
+                if (dirty[i] && (i == highlighted) == (pass == 1)) {
+                    drawRow(i, text[i], i == highlighted);
+                    changed = true;
+                }
+            }
+        }
+
+        if (scrollbar && (changed || !scrollbarShown || !scrollbarValid ||
+                          scrollbarFirst != first || scrollbarCount != count)) {
+            gfx->fillRect(SCREEN_WIDTH-3, 11, 3, 53, SSD1306_BLACK);
+            gfx->drawRect(SCREEN_WIDTH-3, 11, 3, 53, SSD1306_WHITE);
+            int scrollHeight = 53 * MENU_VISIBLE_ROWS / count;
+            int scrollPos = 11 + (53-scrollHeight) * first / (count - MENU_VISIBLE_ROWS);
+            gfx->fillRect(SCREEN_WIDTH-3, scrollPos, 3, scrollHeight, SSD1306_WHITE);
+            scrollbarShown = true;
+            scrollbarFirst = first;
+            scrollbarCount = count;
+            scrollbarValid = true;
+            changed = true;
+        }
+        gfx->setTextWrap(true);
+        return changed;
+    }
+
+private:
+    Adafruit_SSD1306* gfx;
+    int count;
+    int first;
+    uint32_t titleHash;
+    bool titleValid;
+    uint32_t rowHash[MENU_VISIBLE_ROWS];  // of the text drawn, 0 for an empty row
+    bool rowLit[MENU_VISIBLE_ROWS];       // drawn highlighted
+    bool rowValid[MENU_VISIBLE_ROWS];
+    bool scrollbarShown;
+    bool scrollbarValid;
+    int scrollbarFirst;
+    int scrollbarCount;
+    unsigned long drawn;
+
+    // FNV-1a
+    static uint32_t hashOf(const char* text) {
+        uint32_t h = 2166136261u;
+        while (*text) {
+            h = (h ^ (uint8_t)*text++) * 16777619u;
+        }
+        return h;
+    }
+
+    void drawRow(int i, const char* text, bool lit) {
+        int top = 11 + i * 8;
+        if (lit) {
+            gfx->fillRect(0, top, SCREEN_WIDTH, 9, SSD1306_WHITE);
+            gfx->setTextColor(SSD1306_BLACK);
+        } else {
+            // Line 11 is no one's descenders; clear it with the first row
+            gfx->fillRect(0, i == 0 ? top : top + 1, SCREEN_WIDTH, i == 0 ? 9 : 8, SSD1306_BLACK);
+        }
+        if (text) {
+            gfx->setCursor(2, top + 1);
+            gfx->print(text);
+        }
+        gfx->setTextColor(SSD1306_WHITE);
+        rowLit[i] = lit;
+        rowValid[i] = true;
+        drawn++;
+    }
+};
+
+#endif
@@ -2,416 +2,562 @@
 #define MENU_H
 
 #include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "config.h"
 #include "display.h"
+#include "settings.h"
+#include "task_messages.h"
 #include "wifi_scanner.h"
 
 enum MenuState {
     MAIN_MENU,
     WIFI_SCAN_MENU,
+    WIFI_CONNECTING,
     WIFI_STATUS_MENU,
     OTA_UPDATE_MENU,
     SYSTEM_INFO_MENU,
     SETTINGS_MENU
 };
 
+class Menu;
+
+// One row of a menu screen. A row without format is its label as is;
+// one with format is filled in from live state, and only while it is on
+// screen.
+struct MenuItem {
+    const char* label;
+    void (*action)(Menu& menu);                          // SELECT, on screens with a highlight
+    void (*format)(Menu& menu, char* text, size_t size);
+    bool needsWiFi;                                      // hidden while disconnected
+};
+
+struct MenuScreen {
+    const char* title;
+    const MenuItem* items;
+    uint8_t count;
+    bool selectable;  // false: an information page, UP/DOWN scroll it
+};
+
+// Runs on the UI task. Reads scanner state directly but leaves anything
+// that drives the radio to loop(), through the network queue; the
+// outcome comes back as a UiMessage and lands in one of the handle*()
+// calls below.
+//
+// The screens are constexpr tables (see screenFor()), so they live in
+// flash; navigation, scrolling and drawing are the same code for all of
+// them and for the scan list, whatever their length.
 class Menu {
 private:
     Display* display;
     WiFiScanner* wifiScanner;
+    Settings* settings;
+    QueueHandle_t netQueue;
     MenuState currentState;
     int selectedIndex;
-    
-    const char* mainMenuItems[6] = {
-        "Scan WiFi",
-        "WiFi Status",
-        "AP Mode",
-        "OTA Update",
-        "System Info",
-        "Settings"
-    };
-
-    const char* settingsItems[6] = {
-        "Screen Brightness",
-        "Screen Timeout",
-        "Auto WiFi Connect",
-        "Device Name",
-        "OTA Password",
-        "Factory Reset"
-    };
+    unsigned long otaReadyAt;  // ms after boot, 0 until mDNS is up
 
 public:
-    Menu(Display* disp, WiFiScanner* scanner) {
+    Menu(Display* disp, WiFiScanner* scanner, Settings* stored, QueueHandle_t commands) {
         display = disp;
         wifiScanner = scanner;
+        settings = stored;
+        netQueue = commands;
         currentState = MAIN_MENU;
         selectedIndex = 0;
+        otaReadyAt = 0;
     }
 
     void handleUpButton() {
-        switch(currentState) {
-            case MAIN_MENU:
-                selectedIndex = (selectedIndex > 0) ? selectedIndex - 1 : 5;
-                drawMainMenu();
-                break;
-            case WIFI_SCAN_MENU:
-                if(selectedIndex > 0) {
-                    selectedIndex--;
-                    startWiFiScan();  // Refresh display with new selection
-                }
-                break;
-            case SETTINGS_MENU:
-                selectedIndex = (selectedIndex > 0) ? selectedIndex - 1 : 5;
-                drawSettingsMenu();
-                break;
-            default:
-                break;
-        }
+        move(-1);
     }
 
     void handleDownButton() {
-        switch(currentState) {
-            case MAIN_MENU:
-                selectedIndex = (selectedIndex < 5) ? selectedIndex + 1 : 0;
-                drawMainMenu();
-                break;
-            case WIFI_SCAN_MENU:
-                {
-                    int count;
-                    NetworkInfo* networks = wifiScanner->getNetworks(&count);
-                    if(selectedIndex < count - 1) {
-                        selectedIndex++;
-                        startWiFiScan();  // Refresh display with new selection
-                    }
-                }
-                break;
-            case SETTINGS_MENU:
-                selectedIndex = (selectedIndex < 5) ? selectedIndex + 1 : 0;
-                drawSettingsMenu();
-                break;
-            default:
-                break;
-        }
+        move(1);
     }
 
     void handleSelectButton() {
-        switch(currentState) {
-            case MAIN_MENU:
-                switch(selectedIndex) {
-                    case 0:
-                        currentState = WIFI_SCAN_MENU;
-                        selectedIndex = 0;
-                        startWiFiScan();
-                        break;
-                    case 1:
-                        currentState = WIFI_STATUS_MENU;
-                        showWiFiStatus();
-                        break;
-                    case 2:
-                        toggleAPMode();
-                        break;
-                    case 3:
-                        currentState = OTA_UPDATE_MENU;
-                        showOTAMenu();
-                        break;
-                    case 4:
-                        currentState = SYSTEM_INFO_MENU;
-                        showSystemInfo();
-                        break;
-                    case 5:
-                        currentState = SETTINGS_MENU;
-                        selectedIndex = 0;
-                        drawSettingsMenu();
-                        break;
-                }
-                break;
-                
-            case WIFI_SCAN_MENU:
-                {
-                    int count;
-                    NetworkInfo* networks = wifiScanner->getNetworks(&count);
-                    if(selectedIndex < count) {
-                        NetworkInfo& selected = networks[selectedIndex];
-                        
-                        if(selected.encryption != WIFI_AUTH_OPEN) {
-                            // For secured networks, show AP mode for web config
-                            display->showNotification("Use AP mode to\nconnect to\nsecured networks");
-                            delay(2000);
-                        } else {
-                            // For open networks, connect directly
-                            display->showNotification("Connecting to\n" + selected.ssid);
-                            if(wifiScanner->connect(selected.ssid.c_str(), "")) {
-                                display->showNotification("Connected!");
-                            } else {
-                                display->showNotification("Connection failed");
-                            }
-                            delay(2000);
-                        }
-                        currentState = MAIN_MENU;
-                        selectedIndex = 0;
-                        drawMainMenu();
-                    }
-                }
-                break;
-                
-            case SETTINGS_MENU:
-                handleSettingsSelection();
-                break;
-                
-            default:
-                currentState = MAIN_MENU;
-                selectedIndex = 0;
-                drawMainMenu();
-                break;
+        const MenuScreen* screen = screenFor(currentState);
+        if (currentState == WIFI_SCAN_MENU) {
+            selectNetwork();
+        } else if (screen && screen->selectable) {
+            const MenuItem* item = itemAt(*screen, selectedIndex);
+            if (item && item->action) {
+                item->action(*this);
+            }
+        } else {
+            open(MAIN_MENU);
         }
     }
 
+    // Shows the list once the scan finishes; see handleScanComplete()
     void startWiFiScan() {
         display->showNotification("Scanning WiFi...");
-        if (wifiScanner->scan()) {
-            int count;
-            NetworkInfo* networks = wifiScanner->getNetworks(&count);
-            
-            // Create network list for display
-            const char* networkItems[MAX_NETWORKS];
-            char networkLabels[MAX_NETWORKS][32];  // Buffer for network names with signal strength
-            
-            for(int i = 0; i < count; i++) {
-                // Format: SSID [sig] (🔒)
-                String label = networks[i].ssid;
-                if (networks[i].isConnected) {
-                    label += " ✓";
-                }
-                label += " [" + String(networks[i].rssi) + "dBm]";
-                if (networks[i].encryption != WIFI_AUTH_OPEN) {
-                    label += " 🔒";
-                }
-                strncpy(networkLabels[i], label.c_str(), 31);
-                networkLabels[i][31] = '\0';  // Ensure null termination
-                networkItems[i] = networkLabels[i];
+        request(NET_START_SCAN);
+    }
+
+    void handleScanComplete(int count) {
+        // Background rescans (AP mode) only refresh a list that is on screen
+        if (currentState != WIFI_SCAN_MENU) {
+            return;
+        }
+        if (count > 0) {
+            if (selectedIndex >= count) {
+                selectedIndex = count - 1;
             }
-            
-            display->drawMenu("WiFi Networks", networkItems, count, selectedIndex);
+            draw();
         } else {
             display->showNotification("No networks found");
             delay(2000);
-            currentState = MAIN_MENU;
-            drawMainMenu();
+            open(MAIN_MENU);
         }
     }
 
+    // reason is the wifi_err_reason_t of a failure, 0 when it timed out
+    // Only answers a connect started from the list; the one at boot and
+    // the portal's have nothing on screen waiting for them
+    void handleConnectResult(bool connected, uint8_t reason) {
+        if (currentState != WIFI_CONNECTING) {
+            return;
+        }
+        char notice[48];
+        if (connected) {
+            snprintf(notice, sizeof(notice), "Connected!\nIP in %lu ms", wifiScanner->lastTimeToIp());
+        } else {
+            switch (reason) {
+                case 0:                       strcpy(notice, "Connection\ntimed out"); break;
+                case WIFI_REASON_NO_AP_FOUND: strcpy(notice, "Network not found"); break;
+                case WIFI_REASON_AUTH_FAIL:
+                case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+                                              strcpy(notice, "Wrong password"); break;
+                default:                      strcpy(notice, "Connection failed"); break;
+            }
+        }
+        display->showNotification(notice);
+        delay(2000);
+        open(MAIN_MENU);
+    }
+
+    void noteOtaReady(unsigned long at) {
+        otaReadyAt = at;
+        display->showNotification("OTA Ready");
+    }
+
+    // Shows the outcome once loop() has switched; see handleAPModeChanged()
     void toggleAPMode() {
-        if (!wifiScanner->isAPMode()) {
-            wifiScanner->enableAPMode(true);
+        request(NET_SET_AP_MODE, !wifiScanner->isAPMode());
+    }
+
+    void handleAPModeChanged(bool enabled) {
+        if (enabled) {
             String apInfo = "AP Mode Active\nSSID: " + wifiScanner->getAPSSID() + "\n";
             apInfo += "IP: " + wifiScanner->getAPIP().toString() + "\n";
             apInfo += "Pass: " + String(AP_PASSWORD);
             display->showNotification(apInfo);
         } else {
-            wifiScanner->enableAPMode(false);
             display->showNotification("AP Mode Disabled");
         }
     }
 
-    void showWiFiStatus() {
-        const char* statusItems[6];
-        char statusLabels[6][32];
-        int itemCount = 0;
+    void drawMainMenu() {
+        draw();
+    }
+
+    // Long press on SELECT: leave any submenu for the main menu
+    void handleBackButton() {
+        if (currentState == MAIN_MENU) {
+            return;
+        }
+        open(MAIN_MENU);
+    }
+
+    MenuState getState() {
+        return currentState;
+    }
+
+    int getSelectedIndex() {
+        return selectedIndex;
+    }
 
-        // Status header
-        sprintf(statusLabels[itemCount], "Status: %s", 
-            wifiScanner->isConnected() ? "Connected" : "Disconnected");
-        statusItems[itemCount++] = statusLabels[itemCount];
+    int getFirstRow() {
+        return display->listFirstRow();
+    }
 
+    void update() {
+        // Regular updates like status bar, notifications, etc.
         if (wifiScanner->isConnected()) {
-            // SSID
-            sprintf(statusLabels[itemCount], "SSID: %s", 
-                wifiScanner->getConnectedSSID().c_str());
-            statusItems[itemCount++] = statusLabels[itemCount];
-            
-            // IP Address
-            sprintf(statusLabels[itemCount], "IP: %s", 
-                wifiScanner->getIP().toString().c_str());
-            statusItems[itemCount++] = statusLabels[itemCount];
-            
-            // Signal Strength
-            sprintf(statusLabels[itemCount], "Signal: %d dBm", 
-                wifiScanner->getSignalStrength());
-            statusItems[itemCount++] = statusLabels[itemCount];
-            
-            // MAC Address
-            sprintf(statusLabels[itemCount], "MAC: %s", 
-                WiFi.macAddress().c_str());
-            statusItems[itemCount++] = statusLabels[itemCount];
-            
-            // Channel
-            sprintf(statusLabels[itemCount], "Channel: %d", 
-                WiFi.channel());
-            statusItems[itemCount++] = statusLabels[itemCount];
+            char ssid[33];
+            wifiScanner->getConnectedSSID(ssid, sizeof(ssid));
+            display->drawStatusBar(
+                ssid,
+                wifiScanner->getSignalStrength(),
+                temperatureRead()
+            );
         }
+    }
 
-        display->drawMenu("WiFi Status", statusItems, itemCount, -1);  // -1 for no selection
+private:
+    // The tables behind every fixed screen; null for the scan list, whose
+    // rows come from the scanner, and while connecting
+    static const MenuScreen* screenFor(MenuState state) {
+        static constexpr MenuItem mainItems[] = {
+            { "Scan WiFi",    openScan,      nullptr, false },
+            { "WiFi Status",  openStatus,    nullptr, false },
+            { "AP Mode",      toggleAP,      nullptr, false },
+            { "OTA Update",   openOta,       nullptr, false },
+            { "System Info",  openInfo,      nullptr, false },
+            { "Settings",     openSettings,  nullptr, false },
+        };
+        static constexpr MenuItem statusItems[] = {
+            { nullptr, nullptr, formatWiFiState, false },
+            { nullptr, nullptr, formatSSID,      true },
+            { nullptr, nullptr, formatIP,        true },
+            { nullptr, nullptr, formatSignal,    true },
+            { nullptr, nullptr, formatMAC,       true },
+            { nullptr, nullptr, formatChannel,   true },
+        };
+        static constexpr MenuItem otaItems[] = {
+            { "Status: Ready", nullptr, nullptr,     false },
+            { nullptr,         nullptr, formatIP,    false },
+            { nullptr,         nullptr, formatPort,  false },
+            { "Host: " OTA_HOSTNAME ".local", nullptr, nullptr, false },
+            { nullptr,         nullptr, formatVisit, false },
+        };
+        static constexpr MenuItem infoItems[] = {
+            { nullptr, nullptr, formatUptime,   false },
+            { nullptr, nullptr, formatTemp,     false },
+            { nullptr, nullptr, formatHeap,     false },
+            { nullptr, nullptr, formatChip,     false },
+            { nullptr, nullptr, formatFrame,    false },
+            { nullptr, nullptr, formatSdk,      false },
+            { nullptr, nullptr, formatOtaReady, false },
+        };
+        static constexpr MenuItem settingsItems[] = {
+            { "Screen Brightness", stepBrightness, nullptr, false },
+            { "Screen Timeout",    stepTimeout,    nullptr, false },
+            { "Auto WiFi Connect", toggleAutoConnect, nullptr, false },
+            { "Device Name",       setDeviceName,  nullptr, false },
+            { "OTA Password",      toggleOtaAuth,  nullptr, false },
+            { "Factory Reset",     factoryReset,   nullptr, false },
+        };
+        static constexpr MenuScreen screens[] = {
+            { "Main Menu",   mainItems,     sizeof(mainItems) / sizeof(mainItems[0]),         true },
+            { "WiFi Status", statusItems,   sizeof(statusItems) / sizeof(statusItems[0]),     false },
+            { "OTA Update",  otaItems,      sizeof(otaItems) / sizeof(otaItems[0]),           false },
+            { "System Info", infoItems,     sizeof(infoItems) / sizeof(infoItems[0]),         false },
+            { "Settings",    settingsItems, sizeof(settingsItems) / sizeof(settingsItems[0]), true },
+        };
+        switch (state) {
+            case MAIN_MENU:        return &screens[0];
+            case WIFI_STATUS_MENU: return &screens[1];
+            case OTA_UPDATE_MENU:  return &screens[2];
+            case SYSTEM_INFO_MENU: return &screens[3];
+            case SETTINGS_MENU:    return &screens[4];
+            default:               return nullptr;
+        }
     }
 
-    void showOTAMenu() {
-        const char* otaItems[5];
-        char otaLabels[5][32];
-        int itemCount = 0;
+    // The screen's row-th shown item; rows that need WiFi drop out while
+    // disconnected
+    const MenuItem* itemAt(const MenuScreen& screen, int row) {
+        bool connected = wifiScanner->isConnected();
+        for (int i = 0; i < screen.count; i++) {
+            if (!screen.items[i].needsWiFi || connected) {
+                if (row-- == 0) {
+                    return &screen.items[i];
+                }
+            }
+        }
+        return nullptr;
+    }
 
-        if (wifiScanner->isConnected()) {
-            // Status
-            sprintf(otaLabels[itemCount], "Status: Ready");
-            otaItems[itemCount++] = otaLabels[itemCount];
-            
-            // IP Address
-            sprintf(otaLabels[itemCount], "IP: %s", 
-                wifiScanner->getIP().toString().c_str());
-            otaItems[itemCount++] = otaLabels[itemCount];
-            
-            // Port
-            sprintf(otaLabels[itemCount], "Port: %d", OTA_PORT);
-            otaItems[itemCount++] = otaLabels[itemCount];
-            
-            // Hostname
-            sprintf(otaLabels[itemCount], "Host: %s.local", OTA_HOSTNAME);
-            otaItems[itemCount++] = otaLabels[itemCount];
-            
-            // Instructions
-            sprintf(otaLabels[itemCount], "Visit: http://%s:%d", 
-                wifiScanner->getIP().toString().c_str(), OTA_PORT);
-            otaItems[itemCount++] = otaLabels[itemCount];
-            
-            display->drawMenu("OTA Update", otaItems, itemCount, -1);
+    int rowCount() {
+        if (currentState == WIFI_SCAN_MENU) {
+            return wifiScanner->getNetworkCount();
+        }
+        const MenuScreen* screen = screenFor(currentState);
+        if (!screen) {
+            return 0;
+        }
+        int count = 0;
+        while (itemAt(*screen, count)) {
+            count++;
+        }
+        return count;
+    }
+
+    // The text of one row: a label straight from the table, or formatted
+    // into text
+    const char* rowText(int row, char* text, size_t size) {
+        if (currentState == WIFI_SCAN_MENU) {
+            // Format: SSID [sig] (🔒), from a copy of the row's entry
+            NetworkInfo net;
+            if (!wifiScanner->getNetwork(row, net)) {
+                return "";
+            }
+            snprintf(text, size, "%s%s [%ddBm]%s",
+                     net.ssid, net.isConnected ? " ✓" : "", net.rssi,
+                     net.encryption != WIFI_AUTH_OPEN ? " 🔒" : "");
+            return text;
+        }
+        // Past the end if WiFi dropped since rowCount(): draw nothing there
+        const MenuItem* item = itemAt(*screenFor(currentState), row);
+        if (!item) {
+            return "";
+        }
+        if (!item->format) {
+            return item->label;
+        }
+        item->format(*this, text, size);
+        return text;
+    }
+
+    const char* title() {
+        const MenuScreen* screen = screenFor(currentState);
+        return screen ? screen->title : "WiFi Networks";
+    }
+
+    bool selectable() {
+        const MenuScreen* screen = screenFor(currentState);
+        return currentState == WIFI_SCAN_MENU || (screen && screen->selectable);
+    }
+
+    // The highlight on menus, wrapping round on the fixed ones; the view
+    // itself on information pages longer than the display
+    void move(int delta) {
+        if (currentState == WIFI_CONNECTING ||
+            (currentState == WIFI_SCAN_MENU && wifiScanner->isScanning())) {
+            return;
+        }
+        int count = rowCount();
+        if (!selectable()) {
+            if (!display->scrollList(delta)) {
+                return;
+            }
+        } else {
+            int next = selectedIndex + delta;
+            if (currentState != WIFI_SCAN_MENU) {
+                next = (next + count) % count;
+            } else if (next < 0 || next >= count) {
+                return;
+            }
+            selectedIndex = next;
+        }
+        draw();
+    }
+
+    // The display asks for the rows in view, and redraws those that changed
+    void draw() {
+        display->drawList(title(), rowCount(), selectable() ? selectedIndex : -1,
+                          [this](int index, char* text, size_t size) {
+                              return rowText(index, text, size);
+                          });
+    }
+
+    void open(MenuState state) {
+        currentState = state;
+        selectedIndex = 0;
+        display->resetList();
+        draw();
+    }
+
+    void selectNetwork() {
+        NetworkInfo selected;
+        if (wifiScanner->isScanning() || !wifiScanner->getNetwork(selectedIndex, selected)) {
+            return;
+        }
+        if (selected.encryption != WIFI_AUTH_OPEN) {
+            // For secured networks, show AP mode for web config
+            display->showNotification("Use AP mode to\nconnect to\nsecured networks");
+            delay(2000);
+            open(MAIN_MENU);
+        } else {
+            // For open networks, connect directly; see handleConnectResult()
+            char notice[48];
+            snprintf(notice, sizeof(notice), "Connecting to\n%s", selected.ssid);
+            display->showNotification(notice);
+            currentState = WIFI_CONNECTING;
+            request(NET_CONNECT, false, selected.ssid);
+        }
+    }
+
+    // A setting took effect: say so for a second, then back to the list
+    void settingChanged(const String& notice) {
+        display->showNotification(notice);
+        delay(1000);  // Show notification
+        draw();
+    }
+
+    // Main menu
+    static void openScan(Menu& menu) {
+        menu.currentState = WIFI_SCAN_MENU;
+        menu.selectedIndex = 0;
+        menu.display->resetList();
+        menu.startWiFiScan();
+    }
+
+    static void openStatus(Menu& menu) {
+        menu.open(WIFI_STATUS_MENU);
+    }
+
+    static void toggleAP(Menu& menu) {
+        menu.toggleAPMode();
+    }
+
+    static void openOta(Menu& menu) {
+        if (menu.wifiScanner->isConnected()) {
+            menu.open(OTA_UPDATE_MENU);
         } else {
-            display->showNotification("WiFi not connected");
+            menu.display->showNotification("WiFi not connected");
             delay(2000);
-            currentState = MAIN_MENU;
-            drawMainMenu();
+            menu.open(MAIN_MENU);
         }
     }
 
-    void showSystemInfo() {
-        const char* infoItems[6];
-        char infoLabels[6][32];
-        int itemCount = 0;
+    static void openInfo(Menu& menu) {
+        menu.open(SYSTEM_INFO_MENU);
+    }
+
+    static void openSettings(Menu& menu) {
+        menu.open(SETTINGS_MENU);
+    }
+
+    // WiFi Status
+    static void formatWiFiState(Menu& menu, char* text, size_t size) {
+        snprintf(text, size, "Status: %s",
+                 menu.wifiScanner->isConnected() ? "Connected" : "Disconnected");
+    }
+
+    static void formatSSID(Menu& menu, char* text, size_t size) {
+        char ssid[33];
+        menu.wifiScanner->getConnectedSSID(ssid, sizeof(ssid));
+        snprintf(text, size, "SSID: %s", ssid);
+    }
+
+    static void formatIP(Menu& menu, char* text, size_t size) {
+        snprintf(text, size, "IP: %s", menu.wifiScanner->getIP().toString().c_str());
+    }
+
+    static void formatSignal(Menu& menu, char* text, size_t size) {
+        snprintf(text, size, "Signal: %d dBm", menu.wifiScanner->getSignalStrength());
+    }
+
+    static void formatMAC(Menu&, char* text, size_t size) {
+        snprintf(text, size, "MAC: %s", WiFi.macAddress().c_str());
+    }
+
+    static void formatChannel(Menu&, char* text, size_t size) {
+        snprintf(text, size, "Channel: %d", WiFi.channel());
+    }
+
+    // OTA Update
+    static void formatPort(Menu&, char* text, size_t size) {
+        snprintf(text, size, "Port: %d", OTA_PORT);
+    }
+
+    static void formatVisit(Menu& menu, char* text, size_t size) {
+        snprintf(text, size, "Visit: http://%s:%d",
+                 menu.wifiScanner->getIP().toString().c_str(), OTA_PORT);
+    }
 
-        // Uptime
+    // System Info
+    static void formatUptime(Menu&, char* text, size_t size) {
         unsigned long uptime = millis() / 1000;
         unsigned int days = uptime / 86400;
         unsigned int hours = (uptime % 86400) / 3600;
         unsigned int mins = (uptime % 3600) / 60;
-        sprintf(infoLabels[itemCount], "Uptime: %ud %uh %um", days, hours, mins);
-        infoItems[itemCount++] = infoLabels[itemCount];
+        snprintf(text, size, "Uptime: %ud %uh %um", days, hours, mins);
+    }
 
-        // CPU Temperature
-        sprintf(infoLabels[itemCount], "CPU Temp: %.1fC", temperatureRead());
-        infoItems[itemCount++] = infoLabels[itemCount];
+    static void formatTemp(Menu& menu, char* text, size_t size) {
+        snprintf(text, size, "CPU Temp: %.1fC", menu.temperatureRead());
+    }
 
-        // Free Heap
-        sprintf(infoLabels[itemCount], "Free RAM: %u KB", ESP.getFreeHeap() / 1024);
-        infoItems[itemCount++] = infoLabels[itemCount];
+    static void formatHeap(Menu&, char* text, size_t size) {
+        snprintf(text, size, "Free RAM: %u KB", ESP.getFreeHeap() / 1024);
+    }
 
-        // Flash Size
-        sprintf(infoLabels[itemCount], "Flash: %u MB", ESP.getFlashChipSize() / (1024 * 1024));
-        infoItems[itemCount++] = infoLabels[itemCount];
+    static void formatChip(Menu&, char* text, size_t size) {
+        snprintf(text, size, "CPU %uMHz Flash %uMB", ESP.getCpuFreqMHz(),
+                 ESP.getFlashChipSize() / (1024 * 1024));
+    }
 
-        // CPU Frequency
-        sprintf(infoLabels[itemCount], "CPU Freq: %u MHz", ESP.getCpuFreqMHz());
-        infoItems[itemCount++] = infoLabels[itemCount];
+    // Bus time of the last display frame
+    static void formatFrame(Menu& menu, char* text, size_t size) {
+        snprintf(text, size, "Frame: %.1f ms", menu.display->frameTimeUs() / 1000.0);
+    }
 
-        // SDK Version
-        sprintf(infoLabels[itemCount], "SDK: %s", ESP.getSdkVersion());
-        infoItems[itemCount++] = infoLabels[itemCount];
+    static void formatSdk(Menu&, char* text, size_t size) {
+        snprintf(text, size, "SDK: %s", ESP.getSdkVersion());
+    }
 
-        display->drawMenu("System Info", infoItems, itemCount, -1);  // -1 for no selection
+    // Boot to OTA ready, fast when the WiFi cache was used
+    static void formatOtaReady(Menu& menu, char* text, size_t size) {
+        if (menu.otaReadyAt) {
+            snprintf(text, size, "OTA ready: %lu ms%s", menu.otaReadyAt,
+                     menu.wifiScanner->lastConnectWasCached() ? " (c)" : "");
+        } else {
+            snprintf(text, size, "OTA ready: -");
+        }
     }
 
-    void drawMainMenu() {
-        display->drawMenu("Main Menu", mainMenuItems, 6, selectedIndex);
+    // Settings
+    static void stepBrightness(Menu& menu) {
+        uint8_t brightness = (menu.settings->brightness() + 1) % BRIGHTNESS_LEVELS;
+        menu.settings->setBrightness(brightness);
+        menu.display->setBrightness(brightness);
+        char msg[32];
+        sprintf(msg, "Brightness: %d/%d", brightness + 1, BRIGHTNESS_LEVELS);
+        menu.settingChanged(msg);
     }
 
-    void drawSettingsMenu() {
-        display->drawMenu("Settings", settingsItems, 6, selectedIndex);
+    static void stepTimeout(Menu& menu) {
+        menu.settings->setTimeoutIndex(menu.settings->timeoutIndex() + 1);
+        char msg[32];
+        sprintf(msg, "Timeout: %ds", menu.settings->timeoutSeconds());
+        menu.settingChanged(msg);
     }
 
-    void handleSettingsSelection() {
-        switch(selectedIndex) {
-            case 0: // Screen Brightness
-                {
-                    static uint8_t brightness = DEFAULT_BRIGHTNESS;
-                    brightness = (brightness + 1) % BRIGHTNESS_LEVELS;
-                    display->setBrightness(brightness);
-                    char msg[32];
-                    sprintf(msg, "Brightness: %d/%d", brightness + 1, BRIGHTNESS_LEVELS);
-                    display->showNotification(msg);
-                }
-                break;
-                
-            case 1: // Screen Timeout
-                {
-                    static const int timeouts[] = SCREEN_TIMEOUT_OPTIONS;
-                    static int timeoutIndex = 0;
-                    timeoutIndex = (timeoutIndex + 1) % (sizeof(timeouts)/sizeof(timeouts[0]));
-                    char msg[32];
-                    sprintf(msg, "Timeout: %ds", timeouts[timeoutIndex]);
-                    display->showNotification(msg);
-                }
-                break;
-                
-            case 2: // Auto WiFi Connect
-                {
-                    static bool autoConnect = true;
-                    autoConnect = !autoConnect;
-                    WiFi.setAutoReconnect(autoConnect);
-                    display->showNotification(autoConnect ? 
-                        "Auto Connect: ON" : "Auto Connect: OFF");
-                }
-                break;
-                
-            case 3: // Device Name
-                {
-                    String newName = "ESP32-" + WiFi.macAddress().substring(9);
-                    WiFi.setHostname(newName.c_str());
-                    display->showNotification("Name: " + newName);
-                }
-                break;
-                
-            case 4: // OTA Password
-                {
-                    static bool otaAuth = false;
-                    otaAuth = !otaAuth;
-                    // Update.setPassword(otaAuth ? OTA_PASSWORD : nullptr);
-                    display->showNotification(otaAuth ? 
-                        "OTA Auth: ON" : "OTA Auth: OFF");
-                }
-                break;
-                
-            case 5: // Factory Reset
-                {
-                    display->showNotification("Resetting...");
-                    delay(1000);
-                    WiFi.disconnect(true);  // Clear stored credentials
-                    ESP.restart();
-                }
-                break;
-        }
-        
-        delay(1000);  // Show notification
-        drawSettingsMenu();
+    static void toggleAutoConnect(Menu& menu) {
+        bool autoConnect = !menu.settings->autoConnect();
+        menu.settings->setAutoConnect(autoConnect);
+        WiFi.setAutoReconnect(autoConnect);
+        menu.settingChanged(autoConnect ? "Auto Connect: ON" : "Auto Connect: OFF");
     }
 
-    void update() {
-        // Regular updates like status bar, notifications, etc.
-        if (wifiScanner->isConnected()) {
-            display->drawStatusBar(
-                wifiScanner->getConnectedSSID(),
-                wifiScanner->getSignalStrength(),
-                temperatureRead()
-            );
+    static void setDeviceName(Menu& menu) {
+        String newName = "ESP32-" + WiFi.macAddress().substring(9);
+        WiFi.setHostname(newName.c_str());
+        menu.settingChanged("Name: " + newName);
+    }
+
+    static void toggleOtaAuth(Menu& menu) {
+        bool otaAuth = !menu.settings->otaAuth();
+        menu.settings->setOtaAuth(otaAuth);
+        // Update.setPassword(otaAuth ? OTA_PASSWORD : nullptr);
+        menu.settingChanged(otaAuth ? "OTA Auth: ON" : "OTA Auth: OFF");
+    }
+
+    static void factoryReset(Menu& menu) {
+        menu.display->showNotification("Resetting...");
+        delay(1000);
+        menu.wifiScanner->forgetNetwork();  // No fast reconnect after this
+        menu.settings->reset();
+        WiFi.disconnect(true);  // Clear stored credentials
+        ESP.restart();
+    }
+
+    void request(uint8_t command, bool enable = false, const char* ssid = "") {
+        NetMessage message;
+        message.command = command;
+        message.enable = enable;
+        strncpy(message.ssid, ssid, sizeof(message.ssid) - 1);
+        message.ssid[sizeof(message.ssid) - 1] = '\0';
+        if (xQueueSend(netQueue, &message, 0) != pdTRUE) {
+            Serial.printf("Network queue full, request %u dropped\n", command);
         }
     }
 
-private:
     float temperatureRead() {
         #ifdef ESP32
             // Using ESP32's ADC for a rough temperature reading
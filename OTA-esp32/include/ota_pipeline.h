@@ -0,0 +1,342 @@
+#ifndef OTA_PIPELINE_H
+#define OTA_PIPELINE_H
+
+#include <Arduino.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "delta_patch.h"
+#include "image_verifier.h"
+#include "inflate_stream.h"
+
+// Decouples the HTTP receive path from flash programming. Incoming chunks
+// are copied into sector-sized buffers (two by default); each full buffer
+// is handed to a writer task that feeds Update.write() while the next one
+// fills, so network receive overlaps with flash erase/program. A gzip
+// payload is recognised by its magic bytes and inflated on the writer task
+// straight into Update.write(). The (possibly inflated) payload may also be
+// a delta patch, which is applied against the running partition. The
+// resulting image is hashed on its way to flash and any signature trailer
+// is checked before Update.end() commits.
+class OtaPipeline {
+private:
+    struct Chunk {
+        uint8_t index;
+        uint16_t length;  // 0 tells the writer to stop
+    };
+
+    static const int MAX_BUFFERS = 8;
+
+    uint8_t* buffers[MAX_BUFFERS];
+    int bufferCount;
+    QueueHandle_t filledQueue;  // Chunk, ingest -> writer
+    QueueHandle_t freeQueue;    // buffer index, writer -> ingest
+    SemaphoreHandle_t writerDone;
+    TaskHandle_t writerTask;
+    volatile bool writeFailed;
+    volatile bool compressed;
+    volatile bool delta;
+    DeltaPatch* patch;
+    ImageVerifier verifier;
+    ImageVerifier::Result signature;
+    size_t payloadBytes;
+    volatile size_t bytesWritten;
+    int heldIndex;     // buffer the writer is reading, -1 when none
+    bool writerStopped;
+    size_t bytesReceived;
+    int fillIndex;
+    size_t fillLength;
+    bool active;
+
+    static void writerLoop(void* arg) {
+        OtaPipeline* self = static_cast<OtaPipeline*>(arg);
+        self->runWriter();
+        xSemaphoreGive(self->writerDone);
+        vTaskDelete(NULL);
+    }
+
+    // Writer side: hands the previous buffer back to the ingest side and
+    // takes the next filled one. Returns false once the stop marker arrives.
+    bool nextChunk(const uint8_t** data, size_t* length) {
+        if (heldIndex >= 0) {
+            uint8_t index = heldIndex;
+            xQueueSend(freeQueue, &index, portMAX_DELAY);
+            heldIndex = -1;
+        }
+        if (writerStopped) {
+            return false;
+        }
+        Chunk chunk;
+        xQueueReceive(filledQueue, &chunk, portMAX_DELAY);
+        if (chunk.length == 0) {
+            writerStopped = true;
+            return false;
+        }
+        heldIndex = chunk.index;
+        *data = buffers[chunk.index];
+        *length = chunk.length;
+        return true;
+    }
+
+    bool flashWrite(const uint8_t* data, size_t length) {
+        if (Update.write(const_cast<uint8_t*>(data), length) != length) {
+            writeFailed = true;
+            return false;
+        }
+        bytesWritten += length;
+        return true;
+    }
+
+    // Decoded payload: either the image itself or a delta patch, told apart
+    // by the first bytes
+    bool consume(const uint8_t* data, size_t length) {
+        if (payloadBytes == 0 && DeltaPatch::isPatch(data, length)) {
+            delta = true;
+            patch = new DeltaPatch(esp_ota_get_running_partition(),
+                [this](const uint8_t* out, size_t outLength) {
+                    return verifier.write(out, outLength);
+                });
+        }
+        payloadBytes += length;
+        if (patch) {
+            if (!patch->write(data, length)) {
+                writeFailed = true;
+                return false;
+            }
+            return true;
+        }
+        return verifier.write(data, length);
+    }
+
+    void runWriter() {
+        const uint8_t* data;
+        size_t length;
+        verifier.begin([this](const uint8_t* out, size_t outLength) {
+            return flashWrite(out, outLength);
+        });
+        if (!nextChunk(&data, &length)) {
+            return;
+        }
+
+        if (InflateStream::isGzip(data, length)) {
+            compressed = true;
+            InflateStream* inflater = new InflateStream();
+            bool ok = inflater->run(data, length,
+                [this](const uint8_t** next, size_t* nextLength) {
+                    return nextChunk(next, nextLength);
+                },
+                [this](const uint8_t* out, size_t outLength) {
+                    return consume(out, outLength);
+                });
+            delete inflater;
+            if (!ok) {
+                writeFailed = true;
+            }
+        } else {
+            do {
+                if (!writeFailed) {
+                    consume(data, length);
+                }
+            } while (nextChunk(&data, &length));
+        }
+
+        if (patch) {
+            if (!patch->finish()) {
+                writeFailed = true;
+            }
+            if (writeFailed) {
+                Serial.printf("Delta patch: %s\n", patch->errorString());
+            }
+            delete patch;
+            patch = nullptr;
+        }
+
+        if (!writeFailed) {
+            signature = verifier.finish();
+            if (signature == ImageVerifier::VERIFY_BAD_SIGNATURE ||
+                signature == ImageVerifier::VERIFY_BAD_KEY ||
+                (signature == ImageVerifier::VERIFY_UNSIGNED && OTA_REQUIRE_SIGNATURE)) {
+                writeFailed = true;
+            }
+            Serial.printf("Image: %s\n", ImageVerifier::resultString(signature));
+        }
+
+        // Keep draining after a failure so the ingest side never blocks
+        while (nextChunk(&data, &length)) {
+        }
+    }
+
+    bool submit() {
+        Chunk chunk = { (uint8_t)fillIndex, (uint16_t)fillLength };
+        xQueueSend(filledQueue, &chunk, portMAX_DELAY);
+        uint8_t next;
+        xQueueReceive(freeQueue, &next, portMAX_DELAY);
+        fillIndex = next;
+        fillLength = 0;
+        return !writeFailed;
+    }
+
+    void stopWriter() {
+        Chunk stop = { 0, 0 };
+        xQueueSend(filledQueue, &stop, portMAX_DELAY);
+        xSemaphoreTake(writerDone, portMAX_DELAY);
+    }
+
+    void release() {
+        vQueueDelete(filledQueue);
+        vQueueDelete(freeQueue);
+        vSemaphoreDelete(writerDone);
+        for (int i = 0; i < bufferCount; i++) {
+            delete[] buffers[i];
+            buffers[i] = nullptr;
+        }
+        active = false;
+    }
+
+public:
+    OtaPipeline() :
+        bufferCount(0),
+        writerTask(nullptr),
+        writeFailed(false),
+        compressed(false),
+        delta(false),
+        patch(nullptr),
+        signature(ImageVerifier::VERIFY_UNSIGNED),
+        payloadBytes(0),
+        bytesWritten(0),
+        heldIndex(-1),
+        writerStopped(false),
+        bytesReceived(0),
+        fillIndex(0),
+        fillLength(0),
+        active(false) {
+        for (int i = 0; i < MAX_BUFFERS; i++) {
+            buffers[i] = nullptr;
+        }
+    }
+
+    // More buffers let a caller hand over a larger block without waiting
+    // for flash, at OTA_BUFFER_SIZE of heap each.
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int count = 2) {
+        if (active) {
+            abort();
+        }
+        if (!Update.begin(size)) {
+            return false;
+        }
+
+        bufferCount = constrain(count, 2, MAX_BUFFERS);
+        for (int i = 0; i < bufferCount; i++) {
+            buffers[i] = new uint8_t[OTA_BUFFER_SIZE];
+        }
+        filledQueue = xQueueCreate(bufferCount, sizeof(Chunk));
+        freeQueue = xQueueCreate(bufferCount, sizeof(uint8_t));
+        writerDone = xSemaphoreCreateBinary();
+
+        // Buffer 0 fills first; the rest wait in the free queue
+        for (uint8_t spare = 1; spare < bufferCount; spare++) {
+            xQueueSend(freeQueue, &spare, 0);
+        }
+        fillIndex = 0;
+        fillLength = 0;
+        writeFailed = false;
+        compressed = false;
+        delta = false;
+        signature = ImageVerifier::VERIFY_UNSIGNED;
+        payloadBytes = 0;
+        bytesWritten = 0;
+        heldIndex = -1;
+        writerStopped = false;
+        bytesReceived = 0;
+        active = true;
+
+        xTaskCreatePinnedToCore(writerLoop, "ota_writer", OTA_WRITER_STACK, this,
+                                OTA_WRITER_PRIORITY, &writerTask, OTA_WRITER_CORE);
+        return true;
+    }
+
+    // Copies the chunk into the fill buffer; blocks only when every buffer
+    // is full and the writer has not finished the oldest one yet.
+    bool write(const uint8_t* data, size_t length) {
+        if (!active || writeFailed) {
+            return false;
+        }
+        bytesReceived += length;
+        while (length > 0) {
+            size_t n = min(length, (size_t)OTA_BUFFER_SIZE - fillLength);
+            memcpy(buffers[fillIndex] + fillLength, data, n);
+            fillLength += n;
+            data += n;
+            length -= n;
+            if (fillLength == OTA_BUFFER_SIZE && !submit()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Flushes the partial buffer, waits for the writer to drain and commits
+    bool end() {
+        if (!active) {
+            return false;
+        }
+        if (fillLength > 0 && !writeFailed) {
+            submit();
+        }
+        stopWriter();
+        if (writeFailed) {
+            // Leave the inactive slot unbootable and Update ready for a retry
+            Update.abort();
+        }
+        bool ok = !writeFailed && Update.end(true);
+        release();
+        return ok;
+    }
+
+    void abort() {
+        if (!active) {
+            return;
+        }
+        stopWriter();
+        Update.abort();
+        release();
+    }
+
+    bool isActive() {
+        return active;
+    }
+
+    bool hasError() {
+        return writeFailed || Update.hasError();
+    }
+
+    // True once the writer has seen a gzip header on this upload
+    bool isCompressed() {
+        return compressed;
+    }
+
+    // True once the writer has seen a delta patch header on this upload
+    bool isDelta() {
+        return delta;
+    }
+
+    // Outcome of the signature check for the last finished upload
+    ImageVerifier::Result signatureResult() {
+        return signature;
+    }
+
+    size_t received() {
+        return bytesReceived;
+    }
+
+    // Bytes flashed, after decompression
+    size_t written() {
+        return bytesWritten;
+    }
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef OTA_PROGRESS_H
+#define OTA_PROGRESS_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <functional>
+#include "config.h"
+#include "ota_pipeline.h"
+
+// Upload progress for the OLED and for tools watching GET /update/events.
+// The pipeline already counts what it has received and flashed; update()
+// runs after every piece the server hands over and returns after one
+// millis() until OTA_PROGRESS_INTERVAL_MS has passed. When it is due,
+// every listener gets a Server-Sent Event
+//
+//   event: progress
+//   data: {"state":"receiving","received":N,"written":W,"total":T}
+//
+// and onChange() hears the new percentage. Events keep coming at that
+// interval while data flows, so a stream that goes quiet for a few
+// intervals is a stalled transfer. The final state always goes out.
+// Lives on the OTA server's task, next to the handlers that feed it.
+class OtaProgress {
+public:
+    enum State {
+        OTA_IDLE,
+        OTA_RECEIVING,
+        OTA_DONE,
+        OTA_FAILED,
+        OTA_ABORTED
+    };
+
+    // percent is -1 while the total is unknown
+    typedef std::function<void(State state, int percent)> ChangeCallback;
+
+    explicit OtaProgress(OtaPipeline& pipeline) :
+        pipeline(pipeline),
+        state(OTA_IDLE),
+        total(0),
+        lastSent(0),
+        lastPercent(-1),
+        clientCount(0) {}
+
+    void onChange(ChangeCallback callback) {
+        changeCallback = callback;
+    }
+
+    // Answers GET /update/events: the stream stays open after the handler
+    // returns. A listener past OTA_EVENT_CLIENTS replaces the oldest, which
+    // is most likely a tool that went away without closing.
+    void addClient(WiFiClient client) {
+        client.print("HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/event-stream\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: keep-alive\r\n\r\n");
+        if (clientCount == OTA_EVENT_CLIENTS) {
+            clients[0].stop();
+            for (int i = 1; i < clientCount; i++) {
+                clients[i - 1] = clients[i];
+            }
+            clientCount--;
+        }
+        clients[clientCount++] = client;
+        char event[OTA_EVENT_SIZE];
+        sendEvent(clients[clientCount - 1], event, formatEvent(event));
+    }
+
+    // An upload has started; total is 0 when it is not known
+    void begin(size_t expected) {
+        state = OTA_RECEIVING;
+        total = expected;
+        lastPercent = -1;
+        publish();
+    }
+
+    void update() {
+        if (state == OTA_RECEIVING && millis() - lastSent >= OTA_PROGRESS_INTERVAL_MS) {
+            publish();
+        }
+    }
+
+    // The upload's outcome; ignored when none is in progress
+    void finish(State result) {
+        if (state != OTA_RECEIVING) {
+            return;
+        }
+        state = result;
+        publish();
+    }
+
+    State currentState() {
+        return state;
+    }
+
+private:
+    OtaPipeline& pipeline;
+    ChangeCallback changeCallback;
+    State state;
+    size_t total;
+    unsigned long lastSent;
+    int lastPercent;
+    WiFiClient clients[OTA_EVENT_CLIENTS];
+    int clientCount;
+
+    static const char* stateName(State state) {
+        switch (state) {
+            case OTA_RECEIVING: return "receiving";
+            case OTA_DONE:      return "done";
+            case OTA_FAILED:    return "failed";
+            case OTA_ABORTED:   return "aborted";
+            default:            return "idle";
+        }
+    }
+
+    size_t formatEvent(char* event) {
+        int n = snprintf(event, OTA_EVENT_SIZE,
+                         "event: progress\n"
+                         "data: {\"state\":\"%s\",\"received\":%u,\"written\":%u,\"total\":%u}\n\n",
+                         stateName(state), (unsigned)pipeline.received(),
+                         (unsigned)pipeline.written(), (unsigned)total);
+        return n < OTA_EVENT_SIZE ? n : OTA_EVENT_SIZE - 1;
+    }
+
+    static bool sendEvent(WiFiClient& client, const char* event, size_t length) {
+        return client.connected() && client.write((const uint8_t*)event, length) == length;
+    }
+
+    void publish() {
+        lastSent = millis();
+        if (clientCount > 0) {
+            char event[OTA_EVENT_SIZE];
+            size_t length = formatEvent(event);
+            int kept = 0;
+            for (int i = 0; i < clientCount; i++) {
+                if (sendEvent(clients[i], event, length)) {
+                    clients[kept++] = clients[i];
+                } else {
+                    clients[i].stop();
+                }
+            }
+            for (int i = kept; i < clientCount; i++) {
+                clients[i] = WiFiClient();
+            }
+            clientCount = kept;
+        }
+
+        int percent = -1;
+        if (total > 0) {
+            size_t received = pipeline.received();
+            percent = received >= total ? 100 : (int)(received * 100 / total);
+        }
+        if (changeCallback && (percent != lastPercent || state != OTA_RECEIVING)) {
+            changeCallback(state, percent);
+        }
+        lastPercent = percent;
+    }
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef OTA_RESUME_H
+#define OTA_RESUME_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "crc32.h"
+#include "ota_pipeline.h"
+
+// Resumable upload protocol on top of OtaPipeline:
+//
+//   PUT /update?offset=N&crc=XXXXXXXX[&total=T]   body: next chunk (<= OTA_CHUNK_SIZE)
+//   GET /update/status                            -> {"active":..,"offset":N,"total":T,"chunk":C}
+//
+// offset=0 with total=T starts a session. Each chunk is staged in RAM and
+// only handed to the pipeline once its CRC-32 checks out, so a link drop
+// mid-chunk loses nothing that was already committed: the client reads
+// the status and resends from the returned offset. The payload may be
+// anything /update accepts (raw, gzip or delta).
+class OtaResume {
+public:
+    enum Result {
+        RESUME_IDLE,
+        RESUME_ACCEPTED,
+        RESUME_COMPLETE,
+        RESUME_BAD_OFFSET,
+        RESUME_BAD_CRC,
+        RESUME_TOO_LARGE,
+        RESUME_FAILED
+    };
+
+    explicit OtaResume(OtaPipeline& pipeline) :
+        pipeline(pipeline),
+        staging(nullptr),
+        active(false),
+        receiving(false),
+        result(RESUME_IDLE),
+        totalSize(0),
+        committed(0),
+        chunkLength(0),
+        chunkCrc(0),
+        expectedCrc(0),
+        lastActivity(0) {}
+
+    // RAW_START: decides whether the incoming chunk can be taken
+    void beginChunk(size_t offset, uint32_t crc, size_t total) {
+        lastActivity = millis();
+        receiving = false;
+        chunkLength = 0;
+        chunkCrc = 0;
+        expectedCrc = crc;
+        if (active && !pipeline.isActive()) {
+            stop();  // a plain POST upload took the pipeline over
+        }
+        if (offset == 0 && total > 0 && !start(total)) {
+            result = RESUME_FAILED;
+            return;
+        }
+        if (!active || offset != committed) {
+            result = RESUME_BAD_OFFSET;
+            return;
+        }
+        receiving = true;
+        result = RESUME_ACCEPTED;
+    }
+
+    // RAW_WRITE
+    void chunkData(const uint8_t* data, size_t length) {
+        if (!receiving) {
+            return;
+        }
+        if (chunkLength + length > OTA_CHUNK_SIZE || committed + chunkLength + length > totalSize) {
+            receiving = false;
+            result = RESUME_TOO_LARGE;
+            return;
+        }
+        memcpy(staging + chunkLength, data, length);
+        chunkLength += length;
+        chunkCrc = crc32Update(chunkCrc, data, length);
+    }
+
+    // RAW_END: commits the staged chunk, and the image once it is complete
+    void endChunk() {
+        if (!receiving) {
+            return;
+        }
+        receiving = false;
+        lastActivity = millis();
+        if (chunkCrc != expectedCrc) {
+            result = RESUME_BAD_CRC;
+            return;
+        }
+        if (!pipeline.write(staging, chunkLength)) {
+            pipeline.abort();
+            stop();
+            result = RESUME_FAILED;
+            return;
+        }
+        committed += chunkLength;
+        if (committed == totalSize) {
+            result = pipeline.end() ? RESUME_COMPLETE : RESUME_FAILED;
+            stop();
+        }
+    }
+
+    // RAW_ABORTED: the link dropped; the session stays at the last commit
+    void abortChunk() {
+        receiving = false;
+        result = RESUME_IDLE;
+        lastActivity = millis();
+    }
+
+    // Releases a session the client never came back to
+    void poll() {
+        if (active && !receiving && millis() - lastActivity > OTA_SESSION_TIMEOUT) {
+            Serial.printf("Resumable update timed out at %u/%u\n", (unsigned)committed,
+                          (unsigned)totalSize);
+            pipeline.abort();
+            stop();
+        }
+    }
+
+    Result lastResult() {
+        return result;
+    }
+
+    int httpCode() {
+        switch (result) {
+            case RESUME_BAD_OFFSET: return 409;
+            case RESUME_BAD_CRC:    return 400;
+            case RESUME_TOO_LARGE:  return 413;
+            case RESUME_FAILED:     return 500;
+            default:                return 200;
+        }
+    }
+
+    String statusJson() {
+        char json[96];
+        snprintf(json, sizeof(json), "{\"active\":%s,\"offset\":%u,\"total\":%u,\"chunk\":%u}",
+                 active ? "true" : "false", (unsigned)committed, (unsigned)totalSize,
+                 (unsigned)OTA_CHUNK_SIZE);
+        return String(json);
+    }
+
+    bool isActive() {
+        return active;
+    }
+
+    size_t offset() {
+        return committed;
+    }
+
+private:
+    OtaPipeline& pipeline;
+    uint8_t* staging;
+    bool active;
+    bool receiving;
+    Result result;
+    size_t totalSize;
+    size_t committed;
+    size_t chunkLength;
+    uint32_t chunkCrc;
+    uint32_t expectedCrc;
+    unsigned long lastActivity;
+
+    bool start(size_t total) {
+        stop();
+        // Enough buffers that a verified chunk is handed over without
+        // waiting for flash, which then overlaps receiving the next one
+        if (!pipeline.begin(UPDATE_SIZE_UNKNOWN, OTA_CHUNK_SIZE / OTA_BUFFER_SIZE + 1)) {
+            Update.printError(Serial);
+            return false;
+        }
+        staging = new uint8_t[OTA_CHUNK_SIZE];
+        active = true;
+        totalSize = total;
+        committed = 0;
+        return true;
+    }
+
+    void stop() {
+        delete[] staging;
+        staging = nullptr;
+        active = false;
+    }
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+// What the Settings menu changes, kept across restarts. begin() reads all
+// of it from NVS as one blob; the setters only change the copy in RAM and
+// restart a SETTINGS_COMMIT_DELAY_MS countdown, so stepping through the
+// brightness levels ends in one flash write rather than one per press.
+// The UI task changes them, waits for nextCommit() alongside its other
+// timers and calls commitIfDue(). Whatever restarts the device calls
+// commit() first, or a change still in its countdown is lost; that is
+// the OTA server's task or loop(), so writes to the values and to NVS
+// are serialised by a mutex.
+class Settings {
+public:
+    struct Values {
+        uint8_t version;
+        uint8_t brightness;    // 0 .. BRIGHTNESS_LEVELS - 1
+        uint8_t timeoutIndex;  // into SCREEN_TIMEOUT_OPTIONS
+        bool autoConnect;
+        bool otaAuth;
+    };
+
+    Settings() : dirty(false), changedAt(0) {
+        defaults(values);
+        lock = xSemaphoreCreateMutex();
+    }
+
+    ~Settings() {
+        vSemaphoreDelete(lock);
+    }
+
+    // False when nothing valid was stored; the defaults apply then
+    bool begin() {
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NAMESPACE, true)) {
+            return false;
+        }
+        Values stored;
+        bool valid = prefs.getBytes("values", &stored, sizeof(stored)) == sizeof(stored) &&
+                     stored.version == SETTINGS_VERSION;
+        prefs.end();
+        if (valid) {
+            values = stored;
+            if (values.brightness >= BRIGHTNESS_LEVELS) {
+                values.brightness = DEFAULT_BRIGHTNESS;
+            }
+            if (values.timeoutIndex >= timeoutCount()) {
+                values.timeoutIndex = 0;
+            }
+        }
+        return valid;
+    }
+
+    uint8_t brightness() { return values.brightness; }
+    uint8_t timeoutIndex() { return values.timeoutIndex; }
+    int timeoutSeconds() {
+        static const int timeouts[] = SCREEN_TIMEOUT_OPTIONS;
+        return timeouts[values.timeoutIndex];
+    }
+    bool autoConnect() { return values.autoConnect; }
+    bool otaAuth() { return values.otaAuth; }
+
+    void setBrightness(uint8_t level) { change(values.brightness, level); }
+    void setTimeoutIndex(uint8_t index) { change(values.timeoutIndex, (uint8_t)(index % timeoutCount())); }
+    void setAutoConnect(bool enabled) { change(values.autoConnect, enabled); }
+    void setOtaAuth(bool enabled) { change(values.otaAuth, enabled); }
+
+    static uint8_t timeoutCount() {
+        static const int timeouts[] = SCREEN_TIMEOUT_OPTIONS;
+        return sizeof(timeouts) / sizeof(timeouts[0]);
+    }
+
+    // ms until a pending write is due, -1 when there is none
+    long nextCommit() {
+        if (!dirty) {
+            return -1;
+        }
+        unsigned long since = millis() - changedAt;
+        return since < SETTINGS_COMMIT_DELAY_MS ? (long)(SETTINGS_COMMIT_DELAY_MS - since) : 0;
+    }
+
+    // Writes once the values have been left alone long enough
+    bool commitIfDue() {
+        return nextCommit() == 0 && commit();
+    }
+
+    // Writes now, if anything changed; from any task
+    bool commit() {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        bool written = write();
+        xSemaphoreGive(lock);
+        return written;
+    }
+
+    // Factory reset: back to the defaults, in NVS too
+    void reset() {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        Preferences prefs;
+        if (prefs.begin(SETTINGS_NAMESPACE, false)) {
+            prefs.clear();
+            prefs.end();
+        }
+        defaults(values);
+        dirty = false;
+        xSemaphoreGive(lock);
+    }
+
+private:
+    Values values;
+    bool dirty;
+    unsigned long changedAt;
+    SemaphoreHandle_t lock;  // held by change(), commit() and reset()
+
+    Settings(const Settings&) = delete;
+    Settings& operator=(const Settings&) = delete;
+
+    bool write() {
+        if (!dirty) {
+            return true;
+        }
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NAMESPACE, false)) {
+            Serial.println("Settings: NVS not available");
+            return false;
+        }
+        bool written = prefs.putBytes("values", &values, sizeof(values)) == sizeof(values);
+        prefs.end();
+        if (!written) {
+            Serial.println("Settings: write failed");
+            return false;
+        }
+        dirty = false;
+        return true;
+    }
+
+    static void defaults(Values& v) {
+        memset(&v, 0, sizeof(v));
+        v.version = SETTINGS_VERSION;
+        v.brightness = DEFAULT_BRIGHTNESS;
+        v.timeoutIndex = 0;
+        v.autoConnect = true;
+        v.otaAuth = false;
+    }
+
+    template <typename T>
+    void change(T& field, T value) {
+        if (field == value) {
+            return;
+        }
+        xSemaphoreTake(lock, portMAX_DELAY);
+        field = value;
+        dirty = true;
+        changedAt = millis();
+        xSemaphoreGive(lock);
+    }
+};
+
+#endif
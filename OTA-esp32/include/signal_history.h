@@ -0,0 +1,121 @@
+#ifndef SIGNAL_HISTORY_H
+#define SIGNAL_HISTORY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+
+// Recent RSSI samples per access point, so the list can show and sort by a
+// steady figure instead of one noisy reading. A fixed table keyed by a hash
+// of the BSSID: an access point lives in one of SIGNAL_HISTORY_WAYS slots
+// from its home slot, so a sample touches at most that many entries of
+// SIGNAL_HISTORY_DEPTH + 12 bytes, and nothing is allocated. When those
+// slots are all taken, the one heard from longest ago is given up.
+class SignalHistory {
+public:
+    struct Stats {
+        int8_t smoothed;  // EWMA, dBm
+        int8_t min;       // over the samples kept
+        int8_t max;
+        uint8_t samples;
+    };
+
+    SignalHistory() : generation(0) {
+        memset(entries, 0, sizeof(entries));
+    }
+
+    // Call once per scan, before its samples
+    void beginScan() {
+        generation++;
+    }
+
+    // Records one scan result; bssid may be null, then nothing is kept
+    Stats add(const uint8_t* bssid, int32_t rssi) {
+        int8_t sample = rssi < -128 ? -128 : (rssi > 0 ? 0 : (int8_t)rssi);
+        if (!bssid) {
+            Stats stats = { sample, sample, sample, 1 };
+            return stats;
+        }
+        Entry& entry = slotFor(hash(bssid));
+        if (entry.count == 0 || (uint16_t)(generation - entry.seen) > SIGNAL_HISTORY_EXPIRE) {
+            // New, or back after long enough that the old figures mean little
+            entry.ewma = sample * 16;
+            entry.head = 0;
+            entry.count = 0;
+            entry.min = sample;
+            entry.max = sample;
+        }
+        entry.seen = generation;
+        entry.ewma += (sample * 16 - entry.ewma) / (1 << SIGNAL_EWMA_SHIFT);
+
+        int8_t dropped = entry.samples[entry.head];
+        bool full = entry.count == SIGNAL_HISTORY_DEPTH;
+        entry.samples[entry.head] = sample;
+        entry.head = (entry.head + 1) % SIGNAL_HISTORY_DEPTH;
+        if (!full) {
+            entry.count++;
+        }
+        if (full && (dropped == entry.min || dropped == entry.max)) {
+            rescan(entry);  // the extreme just fell out of the window
+        } else {
+            entry.min = sample < entry.min ? sample : entry.min;
+            entry.max = sample > entry.max ? sample : entry.max;
+        }
+
+        Stats stats = { (int8_t)((entry.ewma + 8) >> 4), entry.min, entry.max, entry.count };
+        return stats;
+    }
+
+private:
+    struct Entry {
+        uint32_t key;      // BSSID hash, 0 when the slot is free
+        uint16_t seen;     // generation of the last sample
+        int16_t ewma;      // dBm in 1/16ths
+        int8_t samples[SIGNAL_HISTORY_DEPTH];
+        uint8_t head;      // where the next sample goes
+        uint8_t count;
+        int8_t min;
+        int8_t max;
+    };
+
+    Entry entries[SIGNAL_HISTORY_SLOTS];
+    uint16_t generation;
+
+    // FNV-1a; 0 is kept for free slots
+    static uint32_t hash(const uint8_t* bssid) {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < 6; i++) {
+            h = (h ^ bssid[i]) * 16777619u;
+        }
+        return h ? h : 1;
+    }
+
+    Entry& slotFor(uint32_t key) {
+        uint32_t home = key % SIGNAL_HISTORY_SLOTS;
+        Entry* stalest = nullptr;
+        for (uint32_t i = 0; i < SIGNAL_HISTORY_WAYS; i++) {
+            Entry& entry = entries[(home + i) % SIGNAL_HISTORY_SLOTS];
+            if (entry.key == key) {
+                return entry;
+            }
+            if (!stalest || entry.key == 0 ||
+                (stalest->key != 0 &&
+                 (uint16_t)(generation - entry.seen) > (uint16_t)(generation - stalest->seen))) {
+                stalest = &entry;
+            }
+        }
+        stalest->key = key;
+        stalest->count = 0;
+        return *stalest;
+    }
+
+    static void rescan(Entry& entry) {
+        entry.min = entry.max = entry.samples[0];
+        for (int i = 1; i < entry.count; i++) {
+            entry.min = entry.samples[i] < entry.min ? entry.samples[i] : entry.min;
+            entry.max = entry.samples[i] > entry.max ? entry.samples[i] : entry.max;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include <WebServer.h>
+#include "config.h"
+#include "web_assets.h"
+
+// Sends a page from web_assets.h exactly as stored, gzip compressed, with
+// its ETag and WEB_CACHE_CONTROL. A browser serves repeat visits from its
+// cache and, once that expires, gets a bare 304 while the firmware still
+// has the same page. Every browser takes gzip, so Accept-Encoding is not
+// checked. The server must collect If-None-Match, see collectAssetHeaders().
+inline void sendAsset(WebServer& server, const WebAsset& asset) {
+    server.sendHeader("Cache-Control", WEB_CACHE_CONTROL);
+    server.sendHeader("ETag", asset.etag);
+    if (server.header("If-None-Match") == asset.etag) {
+        server.send(304);
+        return;
+    }
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, asset.type, (PGM_P)asset.data, asset.length);
+}
+
+inline void collectAssetHeaders(WebServer& server) {
+    const char* keys[] = { "If-None-Match" };
+    server.collectHeaders(keys, 1);
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TASK_MESSAGES_H
+#define TASK_MESSAGES_H
+
+#include <stdint.h>
+
+// What loop() (network, core 1) and the UI task (core 0) send each other.
+// Neither side calls into the other's objects for anything that changes
+// state; it posts one of these instead.
+
+// To the UI task, on the UI queue
+enum UiMessageType {
+    UI_BUTTON,          // edge from a pin ISR: button, pressed
+    UI_SCAN_COMPLETE,   // value = networks found, 0 when the scan failed
+    UI_CONNECT_RESULT,  // value = 1 with an IP, else -reason (0 timed out)
+    UI_AP_MODE,         // value = 1 when the AP is up
+    UI_OTA_READY,       // mDNS and the OTA server are up
+    UI_OTA_PROGRESS,    // value = percent of the upload received
+    UI_OTA_RESULT       // value = 1 when the new image is in
+};
+
+struct UiMessage {
+    uint8_t type;
+    uint8_t button;
+    bool pressed;
+    int16_t value;
+    unsigned long time;  // millis() when posted
+};
+
+// To loop(), on the network queue
+enum NetCommand {
+    NET_START_SCAN,
+    NET_CONNECT,      // ssid, open network
+    NET_SET_AP_MODE   // enable
+};
+
+struct NetMessage {
+    uint8_t command;
+    bool enable;
+    char ssid[33];
+};
+
+#endif
@@ -0,0 +1,106 @@
+// Generated by tools/build_web.py from web/; do not edit.
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+struct WebAsset {
+    const char* type;
+    const char* etag;
+    const uint8_t* data;  // gzip
+    size_t length;
+};
+
+// web/setup.html: 2763 bytes, 2203 minified, 1175 gzip
+const uint8_t WEB_SETUP_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x56, 0x5f, 0x6f, 0xdb, 0x36,
+    0x10, 0x7f, 0xf7, 0xa7, 0xb8, 0x21, 0x18, 0x28, 0xa1, 0xb1, 0x2c, 0xa7, 0x49, 0xd6, 0xea, 0x5f,
+    0xd1, 0xa6, 0x29, 0x90, 0x87, 0xad, 0xc5, 0x52, 0x60, 0x0f, 0xc3, 0x10, 0xd0, 0x22, 0x65, 0x71,
+    0x91, 0x49, 0x81, 0xa4, 0xe2, 0xb8, 0xae, 0x5f, 0x86, 0x62, 0xd8, 0xf3, 0x30, 0xe4, 0x75, 0xdf,
+    0x2d, 0x9f, 0x60, 0x1f, 0x61, 0x47, 0x51, 0x8e, 0x9d, 0xac, 0x8b, 0x20, 0x40, 0x24, 0xef, 0xee,
+    0x77, 0xf7, 0xbb, 0xdf, 0xd1, 0xc9, 0x6a, 0xbb, 0x68, 0x8a, 0xac, 0xe6, 0x94, 0x15, 0x99, 0x15,
+    0xb6, 0xe1, 0xc5, 0x4f, 0xe2, 0x9d, 0x80, 0x4b, 0x6e, 0xbb, 0x36, 0x9b, 0xf8, 0x9d, 0x6c, 0xc1,
+    0x2d, 0x05, 0x49, 0x17, 0x3c, 0x27, 0x37, 0x82, 0x2f, 0x5b, 0xa5, 0x2d, 0x81, 0x52, 0x49, 0xcb,
+    0xa5, 0xcd, 0xc9, 0x52, 0x30, 0x5b, 0xe7, 0x8c, 0xdf, 0x88, 0x92, 0x8f, 0xfb, 0xc5, 0x21, 0x08,
+    0x29, 0xac, 0xa0, 0xcd, 0xd8, 0x94, 0xb4, 0xe1, 0xf9, 0x94, 0x14, 0x99, 0xb1, 0x2b, 0x0c, 0x35,
+    0x53, 0x6c, 0xb5, 0xae, 0xd0, 0x73, 0x5c, 0xd1, 0x85, 0x68, 0x56, 0xc9, 0x6b, 0x8d, 0x66, 0xe9,
+    0x82, 0xea, 0xb9, 0x90, 0xc9, 0x51, 0xdc, 0xde, 0xa6, 0x33, 0x5a, 0x5e, 0xcf, 0xb5, 0xea, 0x24,
+    0x4b, 0x0e, 0xaa, 0xd8, 0x3d, 0x9b, 0xc8, 0x61, 0x51, 0x21, 0xb9, 0x5e, 0x2f, 0xe8, 0xad, 0xc7,
+    0x48, 0x8e, 0x63, 0x67, 0x3d, 0x78, 0xc6, 0x40, 0x3b, 0xab, 0xf6, 0x7d, 0x97, 0xb5, 0xb0, 0x3c,
+    0x6d, 0x29, 0x63, 0x42, 0xce, 0x87, 0xc8, 0x4a, 0x33, 0xae, 0xc7, 0x9a, 0x32, 0xd1, 0x99, 0xe4,
+    0x45, 0xbf, 0x73, 0x3b, 0x36, 0x35, 0x65, 0x6a, 0x89, 0x11, 0x8e, 0xda, 0x5b, 0x38, 0xc6, 0x57,
+    0xcf, 0x67, 0x34, 0x88, 0x0f, 0xfb, 0x27, 0x9a, 0x86, 0x1b, 0xc3, 0x1b, 0x5e, 0xda, 0x43, 0x21,
+    0xdb, 0xce, 0xfe, 0x6c, 0x57, 0x2d, 0xb2, 0xd0, 0x52, 0x63, 0x96, 0x18, 0x8d, 0xfc, 0xb2, 0xf6,
+    0xc9, 0x4c, 0xe3, 0xf8, 0xdb, 0x07, 0xb0, 0x17, 0xbb, 0xbc, 0xf0, 0x13, 0xe2, 0x01, 0x38, 0x99,
+    0xe2, 0xc2, 0xa8, 0x46, 0x30, 0x38, 0x60, 0x8c, 0x3d, 0x49, 0x07, 0x91, 0x37, 0xfb, 0x10, 0xa6,
+    0x9b, 0x2d, 0x84, 0x45, 0x80, 0x7d, 0x3e, 0x8e, 0xcf, 0x5e, 0xbf, 0x3b, 0x89, 0xd3, 0x52, 0x35,
+    0x4a, 0x3f, 0xa9, 0x70, 0x7a, 0xf4, 0x50, 0x61, 0x22, 0x95, 0xe4, 0xe9, 0x5e, 0x62, 0xff, 0x41,
+    0x4a, 0xcb, 0x4e, 0x1b, 0x0c, 0xd1, 0x2a, 0x81, 0x4d, 0xd4, 0x5f, 0x05, 0x4e, 0x6a, 0x75, 0x83,
+    0x84, 0x3f, 0x82, 0x3f, 0xa1, 0xf1, 0xf1, 0xcb, 0x4d, 0x64, 0xc4, 0x5c, 0xd2, 0x66, 0xcd, 0x84,
+    0x69, 0x1b, 0xba, 0x4a, 0x84, 0x6c, 0xb0, 0x37, 0xe3, 0x59, 0xa3, 0xca, 0xeb, 0x01, 0xd6, 0xf1,
+    0xbd, 0x89, 0x34, 0xaf, 0x34, 0x37, 0xf5, 0xba, 0x6a, 0x14, 0xb5, 0x89, 0x16, 0xf3, 0xda, 0xa6,
+    0x96, 0xdf, 0xda, 0x31, 0xe3, 0xa5, 0xd2, 0xd4, 0x0a, 0x25, 0x7d, 0xae, 0xdb, 0x22, 0x4e, 0x90,
+    0xa1, 0xe9, 0x53, 0x11, 0x70, 0xce, 0xbf, 0xc2, 0x55, 0x3d, 0x5d, 0x7b, 0x1a, 0x0e, 0x9e, 0x3f,
+    0x7f, 0x3e, 0xd0, 0x3d, 0x9e, 0x29, 0x6b, 0xd5, 0xc2, 0xa3, 0xab, 0xd6, 0xc5, 0x5f, 0xef, 0x85,
+    0xc6, 0xc4, 0x2d, 0xb5, 0x9d, 0xd9, 0x3a, 0x9e, 0x9e, 0x9e, 0xa6, 0xbd, 0x16, 0x8d, 0xf8, 0xc4,
+    0x93, 0x38, 0x7a, 0xc9, 0x17, 0xdb, 0x40, 0x56, 0xb5, 0xc9, 0xd4, 0xb9, 0x64, 0x13, 0x2f, 0xdc,
+    0x6c, 0xe2, 0x67, 0xc4, 0x09, 0xb8, 0xc8, 0x98, 0xb8, 0x81, 0xb2, 0x41, 0x11, 0xe4, 0xe4, 0x41,
+    0x9a, 0xa8, 0xf1, 0x7a, 0xea, 0xa7, 0xe7, 0x4c, 0xc9, 0x4a, 0xcc, 0x3b, 0x5f, 0x21, 0x7a, 0x4e,
+    0x8b, 0x8c, 0x42, 0x8d, 0x6c, 0xe4, 0xe4, 0x80, 0x6c, 0x1d, 0x07, 0x72, 0x08, 0x28, 0x59, 0x36,
+    0xa2, 0xbc, 0xce, 0x09, 0xb2, 0xc4, 0x82, 0x30, 0xd5, 0x38, 0x7b, 0x5a, 0x42, 0x45, 0x1b, 0xc3,
+    0x49, 0xf1, 0xcf, 0xdf, 0x7f, 0x7d, 0x81, 0x1f, 0xbd, 0x6d, 0x36, 0xa1, 0x98, 0x81, 0xf6, 0x6f,
+    0xa5, 0xf4, 0x02, 0x70, 0x32, 0x6b, 0xc5, 0x72, 0xf2, 0xe1, 0xfd, 0xe5, 0x47, 0x02, 0xb4, 0x74,
+    0x80, 0x39, 0x99, 0x60, 0x52, 0x12, 0x35, 0x4b, 0x0a, 0xb8, 0xbc, 0xbc, 0x78, 0x9b, 0x40, 0xe6,
+    0x35, 0x3c, 0xcc, 0xb0, 0x31, 0x82, 0x11, 0x10, 0x6c, 0xf8, 0xc2, 0xda, 0xfc, 0xf1, 0x43, 0x6c,
+    0xf8, 0x30, 0xe8, 0x1b, 0x3d, 0x7b, 0x69, 0xc0, 0x13, 0xd9, 0x0f, 0x81, 0x76, 0x6b, 0xd4, 0x41,
+    0xc9, 0x6b, 0xd5, 0x60, 0x93, 0x72, 0x72, 0xee, 0x34, 0x05, 0x0f, 0x87, 0xbb, 0x94, 0xf7, 0x63,
+    0x0d, 0x32, 0x83, 0x1b, 0xda, 0x74, 0xb8, 0x3c, 0xdb, 0x66, 0x9c, 0x4d, 0x5c, 0x61, 0x8f, 0x28,
+    0xf6, 0x5d, 0xc3, 0x62, 0xde, 0x39, 0x41, 0x60, 0x31, 0x2d, 0x95, 0x7d, 0xfa, 0x95, 0x5b, 0x93,
+    0x22, 0xc6, 0x02, 0x70, 0xab, 0x00, 0xc9, 0x2d, 0x22, 0x5e, 0x9b, 0x1e, 0xcc, 0x2c, 0x68, 0xd3,
+    0x14, 0x1f, 0x6b, 0x0e, 0x8d, 0x30, 0x16, 0xba, 0x96, 0x51, 0xcb, 0x0d, 0x70, 0x14, 0xf5, 0x0a,
+    0x45, 0x06, 0x06, 0x35, 0x28, 0x99, 0x41, 0xdf, 0xde, 0x70, 0xcf, 0xe7, 0x6d, 0x7f, 0x95, 0xc1,
+    0x52, 0x34, 0x0d, 0x20, 0xed, 0x96, 0x6a, 0x0b, 0xb4, 0x72, 0x35, 0x99, 0xae, 0x2c, 0xb9, 0x31,
+    0x55, 0xd7, 0xc0, 0x40, 0x71, 0xdf, 0xe0, 0x21, 0xc2, 0x04, 0x73, 0xc6, 0x18, 0xa5, 0x16, 0xad,
+    0x2d, 0x6e, 0xa8, 0x06, 0x4b, 0xe7, 0x90, 0x03, 0x21, 0xe9, 0xa8, 0xea, 0x64, 0x6f, 0x0b, 0x33,
+    0xaa, 0x4d, 0xa0, 0x43, 0x58, 0x8f, 0x86, 0x36, 0x6b, 0x28, 0x72, 0x18, 0x9f, 0xc4, 0xf0, 0x0a,
+    0xc8, 0xfd, 0xdd, 0x6f, 0xf7, 0x77, 0x5f, 0xee, 0xef, 0x7e, 0xbf, 0xbf, 0xfb, 0x83, 0x40, 0x32,
+    0x9c, 0x9d, 0x3e, 0x3e, 0xbb, 0xda, 0x9d, 0x7c, 0xb7, 0x77, 0x72, 0xb5, 0xb7, 0xff, 0x62, 0xbb,
+    0x7f, 0xe5, 0x77, 0xc9, 0x95, 0xfb, 0x48, 0x47, 0x9b, 0x5d, 0x1e, 0xa6, 0x56, 0xcb, 0xc0, 0x11,
+    0xe3, 0x52, 0x71, 0xb9, 0x0e, 0x0a, 0xc9, 0x81, 0xa9, 0xb2, 0x5b, 0xe0, 0xc5, 0x1e, 0xcd, 0xb9,
+    0x3d, 0x6f, 0xb8, 0xfb, 0x7c, 0xb3, 0xba, 0x60, 0x81, 0x17, 0x4b, 0x78, 0x08, 0xd7, 0x9c, 0xb7,
+    0x68, 0xe7, 0x1d, 0xa2, 0xbe, 0x7f, 0xe9, 0x68, 0x58, 0xf9, 0xa1, 0x33, 0x51, 0xc3, 0xe5, 0xdc,
+    0xd6, 0x68, 0x15, 0xa7, 0x23, 0x87, 0x12, 0x6d, 0x5b, 0x13, 0x61, 0x77, 0xcf, 0x69, 0x59, 0x07,
+    0xdb, 0x4c, 0x02, 0xe9, 0x32, 0x18, 0xdc, 0x71, 0x56, 0x03, 0xc9, 0x97, 0xf0, 0xbe, 0x0f, 0x13,
+    0xf4, 0x64, 0xc9, 0x48, 0x23, 0x72, 0x08, 0xcf, 0x80, 0xe0, 0xf3, 0x0c, 0x64, 0xe4, 0x12, 0xc1,
+    0x0f, 0x3c, 0xc1, 0x1e, 0x76, 0x9a, 0xbb, 0x62, 0x01, 0xe7, 0xe4, 0xcf, 0xbe, 0x56, 0xe2, 0x4d,
+    0x03, 0x6f, 0xeb, 0x7c, 0xdd, 0x9a, 0xbd, 0x59, 0x84, 0xe4, 0x70, 0x70, 0x0e, 0x43, 0xe4, 0x02,
+    0x5f, 0x51, 0x41, 0xe0, 0xaa, 0x09, 0x1f, 0x15, 0x83, 0x59, 0xbb, 0xcd, 0x74, 0xf4, 0xbf, 0x4c,
+    0x78, 0xdd, 0x85, 0x91, 0xbb, 0xcb, 0xce, 0xfc, 0xcf, 0x20, 0x3a, 0x3d, 0xae, 0xd3, 0x33, 0xf0,
+    0x88, 0x73, 0x3f, 0xdf, 0x58, 0x6d, 0xc5, 0x2d, 0x32, 0x40, 0x26, 0xb4, 0x15, 0x93, 0xad, 0x03,
+    0x26, 0xb7, 0x86, 0x12, 0x99, 0xe1, 0x58, 0x83, 0x54, 0x63, 0x63, 0x95, 0xe6, 0xb8, 0xe9, 0xae,
+    0x1d, 0xae, 0x4d, 0xd2, 0x8b, 0xe9, 0x15, 0xda, 0x90, 0x8b, 0x6a, 0xfc, 0x03, 0x5e, 0x9a, 0xe3,
+    0xef, 0x29, 0x46, 0x21, 0xfe, 0x60, 0x83, 0x95, 0xaf, 0x37, 0xb0, 0x09, 0x47, 0x91, 0xad, 0xb9,
+    0xdc, 0xb1, 0xdb, 0x4b, 0xcd, 0xd5, 0xa9, 0x87, 0xcb, 0x0f, 0xbe, 0xc9, 0xe1, 0x28, 0x8e, 0x43,
+    0xf0, 0xfa, 0x4b, 0x47, 0x5e, 0xa4, 0x3a, 0x1a, 0x80, 0x5c, 0xb1, 0x01, 0x39, 0xff, 0x48, 0xe7,
+    0x48, 0xe4, 0xe7, 0xcf, 0xbd, 0x7a, 0xb7, 0x52, 0x8d, 0x7e, 0x35, 0x18, 0x32, 0xf4, 0x10, 0x4e,
+    0x41, 0x3d, 0x8f, 0x51, 0xe9, 0x12, 0xd9, 0x41, 0x22, 0xa2, 0x23, 0x77, 0x33, 0x1a, 0xee, 0x33,
+    0x6c, 0xae, 0xbd, 0x70, 0x57, 0x02, 0xb2, 0x1b, 0xb8, 0xbd, 0x43, 0x1c, 0x3f, 0xfc, 0x0b, 0x53,
+    0x9c, 0x1c, 0x3f, 0x2c, 0xc3, 0xe8, 0x4c, 0xfc, 0xed, 0x3a, 0xe9, 0xff, 0x29, 0xf9, 0x17, 0xb9,
+    0x63, 0xec, 0x66, 0x9b, 0x08, 0x00, 0x00,
+};
+const WebAsset WEB_SETUP_HTML = { "text/html", "\"c75f612d543e7047\"", WEB_SETUP_HTML_GZ, sizeof(WEB_SETUP_HTML_GZ) };
+
+// web/update.html: 151 bytes, 143 minified, 125 gzip
+const uint8_t WEB_UPDATE_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x55, 0x8c, 0x41, 0x0e, 0x83, 0x30,
+    0x0c, 0x04, 0xbf, 0xe2, 0x9b, 0x4f, 0x88, 0x0f, 0x10, 0xbe, 0x40, 0xa5, 0x96, 0x07, 0xb8, 0x24,
+    0x08, 0x4b, 0x71, 0x12, 0x51, 0x1b, 0x89, 0xdf, 0x37, 0x2d, 0x70, 0xe0, 0xb6, 0xab, 0x9d, 0xd9,
+    0x6e, 0xce, 0xab, 0x80, 0x04, 0x5d, 0xb2, 0x77, 0xf8, 0x18, 0x9e, 0x2f, 0x04, 0x9a, 0x94, 0x73,
+    0x72, 0xd8, 0x5a, 0xf1, 0xa4, 0x01, 0x21, 0xa4, 0x49, 0xf7, 0x12, 0x1c, 0x8a, 0x45, 0xe5, 0x42,
+    0xab, 0xb6, 0x3f, 0xad, 0xa9, 0x2b, 0x61, 0xdf, 0x71, 0x2a, 0xa6, 0x70, 0x10, 0x33, 0xc7, 0x2a,
+    0x24, 0x92, 0x9a, 0x4f, 0xfd, 0x0e, 0x7c, 0xec, 0x2d, 0xac, 0x08, 0x1b, 0x45, 0xab, 0x75, 0xbc,
+    0x98, 0xff, 0x63, 0xff, 0x05, 0x30, 0x49, 0xdd, 0xcc, 0x8f, 0x00, 0x00, 0x00,
+};
+const WebAsset WEB_UPDATE_HTML = { "text/html", "\"1fd5841cc59bb981\"", WEB_UPDATE_HTML_GZ, sizeof(WEB_UPDATE_HTML_GZ) };
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <string.h>
+#include "config.h"
+
+// The last network that gave us an address, kept in NVS so a restart can
+// go straight back to it: with its BSSID and channel the station skips
+// the all-channel scan WiFi.begin() starts with, and with
+// WIFI_CACHE_STATIC_IP the old lease skips DHCP as well. One blob, read
+// once and written only when something in it changed, to spare the flash.
+class WiFiCache {
+public:
+    struct Entry {
+        char ssid[33];
+        char password[65];
+        uint8_t bssid[6];
+        uint8_t channel;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+    };
+
+    WiFiCache() : loaded(false) {
+        memset(&entry, 0, sizeof(entry));
+    }
+
+    // False when nothing is cached, or it was written by a build with a
+    // different layout
+    bool load(Entry& out) {
+        if (!loaded) {
+            Preferences prefs;
+            if (prefs.begin(WIFI_CACHE_NAMESPACE, true)) {
+                if (prefs.getBytes("entry", &entry, sizeof(entry)) != sizeof(entry)) {
+                    memset(&entry, 0, sizeof(entry));
+                }
+                prefs.end();
+            }
+            loaded = true;
+        }
+        out = entry;
+        return entry.ssid[0] != '\0';
+    }
+
+    // fresh should be zeroed before it is filled, padding included
+    void save(const Entry& fresh) {
+        Entry current;
+        load(current);
+        if (memcmp(&fresh, &current, sizeof(current)) == 0) {
+            return;
+        }
+        Preferences prefs;
+        if (!prefs.begin(WIFI_CACHE_NAMESPACE, false)) {
+            Serial.println("WiFi cache: NVS not available");
+            return;
+        }
+        if (prefs.putBytes("entry", &fresh, sizeof(fresh)) == sizeof(fresh)) {
+            entry = fresh;
+        }
+        prefs.end();
+    }
+
+    void clear() {
+        Preferences prefs;
+        if (prefs.begin(WIFI_CACHE_NAMESPACE, false)) {
+            prefs.remove("entry");
+            prefs.end();
+        }
+        memset(&entry, 0, sizeof(entry));
+        loaded = true;
+    }
+
+private:
+    Entry entry;
+    bool loaded;
+};
+
+#endif
@@ -1,98 +1,425 @@
 #ifndef WIFI_SCANNER_H
 #define WIFI_SCANNER_H
 
+#include <atomic>
+#include <functional>
 #include <WiFi.h>
 #include <WebServer.h>
 #include "config.h"
+#include "http_task.h"
+#include "settings.h"
+#include "signal_history.h"
+#include "static_assets.h"
+#include "wifi_cache.h"
 
+enum ScanState {
+    SCAN_IDLE,
+    SCAN_RUNNING,
+    SCAN_COMPLETE
+};
+
+// Receives the number of networks found (0 when the scan failed)
+typedef std::function<void(int)> ScanCallback;
+
+enum ConnectState {
+    CONNECT_IDLE,
+    CONNECT_PENDING,
+    CONNECT_OK,
+    CONNECT_FAILED
+};
+
+// Receives how a connect() ended: connected, or why not (a
+// wifi_err_reason_t, 0 when it timed out)
+typedef std::function<void(bool connected, uint8_t reason)> ConnectCallback;
+
+// Plain data: a scan fills the table in place and nothing is allocated
 struct NetworkInfo {
-    String ssid;
-    int32_t rssi;
+    char ssid[33];    // up to 32 bytes, NUL-terminated
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;      // smoothed over recent scans; shown and sorted by
+    int8_t rssiLast;  // this scan's sample
+    int8_t rssiMin;   // over the last SIGNAL_HISTORY_DEPTH samples
+    int8_t rssiMax;
     wifi_auth_mode_t encryption;
     bool isConnected;
 };
 
+// Runs on the network side (loop()). Other tasks only read results:
+// each scan fills the list it is not showing and then swaps, and a
+// reader copies one entry at a time through getNetwork(), which tries
+// again if a scan finished under it.
 class WiFiScanner {
 private:
-    NetworkInfo networks[MAX_NETWORKS];
+    NetworkInfo networks[2][MAX_NETWORKS];
+    int networkCounts[2];
+    volatile uint8_t front;  // list getNetwork() reads from
+    volatile uint32_t scanGeneration;  // bumped by every swap, see getNetwork()
+    volatile uint32_t listVersion;     // bumped by a swap that changes what /api/networks
+                                       // shows; its ETag
+    SignalHistory history;
     int networkCount;
     unsigned long lastScanTime;
-    String connectedSSID;
+    unsigned long scanStartTime;
+    ScanState scanState;
+    ScanCallback scanCallback;
+    uint8_t scanChannel;     // of the scan in flight, 0 for all channels
+    uint8_t sweepChannel;    // next channel of the AP-mode sweep
+    uint8_t sweepBurst;      // channels left in this step
+    unsigned long lastSweepStep;
+    volatile unsigned long lastPortalAnswer;  // 0 until the portal has served anyone
+    volatile uint32_t portalAnswers;  // bumped by the AP server's handlers
+    uint32_t sweptAnswers;            // portalAnswers as of the last busy step
+    volatile ConnectState connectState;
+    volatile uint8_t connectOutcome;  // set by the event task: 0 none yet, else CONNECT_OK/FAILED
+    volatile uint8_t connectReason;
+    volatile unsigned long timeToIp;  // of the last connect that got an address, ms
+    unsigned long connectStart;
+    unsigned long connectTimeout;
+    char connectingSSID[33];
+    char connectingPassword[65];
+    WiFiCache cache;
+    bool cachedAttempt;    // the attempt in progress is reconnect()'s
+    bool lastConnectCached;
+    ConnectCallback connectCallback;
+    // The portal's connect request, started by poll() on loop()
+    volatile bool portalConnectRequested;
+    char portalSSID[33];
+    char portalPassword[65];
+    bool portalAttempt;    // the attempt in progress came from the portal
+    bool restartPending;   // the portal connected us; restart into station mode
+    unsigned long restartAt;
+    Settings* settings;    // written out before that restart
+    // Swapped like the network lists, so getConnectedSSID() can copy it
+    // from another task: see setConnectedSSID()
+    char connectedSSIDs[2][33];
+    volatile uint8_t ssidFront;
+    volatile uint32_t ssidGeneration;
     WebServer* apServer;
+    HttpTask* apHttp;      // polls apServer
     bool apMode;
 
+    // Puts net into list, strongest first by smoothed signal, so a single
+    // noisy reading neither reorders the list nor pushes an entry off it.
+    // Past MAX_NETWORKS the weakest is dropped.
+    static void insertRanked(NetworkInfo* list, int& count, const NetworkInfo& net) {
+        int at = count;
+        while (at > 0 && list[at - 1].rssi < net.rssi) {
+            at--;
+        }
+        if (at >= MAX_NETWORKS) {
+            return;
+        }
+        int last = count < MAX_NETWORKS ? count : MAX_NETWORKS - 1;
+        memmove(&list[at + 1], &list[at], (last - at) * sizeof(NetworkInfo));
+        list[at] = net;
+        count = last + 1;
+    }
+
+    // Whether /api/networks would show a and b the same
+    static bool sameAsShown(const NetworkInfo& a, const NetworkInfo& b) {
+        return strcmp(a.ssid, b.ssid) == 0 && a.rssi == b.rssi && a.rssiMin == b.rssiMin &&
+               a.rssiMax == b.rssiMax && a.encryption == b.encryption;
+    }
+
+    void finishScan(int16_t result) {
+        uint8_t back = front ^ 1;
+        NetworkInfo* list = networks[back];
+        int count = 0;
+        if (scanChannel != 0) {
+            // One channel of a sweep: the rest of the list stands as the
+            // other channels last showed it
+            const NetworkInfo* shown = networks[front];
+            for (int i = 0; i < networkCounts[front]; i++) {
+                if (result == WIFI_SCAN_FAILED || shown[i].channel != scanChannel) {
+                    list[count++] = shown[i];
+                }
+            }
+        }
+        if (result != WIFI_SCAN_FAILED) {
+            // Every result feeds the history; a full scan or a new sweep
+            // counts as the next round for its expiry
+            if (scanChannel <= 1) {
+                history.beginScan();
+            }
+            for (int i = 0; i < result; i++) {
+                const wifi_ap_record_t* record =
+                    (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+                if (!record) {
+                    continue;
+                }
+                SignalHistory::Stats stats = history.add(record->bssid, record->rssi);
+                NetworkInfo net;
+                memcpy(net.ssid, record->ssid, sizeof(net.ssid) - 1);
+                net.ssid[sizeof(net.ssid) - 1] = '\0';
+                memcpy(net.bssid, record->bssid, sizeof(net.bssid));
+                net.channel = record->primary;
+                net.rssi = stats.smoothed;
+                net.rssiLast = record->rssi;
+                net.rssiMin = stats.min;
+                net.rssiMax = stats.max;
+                net.encryption = record->authmode;
+                net.isConnected = strcmp(connectedSSIDs[ssidFront], net.ssid) == 0;
+                insertRanked(list, count, net);
+            }
+        }
+        // A sweep step mostly finds its channel as it was: keep the ETag
+        bool changed = count != networkCounts[front];
+        for (int i = 0; i < count && !changed; i++) {
+            changed = !sameAsShown(list[i], networks[front][i]);
+        }
+        networkCount = count;
+        networkCounts[back] = networkCount;
+        front = back;
+        scanGeneration++;  // after the swap: see getNetwork()
+        if (changed) {
+            listVersion++;
+        }
+        WiFi.scanDelete();
+
+        lastScanTime = millis();
+        scanState = SCAN_IDLE;
+        notifyScanComplete();
+    }
+
+    // Starts the sweep's next single-channel scan: WIFI_SWEEP_DWELL_MS on
+    // one channel and back, short enough that the soft-AP stays up and its
+    // clients keep their association
+    bool startChannelScan() {
+        int16_t result = WiFi.scanNetworks(true, true, WIFI_SWEEP_PASSIVE, WIFI_SWEEP_DWELL_MS,
+                                           sweepChannel);
+        if (result == WIFI_SCAN_FAILED) {
+            return false;
+        }
+        scanChannel = sweepChannel;
+        sweepChannel = sweepChannel % WIFI_SWEEP_CHANNELS + 1;
+        scanStartTime = millis();
+        scanState = SCAN_RUNNING;
+        return true;
+    }
+
+    void pollConnect() {
+        if (portalConnectRequested && connectState != CONNECT_PENDING) {
+            restartPending = false;
+            connect(portalSSID, portalPassword);
+            portalConnectRequested = false;
+            portalAttempt = true;
+        }
+        if (connectState == CONNECT_PENDING) {
+            uint8_t outcome = connectOutcome;
+            if (outcome == 0 && millis() - connectStart >= connectTimeout) {
+                connectState = CONNECT_FAILED;  // before the disconnect event can land
+                WiFi.disconnect();
+                outcome = CONNECT_FAILED;
+            }
+            if (outcome != 0) {
+                finishConnect(outcome == CONNECT_OK);
+            }
+        }
+        if (restartPending && (long)(millis() - restartAt) >= 0) {
+            settings->commit();  // a change still waiting out its delay
+            ESP.restart();
+            restartPending = false;
+        }
+    }
+
+    void finishConnect(bool connected) {
+        if (!connected && cachedAttempt) {
+            // Moved to another channel, or gone for now: the long way, once
+            Serial.printf("Cached connect to %s failed (reason %u), scanning\n", connectingSSID,
+                          (unsigned)connectReason);
+#if WIFI_CACHE_STATIC_IP
+            WiFi.config(IPAddress(), IPAddress(), IPAddress());  // back to DHCP
+#endif
+            connect(connectingSSID, connectingPassword);
+            return;
+        }
+        bool fromPortal = portalAttempt;
+        portalAttempt = false;
+        connectState = connected ? CONNECT_OK : CONNECT_FAILED;
+        if (connected) {
+            lastConnectCached = cachedAttempt;
+            cachedAttempt = false;
+            setConnectedSSID(connectingSSID);
+            Serial.printf("Connected to %s, IP after %lu ms\n", connectingSSID, timeToIp);
+            saveCache();
+            if (fromPortal) {
+                // Give the page time to show it, then start over in station mode
+                restartPending = true;
+                restartAt = millis() + WIFI_RESTART_DELAY_MS;
+            }
+        } else {
+            Serial.printf("WiFi connect failed: %s (reason %u)\n", connectingSSID,
+                          (unsigned)connectReason);
+        }
+        if (connectCallback) {
+            connectCallback(connected, connectReason);
+        }
+    }
+
+    // Fills the copy not on show and swaps, then bumps ssidGeneration, so
+    // a reader that raced the swap copies again
+    void setConnectedSSID(const char* ssid) {
+        uint8_t back = ssidFront ^ 1;
+        strncpy(connectedSSIDs[back], ssid, sizeof(connectedSSIDs[back]) - 1);
+        connectedSSIDs[back][sizeof(connectedSSIDs[back]) - 1] = '\0';
+        std::atomic_thread_fence(std::memory_order_release);  // the copy before the swap
+        ssidFront = back;
+        ssidGeneration++;
+    }
+
+    void saveCache() {
+        WiFiCache::Entry entry;
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.ssid, connectingSSID, sizeof(entry.ssid) - 1);
+        strncpy(entry.password, connectingPassword, sizeof(entry.password) - 1);
+        const uint8_t* bssid = WiFi.BSSID();
+        if (bssid) {
+            memcpy(entry.bssid, bssid, sizeof(entry.bssid));
+        }
+        entry.channel = WiFi.channel();
+        entry.ip = WiFi.localIP();
+        entry.gateway = WiFi.gatewayIP();
+        entry.subnet = WiFi.subnetMask();
+        entry.dns = WiFi.dnsIP();
+        cache.save(entry);
+    }
+
+    void notifyScanComplete() {
+        if (scanCallback) {
+            scanCallback(networkCount);
+        }
+    }
+
+    void beginSoftAP() {
+        IPAddress apIP(192, 168, AP_IP_OCTET, 1);
+        IPAddress gateway(192, 168, AP_IP_OCTET, 1);
+        IPAddress subnet(255, 255, 255, 0);
+        WiFi.softAPConfig(apIP, gateway, subnet);
+        WiFi.softAP(AP_SSID, AP_PASSWORD, AP_CHANNEL, false, AP_MAX_CONNECTIONS);
+    }
+
+    // Copies an SSID (at most 32 bytes) into a JSON string body; returns
+    // the length written. out needs room for 6 bytes per input byte.
+    static size_t jsonEscape(char* out, const char* in) {
+        size_t n = 0;
+        for (int i = 0; in[i] && i < 32; i++) {
+            unsigned char c = in[i];
+            if (c == '"' || c == '\\') {
+                out[n++] = '\\';
+                out[n++] = c;
+            } else if (c < 0x20) {
+                n += sprintf(out + n, "\\u%04x", c);
+            } else {
+                out[n++] = c;
+            }
+        }
+        out[n] = 0;
+        return n;
+    }
+
+    // Copies an SSID (at most 32 bytes) into HTML text; returns the length
+    // written. out needs room for 6 bytes per input byte.
+    static size_t htmlEscape(char* out, const char* in) {
+        size_t n = 0;
+        for (int i = 0; in[i] && i < 32; i++) {
+            switch (in[i]) {
+                case '&': n += sprintf(out + n, "&amp;"); break;
+                case '<': n += sprintf(out + n, "&lt;"); break;
+                case '>': n += sprintf(out + n, "&gt;"); break;
+                case '"': n += sprintf(out + n, "&quot;"); break;
+                case '\'': n += sprintf(out + n, "&#39;"); break;
+                default: out[n++] = in[i]; break;
+            }
+        }
+        out[n] = 0;
+        return n;
+    }
+
+    // Streams {"scan":G,"networks":[{"ssid":..,"rssi":..,"min":..,"max":..,
+    // "secure":..},..]}, rssi smoothed, min and max over recent scans,
+    // with chunked encoding, rows formatted into one stack buffer that goes
+    // out whenever the next row would not fit. The list version is the
+    // ETag, so a client that already has this list gets a bare 304.
+    void sendNetworksJson() {
+        unsigned long version = listVersion;
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"%lu\"", version);
+        apServer->sendHeader("ETag", etag);
+        apServer->sendHeader("Cache-Control", "no-cache");
+        if (apServer->header("If-None-Match") == etag) {
+            apServer->send(304);
+            return;
+        }
+        apServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        apServer->send(200, "application/json", "");
+
+        char chunk[AP_JSON_CHUNK_SIZE];
+        char ssid[6 * 32 + 1];
+        size_t used = snprintf(chunk, sizeof(chunk), "{\"scan\":%lu,\"networks\":[", version);
+        NetworkInfo net;
+        for (int i = 0; getNetwork(i, net); i++) {
+            jsonEscape(ssid, net.ssid);
+            for (;;) {
+                int n = snprintf(chunk + used, sizeof(chunk) - used,
+                                 "%s{\"ssid\":\"%s\",\"rssi\":%d,\"min\":%d,\"max\":%d,"
+                                 "\"secure\":%s}",
+                                 i > 0 ? "," : "", ssid, (int)net.rssi, net.rssiMin, net.rssiMax,
+                                 net.encryption != WIFI_AUTH_OPEN ? "true" : "false");
+                if (used + n < sizeof(chunk) || used == 0) {
+                    used = min(used + n, sizeof(chunk) - 1);
+                    break;
+                }
+                apServer->sendContent(chunk, used);  // row did not fit: flush, redo
+                used = 0;
+            }
+        }
+        if (used + 2 >= sizeof(chunk)) {
+            apServer->sendContent(chunk, used);
+            used = 0;
+        }
+        used += snprintf(chunk + used, sizeof(chunk) - used, "]}");
+        apServer->sendContent(chunk, used);
+        apServer->sendContent("", 0);  // last chunk
+    }
+
+    // Runs on the AP server's task once a handler has sent its answer
+    void portalAnswered() {
+        lastPortalAnswer = millis();
+        portalAnswers++;
+    }
+
     void setupAPServer() {
         if (!apServer) {
             apServer = new WebServer(80);
             
-            // Serve configuration page
+            collectAssetHeaders(*apServer);  // If-None-Match, also for /api/networks
+
+            // Serve configuration page; the script fetches the list itself
             apServer->on("/", HTTP_GET, [this]() {
-                String html = "<html><head>"
-                    "<title>WiFi Setup</title>"
-                    "<meta name='viewport' content='width=device-width, initial-scale=1'>"
-                    "<meta http-equiv='refresh' content='10'>"
-                    "<style>"
-                    "body { font-family: Arial; margin: 20px; background: #f0f0f0; }"
-                    ".container { max-width: 400px; margin: 0 auto; background: white; padding: 20px; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }"
-                    "select, input[type='password'] { width: 100%; padding: 8px; margin: 8px 0; border: 1px solid #ddd; border-radius: 4px; }"
-                    "input[type='submit'] { background: #4CAF50; color: white; padding: 12px; border: none; width: 100%; border-radius: 4px; cursor: pointer; }"
-                    "input[type='submit']:hover { background: #45a049; }"
-                    ".signal { display: inline-block; width: 20px; }"
-                    ".refresh { float: right; text-decoration: none; padding: 5px 10px; background: #eee; border-radius: 4px; }"
-                    "h1 { color: #333; margin-bottom: 20px; }"
-                    "option { padding: 5px; }"
-                    ".status { color: #666; font-size: 0.9em; margin-top: 15px; }"
-                    "</style>"
-                    "</head><body>"
-                    "<div class='container'>"
-                    "<h1>WiFi Configuration</h1>"
-                    "<a href='/' class='refresh'>🔄 Refresh</a><br><br>"
-                    "<form method='POST' action='/connect'>"
-                    "SSID: <select name='ssid'>";
-                
-                int count;
-                NetworkInfo* nets = getNetworks(&count);
-                for(int i = 0; i < count; i++) {
-                    String signalIcon;
-                    int rssi = nets[i].rssi;
-                    if (rssi >= -50) signalIcon = "▂▄▆█";
-                    else if (rssi >= -60) signalIcon = "▂▄▆_";
-                    else if (rssi >= -70) signalIcon = "▂▄__";
-                    else if (rssi >= -80) signalIcon = "▂___";
-                    else signalIcon = "____";
-
-                    html += "<option value='" + nets[i].ssid + "'>" + signalIcon + " " + nets[i].ssid;
-                    html += (nets[i].encryption != WIFI_AUTH_OPEN ? " 🔒" : "");
-                    html += " (" + String(rssi) + "dBm)</option>";
-                }
-                
-                html += "</select><br><br>";
-                html += "Password: <input type='password' name='password' placeholder='Enter password'><br><br>";
-                html += "<input type='submit' value='Connect'>";
-                html += "</form>"
-                    "<div class='status'>"
-                    "Found " + String(count) + " networks<br>"
-                    "<small>Page will refresh in <span id='countdown'>10</span> seconds</small><br>"
-                    "<small>Device will restart after successful connection</small>"
-                    "</div>"
-                    "<script>"
-                    "var count = 10;"
-                    "var counter = setInterval(function(){"
-                    "count--;"
-                    "document.getElementById('countdown').textContent = count;"
-                    "if(count <= 0) clearInterval(counter);"
-                    "}, 1000);"
-                    "</script>"
-                    "</div></body></html>";
-                apServer->send(200, "text/html", html);
+                sendAsset(*apServer, WEB_SETUP_HTML);
+                portalAnswered();
+            });
+
+            apServer->on("/api/networks", HTTP_GET, [this]() {
+                sendNetworksJson();
+                portalAnswered();
             });
             
-            // Handle connection request
+            // Handle connection request: loop() starts it, the page polls
+            // /api/connect for the outcome
             apServer->on("/connect", HTTP_POST, [this]() {
                 String ssid = apServer->arg("ssid");
                 String password = apServer->arg("password");
+                if (!portalConnectRequested) {
+                    strncpy(portalSSID, ssid.c_str(), sizeof(portalSSID) - 1);
+                    portalSSID[sizeof(portalSSID) - 1] = '\0';
+                    strncpy(portalPassword, password.c_str(), sizeof(portalPassword) - 1);
+                    portalPassword[sizeof(portalPassword) - 1] = '\0';
+                    portalConnectRequested = true;
+                }
                 
-                String html = "<html><head>"
+                static const char page[] = "<html><head>"
                     "<title>Connecting...</title>"
                     "<meta name='viewport' content='width=device-width, initial-scale=1'>"
                     "<style>"
@@ -100,162 +427,306 @@ private:
                     ".container { max-width: 400px; margin: 0 auto; background: white; padding: 20px; "
                     "border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); text-align: center; }"
                     ".spinner { border: 4px solid #f3f3f3; border-top: 4px solid #3498db; "
-                    "border-radius: 50%; width: 40px; height: 40px; margin: 20px auto; "
+                    "border-radius: 50%%; width: 40px; height: 40px; margin: 20px auto; "
                     "animation: spin 1s linear infinite; }"
-                    "@keyframes spin { 0% { transform: rotate(0deg); } "
-                    "100% { transform: rotate(360deg); } }"
+                    "@keyframes spin { 0%% { transform: rotate(0deg); } "
+                    "100%% { transform: rotate(360deg); } }"
                     "</style></head><body><div class='container'>"
                     "<h1>Connecting...</h1>"
                     "<div class='spinner'></div>"
-                    "<p>Attempting to connect to:<br><strong>" + ssid + "</strong></p>"
+                    "<p>Attempting to connect to:<br><strong>%s</strong></p>"
                     "<p>The device will restart if connection is successful.</p>"
-                    "<p>Please wait...</p>"
-                    "</div></body></html>";
-                
+                    "<p id='status'>Please wait...</p>"
+                    "</div><script>"
+                    "function poll() {"
+                    " fetch('/api/connect').then(r => r.json()).then(s => {"
+                    "  var status = document.getElementById('status');"
+                    "  if (s.state == 'connected') status.textContent = 'Connected in ' + s.ms + ' ms, restarting...';"
+                    "  else if (s.state == 'failed') status.textContent = 'Failed (reason ' + s.reason + ')';"
+                    "  else setTimeout(poll, 1000);"
+                    " }).catch(() => setTimeout(poll, 1000));"
+                    "}"
+                    "setTimeout(poll, 1000);"
+                    "</script></body></html>";
+
+                char name[6 * 32 + 1];
+                htmlEscape(name, ssid.c_str());
+                char html[sizeof(page) + sizeof(name)];
+                snprintf(html, sizeof(html), page, name);
                 apServer->send(200, "text/html", html);
-                    
-                // Try to connect
-                if(connect(ssid.c_str(), password.c_str())) {
-                    // Save credentials and restart
-                    delay(2000);
-                    ESP.restart();
-                }
+                portalAnswered();
+            });
+
+            // {"state":"connecting|connected|failed|idle","reason":R,"ms":T}
+            apServer->on("/api/connect", HTTP_GET, [this]() {
+                static const char* const names[] = { "idle", "connecting", "connected", "failed" };
+                char json[80];
+                snprintf(json, sizeof(json), "{\"state\":\"%s\",\"reason\":%u,\"ms\":%lu}",
+                         names[connectState], (unsigned)connectReason, (unsigned long)timeToIp);
+                apServer->sendHeader("Cache-Control", "no-cache");
+                apServer->send(200, "application/json", json);
+                portalAnswered();
             });
             
             apServer->begin();
+            apHttp = new HttpTask("ap_http", [this]() {
+                apServer->handleClient();
+            });
+            apHttp->start();
         }
     }
 
 public:
-    WiFiScanner() : 
+    explicit WiFiScanner(Settings* settings) : 
+        front(0),
+        scanGeneration(0),
+        listVersion(0),
         networkCount(0), 
         lastScanTime(0), 
-        connectedSSID(""), 
+        scanStartTime(0),
+        scanState(SCAN_IDLE),
+        scanChannel(0),
+        sweepChannel(1),
+        sweepBurst(0),
+        lastSweepStep(0),
+        lastPortalAnswer(0),
+        portalAnswers(0),
+        sweptAnswers(0),
+        connectState(CONNECT_IDLE),
+        connectOutcome(0),
+        connectReason(0),
+        timeToIp(0),
+        connectStart(0),
+        connectTimeout(WIFI_CONNECT_TIMEOUT),
+        cachedAttempt(false),
+        lastConnectCached(false),
+        portalConnectRequested(false),
+        portalAttempt(false),
+        restartPending(false),
+        restartAt(0),
+        settings(settings),
+        ssidFront(0),
+        ssidGeneration(0),
         apServer(nullptr),
+        apHttp(nullptr),
         apMode(false) {
+        networkCounts[0] = 0;
+        networkCounts[1] = 0;
+        connectingSSID[0] = '\0';
+        connectingPassword[0] = '\0';
+        connectedSSIDs[0][0] = '\0';
+        connectedSSIDs[1][0] = '\0';
+        // On the event task: only note the outcome, poll() acts on it.
+        // ASSOC_LEAVE is our own doing, WiFi.disconnect() or a begin() that
+        // left the previous AP, and may still be queued when the next
+        // attempt starts: it says nothing about that attempt.
+        WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+            if (connectState != CONNECT_PENDING || connectOutcome != 0) {
+                return;
+            }
+            if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+                timeToIp = millis() - connectStart;
+                connectOutcome = CONNECT_OK;
+            } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED &&
+                       info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) {
+                connectReason = info.wifi_sta_disconnected.reason;
+                connectOutcome = CONNECT_FAILED;
+            }
+        });
     }
 
     ~WiFiScanner() {
+        delete apHttp;
         if (apServer) {
             delete apServer;
         }
     }
 
-    bool scan() {
-        // In AP mode, we want to force a new scan regardless of interval
-        if (!apMode && (millis() - lastScanTime < WIFI_SCAN_INTERVAL)) {
-            return false;
+    // Starts an asynchronous scan and returns immediately; poll() finishes it
+    // and reports through the onScanComplete() callback. Within
+    // WIFI_SCAN_INTERVAL of the last scan the cached results are reported
+    // instead (AP mode always rescans).
+    bool startScan() {
+        if (scanState != SCAN_IDLE) {
+            return true;
         }
 
-        // Delete previous scan results
-        if (networkCount > 0) {
-            WiFi.scanDelete();
+        if (!apMode && networkCount > 0 && (millis() - lastScanTime < WIFI_SCAN_INTERVAL)) {
+            scanState = SCAN_COMPLETE;
+            return true;
         }
 
-        // Start new scan
-        networkCount = WiFi.scanNetworks(true, true); // async=true, show_hidden=true
-        delay(100); // Give some time for scan to start
-
-        // Wait for scan completion with timeout
-        int timeout = 10; // 5 seconds timeout
-        while (networkCount == WIFI_SCAN_RUNNING && timeout > 0) {
-            delay(500);
-            networkCount = WiFi.scanComplete();
-            timeout--;
+        int16_t result = WiFi.scanNetworks(true, true); // async=true, show_hidden=true
+        if (result == WIFI_SCAN_FAILED) {
+            return false;
         }
+        scanChannel = 0;
+        scanStartTime = millis();
+        scanState = SCAN_RUNNING;
+        return true;
+    }
 
-        if (networkCount == WIFI_SCAN_FAILED) {
-            networkCount = 0;
-            return false;
+    // Advances an in-flight scan and connection attempt; call once per
+    // loop(). Costs one WiFi.scanComplete() query while the radio is busy.
+    void poll() {
+        pollConnect();
+        if (scanState == SCAN_COMPLETE) {
+            scanState = SCAN_IDLE;
+            notifyScanComplete();
+            return;
         }
-        if (networkCount == 0) {
-            return false;
+        if (scanState != SCAN_RUNNING) {
+            return;
         }
 
-        // Store only up to MAX_NETWORKS
-        int count = min(networkCount, MAX_NETWORKS);
-        for (int i = 0; i < count; i++) {
-            networks[i].ssid = WiFi.SSID(i);
-            networks[i].rssi = WiFi.RSSI(i);
-            networks[i].encryption = WiFi.encryptionType(i);
-            networks[i].isConnected = (networks[i].ssid == connectedSSID);
+        int16_t result = WiFi.scanComplete();
+        if (result == WIFI_SCAN_RUNNING) {
+            if (millis() - scanStartTime < WIFI_SCAN_TIMEOUT) {
+                return;
+            }
+            result = WIFI_SCAN_FAILED;
         }
+        finishScan(result);
+    }
 
-        lastScanTime = millis();
-        return true;
+    bool isScanning() {
+        return scanState == SCAN_RUNNING;
     }
 
-    bool connect(const char* ssid, const char* password) {
-        WiFi.begin(ssid, password);
-        
-        // Wait for connection with timeout
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            attempts++;
+    void onScanComplete(ScanCallback callback) {
+        scanCallback = callback;
+    }
+
+    void onConnectResult(ConnectCallback callback) {
+        connectCallback = callback;
+    }
+
+    // Starts connecting and returns right away; the outcome comes through
+    // onConnectResult() from poll(), once the event task has heard GOT_IP
+    // or a disconnect, or after WIFI_CONNECT_TIMEOUT. A new attempt
+    // replaces one in progress. With channel and bssid the station goes
+    // straight to that access point instead of scanning for it.
+    bool connect(const char* ssid, const char* password, int32_t channel = 0,
+                 const uint8_t* bssid = nullptr) {
+        if (ssid != connectingSSID) {
+            strncpy(connectingSSID, ssid, sizeof(connectingSSID) - 1);
+            connectingSSID[sizeof(connectingSSID) - 1] = '\0';
         }
+        if (password != connectingPassword) {
+            strncpy(connectingPassword, password, sizeof(connectingPassword) - 1);
+            connectingPassword[sizeof(connectingPassword) - 1] = '\0';
+        }
+        connectOutcome = 0;
+        connectReason = 0;
+        portalAttempt = false;
+        cachedAttempt = false;
+        connectTimeout = WIFI_CONNECT_TIMEOUT;
+        connectStart = millis();
+        connectState = CONNECT_PENDING;
+        WiFi.begin(connectingSSID, connectingPassword, channel, bssid);
+        return true;
+    }
 
-        if (WiFi.status() == WL_CONNECTED) {
-            connectedSSID = String(ssid);
-            return true;
+    // At boot: back to the network the last successful connect cached,
+    // locked to its channel and BSSID, falling back to a full connect
+    // when that fails. False when nothing is cached.
+    bool reconnect() {
+        WiFiCache::Entry entry;
+        if (!cache.load(entry)) {
+            return false;
+        }
+#if WIFI_CACHE_STATIC_IP
+        if (entry.ip) {
+            WiFi.config(IPAddress(entry.ip), IPAddress(entry.gateway), IPAddress(entry.subnet),
+                        IPAddress(entry.dns));
         }
-        return false;
+#endif
+        connect(entry.ssid, entry.password, entry.channel, entry.bssid);
+        connectTimeout = WIFI_CACHE_CONNECT_TIMEOUT;
+        cachedAttempt = true;
+        return true;
+    }
+
+    // Factory reset: the next boot starts without a network
+    void forgetNetwork() {
+        cache.clear();
+    }
+
+    // Whether the last connect that got an address came from the cache
+    bool lastConnectWasCached() {
+        return lastConnectCached;
     }
 
     void disconnect() {
+        connectState = CONNECT_IDLE;
         WiFi.disconnect();
-        connectedSSID = "";
+        setConnectedSSID("");
+    }
+
+    ConnectState getConnectState() {
+        return connectState;
+    }
+
+    // From WiFi.begin() to an IP address, for the last connect that got one
+    unsigned long lastTimeToIp() {
+        return timeToIp;
     }
 
     void startAPMode() {
         WiFi.mode(WIFI_AP_STA);
         
         // Configure AP
-        IPAddress apIP(192, 168, AP_IP_OCTET, 1);
-        IPAddress gateway(192, 168, AP_IP_OCTET, 1);
-        IPAddress subnet(255, 255, 255, 0);
-        
-        WiFi.softAPConfig(apIP, gateway, subnet);
-        WiFi.softAP(AP_SSID, AP_PASSWORD, AP_CHANNEL, false, AP_MAX_CONNECTIONS);
-        
-        // Scan for networks in STA mode while AP is active
-        scan();
+        beginSoftAP();
         
         apMode = true;
+
+        // Scan for networks in STA mode while AP is active
+        startScan();
+
         setupAPServer();
     }
 
-    // Periodically scan in AP mode
+    // Keeps the list fresh in AP mode without taking the AP down: every
+    // WIFI_SWEEP_STEP_MS, WIFI_SWEEP_BURST channels are scanned one after
+    // the other and merged in, so a full sweep spreads its radio time over
+    // about WIFI_SCAN_INTERVAL. A request that comes in while the radio is
+    // on another channel waits for it, so while a phone is using the
+    // portal a step only follows an answer, when the phone has what it
+    // asked for and is least likely to ask again: fewer, longer steps that
+    // keep out of its way.
     void updateAPScan() {
-        static unsigned long lastForceRescan = 0;
-        
-        if (apMode) {
+        if (!apMode || scanState != SCAN_IDLE) {
+            return;
+        }
+        if (sweepBurst == 0) {
             unsigned long currentMillis = millis();
-            
-            // Force new scan every WIFI_SCAN_INTERVAL
-            if (currentMillis - lastForceRescan >= WIFI_SCAN_INTERVAL) {
-                lastForceRescan = currentMillis;
-                
-                // Temporarily disable AP to improve scan
-                WiFi.softAPdisconnect(false);
-                delay(100);
-                
-                // Perform scan
-                scan();
-                
-                // Restore AP
-                IPAddress apIP(192, 168, AP_IP_OCTET, 1);
-                IPAddress gateway(192, 168, AP_IP_OCTET, 1);
-                IPAddress subnet(255, 255, 255, 0);
-                WiFi.softAPConfig(apIP, gateway, subnet);
-                WiFi.softAP(AP_SSID, AP_PASSWORD, AP_CHANNEL, false, AP_MAX_CONNECTIONS);
+            if (currentMillis - lastSweepStep < WIFI_SWEEP_STEP_MS) {
+                return;
             }
+            bool portalBusy = lastPortalAnswer != 0 &&
+                              currentMillis - lastPortalAnswer < WIFI_PORTAL_ACTIVE_MS;
+            if (portalBusy) {
+                uint32_t answers = portalAnswers;
+                if (answers == sweptAnswers) {
+                    return;
+                }
+                sweptAnswers = answers;
+                sweepBurst = WIFI_SWEEP_BUSY_BURST;
+            } else {
+                sweepBurst = WIFI_SWEEP_BURST;
+            }
+            lastSweepStep = currentMillis;
         }
+        sweepBurst--;
+        startChannelScan();
     }
 
     void stopAPMode() {
         if (apMode) {
+            sweepBurst = 0;
             if (apServer) {
+                delete apHttp;  // lets a request in progress finish first
+                apHttp = nullptr;
                 apServer->stop();
                 delete apServer;
                 apServer = nullptr;
@@ -268,7 +739,7 @@ public:
 
     void handleClient() {
         if (apMode && apServer) {
-            apServer->handleClient();
+            apHttp->poll();  // only with HTTP_SERVER_TASKS 0
             updateAPScan();  // Keep scanning while in AP mode
         }
     }
@@ -293,17 +764,45 @@ public:
         return WiFi.softAPIP();
     }
 
-    NetworkInfo* getNetworks(int* count) {
-        *count = min(networkCount, MAX_NETWORKS);
-        return networks;
+    int getNetworkCount() {
+        return networkCounts[front];
+    }
+
+    // Copies entry index of the list on show; false past its end. A scan
+    // that swaps lists during the copy bumps scanGeneration, and the copy
+    // is made again from the new list, so it is never half of each.
+    bool getNetwork(int index, NetworkInfo& out) {
+        for (;;) {
+            uint32_t generation = scanGeneration;
+            uint8_t shown = front;
+            bool found = index < networkCounts[shown];
+            if (found) {
+                out = networks[shown][index];
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);  // the copy before the check
+            if (scanGeneration == generation) {
+                return found;
+            }
+        }
     }
 
     bool isConnected() {
         return WiFi.status() == WL_CONNECTED;
     }
 
-    String getConnectedSSID() {
-        return connectedSSID;
+    // Copies the SSID of the network we last connected to, "" if none,
+    // into out; safe from any task, like getNetwork()
+    void getConnectedSSID(char* out, size_t size) {
+        for (;;) {
+            uint32_t generation = ssidGeneration;
+            const char* shown = connectedSSIDs[ssidFront];
+            strncpy(out, shown, size - 1);
+            out[size - 1] = '\0';
+            std::atomic_thread_fence(std::memory_order_acquire);  // the copy before the check
+            if (ssidGeneration == generation) {
+                return;
+            }
+        }
     }
 
     IPAddress getIP() {
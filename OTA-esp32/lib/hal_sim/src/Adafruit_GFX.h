@@ -0,0 +1,130 @@
+#ifndef HAL_SIM_ADAFRUIT_GFX_H
+#define HAL_SIM_ADAFRUIT_GFX_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "Print.h"
+
+// Subset of Adafruit_GFX. Text uses the classic 6x8 cell of the built-in
+// font; glyph shapes are a deterministic stand-in so that changed text
+// changes pixels, which is all the benchmarks need.
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h)
+        : _width(w), _height(h), cursor_x(0), cursor_y(0), textsize(1),
+          textcolor(1), textbgcolor(1), wrap(true) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        for (int16_t i = 0; i < h; i++) {
+            drawPixel(x, y + i, color);
+        }
+    }
+
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        for (int16_t i = 0; i < w; i++) {
+            drawPixel(x + i, y, color);
+        }
+    }
+
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t i = x; i < x + w; i++) {
+            drawFastVLine(i, y, h, color);
+        }
+    }
+
+    virtual void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+        int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        int16_t err = dx + dy;
+        while (true) {
+            drawPixel(x0, y0, color);
+            if (x0 == x1 && y0 == y1) {
+                break;
+            }
+            int16_t e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y, h, color);
+        drawFastVLine(x + w - 1, y, h, color);
+    }
+
+    void setCursor(int16_t x, int16_t y) {
+        cursor_x = x;
+        cursor_y = y;
+    }
+    void setTextSize(uint8_t s) { textsize = s ? s : 1; }
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+    void setTextColor(uint16_t c, uint16_t bg) {
+        textcolor = c;
+        textbgcolor = bg;
+    }
+    void setTextWrap(bool w) { wrap = w; }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    size_t write(uint8_t c) override {
+        if (c == '\n') {
+            cursor_x = 0;
+            cursor_y += textsize * 8;
+        } else if (c != '\r') {
+            if (wrap && cursor_x + textsize * 6 > _width) {
+                cursor_x = 0;
+                cursor_y += textsize * 8;
+            }
+            drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+            cursor_x += textsize * 6;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg,
+                  uint8_t size) {
+        for (int8_t col = 0; col < 5; col++) {
+            uint8_t line = glyphColumn(c, col);
+            for (int8_t row = 0; row < 8; row++, line >>= 1) {
+                if (line & 1) {
+                    fillRect(x + col * size, y + row * size, size, size, color);
+                } else if (bg != color) {
+                    fillRect(x + col * size, y + row * size, size, size, bg);
+                }
+            }
+        }
+    }
+
+protected:
+    int16_t _width, _height;
+    int16_t cursor_x, cursor_y;
+    uint8_t textsize;
+    uint16_t textcolor, textbgcolor;
+    bool wrap;
+
+    static uint8_t glyphColumn(unsigned char c, int8_t col) {
+        if (c == ' ') {
+            return 0;
+        }
+        uint32_t h = (c * 2654435761u) ^ (col * 40503u);
+        return (h >> 13) & 0x7F;
+    }
+};
+
+#endif
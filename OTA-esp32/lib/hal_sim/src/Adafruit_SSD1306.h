@@ -0,0 +1,164 @@
+#ifndef HAL_SIM_ADAFRUIT_SSD1306_H
+#define HAL_SIM_ADAFRUIT_SSD1306_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+#include "sim.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_EXTERNALVCC 0x01
+
+#define SSD1306_MEMORYMODE 0x20
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+// Stand-in for the Adafruit driver. Framebuffer layout and the I2C traffic
+// of display()/ssd1306_command() follow the real library (v2.5): one
+// command per transaction, data in (I2C_BUFFER_LENGTH - 1) byte chunks, and
+// the bus raised to 400 kHz during transfers then restored to 100 kHz.
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t rst_pin = -1,
+                     uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL)
+        : Adafruit_GFX(w, h), wire(twi), i2caddr(0), wireClk(clkDuring),
+          restoreClk(clkAfter), buffer(nullptr) {
+        (void)rst_pin;
+    }
+
+    ~Adafruit_SSD1306() { delete[] buffer; }
+
+    bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0,
+               bool reset = true, bool periphBegin = true) {
+        (void)switchvcc;
+        (void)reset;
+        (void)periphBegin;
+        if (!buffer) {
+            buffer = new uint8_t[WIDTH() * ((HEIGHT() + 7) / 8)];
+        }
+        clearDisplay();
+        this->i2caddr = i2caddr;
+        static const uint8_t init[] = {
+            SSD1306_DISPLAYOFF, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40,
+            0x8D, 0x14, SSD1306_MEMORYMODE, 0x00, 0xA1, 0xC8, 0xDA, 0x12,
+            SSD1306_SETCONTRAST, 0xCF, 0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6,
+            0x2E, SSD1306_DISPLAYON,
+        };
+        transactionBegin();
+        for (uint8_t c : init) {
+            ssd1306_command1(c);
+        }
+        transactionEnd();
+        return true;
+    }
+
+    void display() {
+        sim::record("SSD1306.display");
+        transactionBegin();
+        static const uint8_t dlist1[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0};
+        ssd1306_commandList(dlist1, sizeof(dlist1));
+        ssd1306_command1(WIDTH() - 1);
+        size_t count = WIDTH() * ((HEIGHT() + 7) / 8);
+        const uint8_t* ptr = buffer;
+        wire->beginTransmission(i2caddr);
+        wire->write(static_cast<uint8_t>(0x40));
+        size_t bytesOut = 1;
+        while (count--) {
+            if (bytesOut >= I2C_BUFFER_LENGTH) {
+                wire->endTransmission();
+                wire->beginTransmission(i2caddr);
+                wire->write(static_cast<uint8_t>(0x40));
+                bytesOut = 1;
+            }
+            wire->write(*ptr++);
+            bytesOut++;
+        }
+        wire->endTransmission();
+        transactionEnd();
+    }
+
+    void clearDisplay() { memset(buffer, 0, WIDTH() * ((HEIGHT() + 7) / 8)); }
+
+    void dim(bool dim) {
+        transactionBegin();
+        ssd1306_command1(SSD1306_SETCONTRAST);
+        ssd1306_command1(dim ? 0 : 0xCF);
+        transactionEnd();
+    }
+
+    void ssd1306_command(uint8_t c) {
+        transactionBegin();
+        ssd1306_command1(c);
+        transactionEnd();
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || x >= WIDTH() || y < 0 || y >= HEIGHT()) {
+            return;
+        }
+        uint8_t* b = &buffer[x + (y / 8) * WIDTH()];
+        uint8_t bit = 1 << (y & 7);
+        switch (color) {
+            case SSD1306_WHITE: *b |= bit; break;
+            case SSD1306_BLACK: *b &= ~bit; break;
+            case SSD1306_INVERSE: *b ^= bit; break;
+        }
+    }
+
+    bool getPixel(int16_t x, int16_t y) {
+        if (x < 0 || x >= WIDTH() || y < 0 || y >= HEIGHT()) {
+            return false;
+        }
+        return buffer[x + (y / 8) * WIDTH()] & (1 << (y & 7));
+    }
+
+    uint8_t* getBuffer() { return buffer; }
+
+private:
+    TwoWire* wire;
+    uint8_t i2caddr;
+    uint32_t wireClk;
+    uint32_t restoreClk;
+    uint8_t* buffer;
+
+    int16_t WIDTH() const { return _width; }
+    int16_t HEIGHT() const { return _height; }
+
+    void transactionBegin() { wire->setClock(wireClk); }
+    void transactionEnd() { wire->setClock(restoreClk); }
+
+    void ssd1306_command1(uint8_t c) {
+        wire->beginTransmission(i2caddr);
+        wire->write(static_cast<uint8_t>(0x00));
+        wire->write(c);
+        wire->endTransmission();
+    }
+
+    void ssd1306_commandList(const uint8_t* c, uint8_t n) {
+        wire->beginTransmission(i2caddr);
+        wire->write(static_cast<uint8_t>(0x00));
+        size_t bytesOut = 1;
+        while (n--) {
+            if (bytesOut >= I2C_BUFFER_LENGTH) {
+                wire->endTransmission();
+                wire->beginTransmission(i2caddr);
+                wire->write(static_cast<uint8_t>(0x00));
+                bytesOut = 1;
+            }
+            wire->write(*c++);
+            bytesOut++;
+        }
+        wire->endTransmission();
+    }
+};
+
+#endif
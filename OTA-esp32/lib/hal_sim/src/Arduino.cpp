@@ -0,0 +1,148 @@
+#include "Arduino.h"
+
+#include <mutex>
+#include <vector>
+
+#include "sim.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const int SIM_PIN_COUNT = 40;
+static const uint32_t SIM_HEAP_SIZE = 320 * 1024;
+
+// Each level change is kept with the time it happened, so a task reads
+// the level as of its own clock rather than whatever the harness has set
+// since.
+struct PinChange {
+    uint64_t time;
+    int level;
+};
+static std::vector<PinChange> pinHistory[SIM_PIN_COUNT];
+static std::mutex pinMutex;
+static int pinLevel[SIM_PIN_COUNT];
+static void (*pinIsr[SIM_PIN_COUNT])(void);
+static int pinIsrMode[SIM_PIN_COUNT];
+static uint32_t minFreeHeap = SIM_HEAP_SIZE;
+
+unsigned long millis() { return static_cast<unsigned long>(sim::now() / 1000); }
+
+unsigned long micros() { return static_cast<unsigned long>(sim::now()); }
+
+void delay(uint32_t ms) {
+    sim::record("delay");
+    sim::advance(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(uint32_t us) { sim::advance(us); }
+
+void yield() {}
+
+static void setLevel(uint8_t pin, int level) {
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    pinLevel[pin] = level;
+    pinHistory[pin].push_back({sim::now(), level});
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < SIM_PIN_COUNT && mode == INPUT_PULLUP) {
+        setLevel(pin, HIGH);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) {
+        return LOW;
+    }
+    std::lock_guard<std::mutex> lock(pinMutex);
+    const std::vector<PinChange>& history = pinHistory[pin];
+    uint64_t t = sim::now();
+    for (size_t i = history.size(); i > 0; i--) {
+        if (history[i - 1].time <= t) {
+            return history[i - 1].level;
+        }
+    }
+    return LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < SIM_PIN_COUNT) {
+        setLevel(pin, val);
+    }
+}
+
+uint16_t analogRead(uint8_t pin) {
+    (void)pin;
+    return 930;  // ~0.75 V, 25 C through Menu::temperatureRead()
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+    if (pin < SIM_PIN_COUNT) {
+        pinIsr[pin] = isr;
+        pinIsrMode[pin] = mode;
+    }
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < SIM_PIN_COUNT) {
+        pinIsr[pin] = nullptr;
+    }
+}
+
+long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+
+long random(long howsmall, long howbig) {
+    return howbig > howsmall ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+void randomSeed(unsigned long seed) { srand(seed); }
+
+float temperatureRead() { return 45.0f; }
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (sim::verbose()) {
+        fwrite(buffer, 1, size, stderr);
+    }
+    return size;
+}
+
+void EspClass::restart() { sim::record("ESP.restart"); }
+
+uint32_t EspClass::getFreeHeap() {
+    size_t used = sim::heap().bytesInUse;
+    uint32_t freeHeap = used < SIM_HEAP_SIZE ? SIM_HEAP_SIZE - used : 0;
+    if (freeHeap < minFreeHeap) {
+        minFreeHeap = freeHeap;
+    }
+    return freeHeap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return minFreeHeap;
+}
+
+uint32_t EspClass::getHeapSize() { return SIM_HEAP_SIZE; }
+
+namespace sim {
+
+void setPin(uint8_t pin, int level) {
+    if (pin >= SIM_PIN_COUNT) {
+        return;
+    }
+    int previous = pinLevel[pin];
+    setLevel(pin, level);
+    if (!pinIsr[pin] || previous == level) {
+        return;
+    }
+    int mode = pinIsrMode[pin];
+    bool falling = previous == HIGH && level == LOW;
+    if (mode == CHANGE || (mode == FALLING && falling) || (mode == RISING && !falling)) {
+        pinIsr[pin]();
+    }
+}
+
+}  // namespace sim
@@ -0,0 +1,23 @@
+#ifndef HAL_SIM_ESPMDNS_H
+#define HAL_SIM_ESPMDNS_H
+
+#include "sim.h"
+
+class MDNSResponder {
+public:
+    bool begin(const char* hostName) {
+        (void)hostName;
+        sim::record("MDNS.begin");
+        return true;
+    }
+    void end() {}
+    void addService(const char* service, const char* proto, uint16_t port) {
+        (void)service;
+        (void)proto;
+        (void)port;
+    }
+};
+
+extern MDNSResponder MDNS;
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HAL_SIM_IPADDRESS_H
+#define HAL_SIM_IPADDRESS_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include "WString.h"
+
+class IPAddress {
+public:
+    IPAddress() : value(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : value(a | (b << 8) | (c << 16) | (static_cast<uint32_t>(d) << 24)) {}
+    IPAddress(uint32_t address) : value(address) {}
+
+    operator uint32_t() const { return value; }
+    uint8_t operator[](int index) const { return (value >> (index * 8)) & 0xFF; }
+    bool operator==(const IPAddress& rhs) const { return value == rhs.value; }
+    bool operator!=(const IPAddress& rhs) const { return value != rhs.value; }
+
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(buf);
+    }
+
+private:
+    uint32_t value;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "Preferences.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include "sim.h"
+
+namespace {
+
+std::mutex nvsLock;
+std::map<std::string, std::map<std::string, std::string>> nvs;  // namespace -> key -> bytes
+
+}  // namespace
+
+namespace sim {
+
+void clearNvs() {
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(nvsLock);
+    nvs.clear();
+}
+
+}  // namespace sim
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    if (opened || !name || strlen(name) > 15) {
+        return false;
+    }
+    sim::Untracked untracked;
+    space = name;
+    this->readOnly = readOnly;
+    opened = true;
+    return true;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+bool Preferences::clear() {
+    if (!opened || readOnly) {
+        return false;
+    }
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(nvsLock);
+    nvs.erase(space);
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!opened || readOnly) {
+        return false;
+    }
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(nvsLock);
+    return nvs[space].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return find(key) != nullptr;
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t len) {
+    if (!opened || readOnly || !key || strlen(key) > 15) {
+        return 0;
+    }
+    sim::record("Preferences.put");
+    sim::advance(sim::costs().nvsWriteUs);
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(nvsLock);
+    nvs[space][key].assign(static_cast<const char*>(value), len);
+    return len;
+}
+
+const std::string* Preferences::find(const char* key) {
+    if (!opened || !key) {
+        return nullptr;
+    }
+    sim::record("Preferences.get");
+    sim::advance(sim::costs().nvsReadUs);
+    std::lock_guard<std::mutex> lock(nvsLock);
+    auto ns = nvs.find(space);
+    if (ns == nvs.end()) {
+        return nullptr;
+    }
+    auto item = ns->second.find(key);
+    return item == ns->second.end() ? nullptr : &item->second;
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    return put(key, value, strlen(value) + 1);
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    return put(key, value, len);
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    const std::string* item = find(key);
+    return item && item->size() == sizeof(uint8_t) ? static_cast<uint8_t>((*item)[0])
+                                                   : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    const std::string* item = find(key);
+    if (!item || item->size() != sizeof(uint32_t)) {
+        return defaultValue;
+    }
+    uint32_t value;
+    memcpy(&value, item->data(), sizeof(value));
+    return value;
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+    const std::string* item = find(key);
+    if (!item || !value || item->size() > maxLen) {
+        return 0;
+    }
+    memcpy(value, item->data(), item->size());
+    return item->size();
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    const std::string* item = find(key);
+    return item ? String(item->c_str()) : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    const std::string* item = find(key);
+    return item ? item->size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    const std::string* item = find(key);
+    if (!item || !buf || item->size() > maxLen) {
+        return 0;
+    }
+    memcpy(buf, item->data(), item->size());
+    return item->size();
+}
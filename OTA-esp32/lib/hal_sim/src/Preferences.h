@@ -0,0 +1,56 @@
+#ifndef HAL_SIM_PREFERENCES_H
+#define HAL_SIM_PREFERENCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "WString.h"
+
+// NVS key/value store, as the ESP32 core's Preferences. Contents live for
+// the whole run, so they outlast the objects (and "restarts") that wrote
+// them. Every put is committed straight away and costs
+// sim::costs().nvsWriteUs; sim::calls("Preferences.put") counts them.
+// Every lookup (get*, isKey) costs nvsReadUs, counted as
+// "Preferences.get".
+class Preferences {
+public:
+    Preferences() : readOnly(true), opened(false) {}
+    ~Preferences() { end(); }
+
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putString(const char* key, const char* value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t getString(const char* key, char* value, size_t maxLen);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+    std::string space;
+    bool readOnly;
+    bool opened;
+
+    size_t put(const char* key, const void* value, size_t len);
+    const std::string* find(const char* key);
+};
+
+namespace sim {
+
+// Wipes every namespace, as erasing the NVS partition would
+void clearNvs();
+
+}  // namespace sim
+
+#endif
@@ -0,0 +1,54 @@
+#include "Print.h"
+
+#include <cstdio>
+
+size_t Print::printf(const char* format, ...) {
+    char local[128];
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(local, sizeof(local), format, args);
+    va_end(args);
+    if (needed < 0) {
+        return 0;
+    }
+    if (static_cast<size_t>(needed) < sizeof(local)) {
+        return write(local, needed);
+    }
+    char* big = new char[needed + 1];
+    va_start(args, format);
+    vsnprintf(big, needed + 1, format, args);
+    va_end(args);
+    size_t n = write(big, needed);
+    delete[] big;
+    return n;
+}
+
+size_t Print::print(long value, int base) {
+    if (base == DEC) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%ld", value);
+        return write(buf);
+    }
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char buf[72];
+    char* p = buf + sizeof(buf) - 1;
+    *p = 0;
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        int d = value % base;
+        *--p = d < 10 ? '0' + d : 'A' + d - 10;
+        value /= base;
+    } while (value);
+    return write(p);
+}
+
+size_t Print::print(double value, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    return write(buf);
+}
@@ -0,0 +1,139 @@
+#include "Update.h"
+
+#include <cstring>
+
+#include "sim.h"
+
+UpdateClass Update;
+
+static const char* const errorTexts[] = {
+    "No Error",
+    "Flash Write Failed",
+    "Flash Erase Failed",
+    "Flash Read Failed",
+    "Not Enough Space",
+    "Bad Size Given",
+    "Stream Read Timeout",
+    "MD5 Check Failed",
+    "Wrong Magic Byte",
+    "Could Not Activate The Firmware",
+    "Partition Could Not be Found",
+    "Bad Argument",
+    "Aborted",
+};
+
+UpdateClass::UpdateClass()
+    : buffer(nullptr), bufferLen(0), size_(0), progress_(0), error(UPDATE_ERROR_OK), sectors(0) {}
+
+UpdateClass::~UpdateClass() { delete[] buffer; }
+
+bool UpdateClass::begin(size_t size, int command, int ledPin, uint8_t ledOn, const char* label) {
+    (void)command;
+    (void)ledPin;
+    (void)ledOn;
+    (void)label;
+    sim::record("Update.begin");
+    if (size_) {
+        error = UPDATE_ERROR_BAD_ARGUMENT;
+        return false;
+    }
+    if (size == UPDATE_SIZE_UNKNOWN) {
+        size = SIM_PARTITION_SIZE;
+    } else if (size > SIM_PARTITION_SIZE) {
+        error = UPDATE_ERROR_SIZE;
+        return false;
+    }
+    error = UPDATE_ERROR_OK;
+    size_ = size;
+    progress_ = 0;
+    bufferLen = 0;
+    sectors = 0;
+    if (!buffer) {
+        buffer = new uint8_t[SPI_FLASH_SEC_SIZE];
+    }
+    sim::Untracked untracked;
+    image.clear();
+    image.reserve(size);
+    return true;
+}
+
+bool UpdateClass::writeBuffer() {
+    if (progress_ == 0 && bufferLen && buffer[0] != ESP_IMAGE_HEADER_MAGIC) {
+        error = UPDATE_ERROR_MAGIC_BYTE;
+        return false;
+    }
+    sim::advance(sim::costs().flashEraseSectorUs);
+    sim::advance(static_cast<uint64_t>(sim::costs().flashProgramSectorUs) * bufferLen /
+                 SPI_FLASH_SEC_SIZE);
+    sim::record("Update.flashSector");
+    {
+        sim::Untracked untracked;
+        image.insert(image.end(), buffer, buffer + bufferLen);
+    }
+    sectors++;
+    progress_ += bufferLen;
+    bufferLen = 0;
+    return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t len) {
+    sim::record("Update.write");
+    if (hasError() || !isRunning()) {
+        return 0;
+    }
+    if (len > remaining() - bufferLen) {
+        abort();
+        error = UPDATE_ERROR_SPACE;
+        return 0;
+    }
+    size_t left = len;
+    while (bufferLen + left > SPI_FLASH_SEC_SIZE) {
+        size_t toBuff = SPI_FLASH_SEC_SIZE - bufferLen;
+        memcpy(buffer + bufferLen, data + (len - left), toBuff);
+        bufferLen += toBuff;
+        if (!writeBuffer()) {
+            return len - left;
+        }
+        left -= toBuff;
+    }
+    memcpy(buffer + bufferLen, data + (len - left), left);
+    bufferLen += left;
+    if (bufferLen == remaining()) {
+        if (!writeBuffer()) {
+            return len - left;
+        }
+    }
+    return len;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+    sim::record("Update.end");
+    if (hasError() || size_ == 0) {
+        return false;
+    }
+    if (!isFinished() && !evenIfRemaining) {
+        abort();
+        return false;
+    }
+    if (evenIfRemaining) {
+        if (bufferLen > 0 && !writeBuffer()) {
+            return false;
+        }
+        size_ = progress_;
+    }
+    size_ = 0;
+    return true;
+}
+
+void UpdateClass::abort() {
+    sim::record("Update.abort");
+    size_ = 0;
+    bufferLen = 0;
+    error = UPDATE_ERROR_ABORT;
+}
+
+const char* UpdateClass::errorString() {
+    return error < sizeof(errorTexts) / sizeof(errorTexts[0]) ? errorTexts[error] : "UNKNOWN";
+}
+
+void UpdateClass::printError(Print& out) { out.printf("ERROR[%u]: %s\n", error, errorString()); }
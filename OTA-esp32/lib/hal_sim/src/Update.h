@@ -0,0 +1,74 @@
+#ifndef HAL_SIM_UPDATE_H
+#define HAL_SIM_UPDATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Print.h"
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+#define UPDATE_ERROR_OK (0)
+#define UPDATE_ERROR_WRITE (1)
+#define UPDATE_ERROR_ERASE (2)
+#define UPDATE_ERROR_READ (3)
+#define UPDATE_ERROR_SPACE (4)
+#define UPDATE_ERROR_SIZE (5)
+#define UPDATE_ERROR_STREAM (6)
+#define UPDATE_ERROR_MD5 (7)
+#define UPDATE_ERROR_MAGIC_BYTE (8)
+#define UPDATE_ERROR_ACTIVATE (9)
+#define UPDATE_ERROR_NO_PARTITION (10)
+#define UPDATE_ERROR_BAD_ARGUMENT (11)
+#define UPDATE_ERROR_ABORT (12)
+
+#define ESP_IMAGE_HEADER_MAGIC 0xE9
+#define SPI_FLASH_SEC_SIZE 4096
+
+// OTA writer with the buffering of the ESP32 core's UpdateClass: bytes
+// collect in a 4 KiB sector buffer and each full sector is erased and
+// programmed synchronously, which is where the simulated flash cost lands.
+// The written image is kept for inspection.
+class UpdateClass {
+public:
+    UpdateClass();
+    ~UpdateClass();
+
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = 0, int ledPin = -1,
+               uint8_t ledOn = 0, const char* label = nullptr);
+    size_t write(uint8_t* data, size_t len);
+    bool end(bool evenIfRemaining = false);
+    void abort();
+
+    void printError(Print& out);
+    const char* errorString();
+    bool hasError() { return error != UPDATE_ERROR_OK; }
+    uint8_t getError() { return error; }
+    void clearError() { error = UPDATE_ERROR_OK; }
+    bool isRunning() { return size_ > 0; }
+    bool isFinished() { return progress_ == size_; }
+    size_t size() { return size_; }
+    size_t progress() { return progress_; }
+    size_t remaining() { return size_ - progress_; }
+
+    // Simulation hooks.
+    const std::vector<uint8_t>& simImage() const { return image; }
+    unsigned long simSectorsWritten() const { return sectors; }
+    static const size_t SIM_PARTITION_SIZE = 0x1E0000;  // min_spiffs.csv app slot
+
+private:
+    uint8_t* buffer;
+    size_t bufferLen;
+    size_t size_;
+    size_t progress_;
+    uint8_t error;
+    unsigned long sectors;
+    std::vector<uint8_t> image;
+
+    bool writeBuffer();
+};
+
+extern UpdateClass Update;
+
+#endif
@@ -0,0 +1,287 @@
+#include "WString.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+char String::emptyBuffer[1] = {0};
+
+void String::init() {
+    buffer = emptyBuffer;
+    len = 0;
+    capacity = 0;
+}
+
+void String::release() {
+    if (buffer != emptyBuffer) {
+        delete[] buffer;
+    }
+    init();
+}
+
+bool String::reserve(size_t size) {
+    if (size <= capacity) {
+        return true;
+    }
+    char* grown = new char[size + 1];
+    memcpy(grown, buffer, len + 1);
+    if (buffer != emptyBuffer) {
+        delete[] buffer;
+    }
+    buffer = grown;
+    capacity = size;
+    return true;
+}
+
+void String::copy(const char* cstr, size_t length) {
+    if (length == 0) {
+        len = 0;
+        buffer[0] = 0;
+        return;
+    }
+    reserve(length);
+    memcpy(buffer, cstr, length);
+    buffer[length] = 0;
+    len = length;
+}
+
+String::String(const char* cstr) {
+    init();
+    if (cstr) {
+        copy(cstr, strlen(cstr));
+    }
+}
+
+String::String(const char* cstr, size_t length) {
+    init();
+    if (cstr) {
+        copy(cstr, length);
+    }
+}
+
+String::String(const String& other) {
+    init();
+    copy(other.buffer, other.len);
+}
+
+String::String(String&& other) noexcept {
+    buffer = other.buffer;
+    len = other.len;
+    capacity = other.capacity;
+    other.init();
+}
+
+String::String(char c) {
+    init();
+    copy(&c, 1);
+}
+
+static void formatInteger(char* out, size_t outLen, unsigned long value, bool negative,
+                          unsigned char base) {
+    char digits[72];
+    int n = 0;
+    do {
+        int d = value % base;
+        digits[n++] = d < 10 ? '0' + d : 'a' + d - 10;
+        value /= base;
+    } while (value && n < 70);
+    size_t pos = 0;
+    if (negative && pos + 1 < outLen) {
+        out[pos++] = '-';
+    }
+    while (n > 0 && pos + 1 < outLen) {
+        out[pos++] = digits[--n];
+    }
+    out[pos] = 0;
+}
+
+String::String(int value, unsigned char base) : String(static_cast<long>(value), base) {}
+
+String::String(unsigned int value, unsigned char base)
+    : String(static_cast<unsigned long>(value), base) {}
+
+String::String(long value, unsigned char base) {
+    init();
+    char tmp[72];
+    bool negative = value < 0 && base == 10;
+    unsigned long magnitude = negative ? 0UL - static_cast<unsigned long>(value)
+                                       : static_cast<unsigned long>(value);
+    formatInteger(tmp, sizeof(tmp), magnitude, negative, base);
+    copy(tmp, strlen(tmp));
+}
+
+String::String(unsigned long value, unsigned char base) {
+    init();
+    char tmp[72];
+    formatInteger(tmp, sizeof(tmp), value, false, base);
+    copy(tmp, strlen(tmp));
+}
+
+String::String(float value, unsigned int decimalPlaces)
+    : String(static_cast<double>(value), decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces) {
+    init();
+    char tmp[64];
+    snprintf(tmp, sizeof(tmp), "%.*f", static_cast<int>(decimalPlaces), value);
+    copy(tmp, strlen(tmp));
+}
+
+String::~String() { release(); }
+
+String& String::operator=(const String& rhs) {
+    if (this != &rhs) {
+        copy(rhs.buffer, rhs.len);
+    }
+    return *this;
+}
+
+String& String::operator=(String&& rhs) noexcept {
+    if (this != &rhs) {
+        release();
+        buffer = rhs.buffer;
+        len = rhs.len;
+        capacity = rhs.capacity;
+        rhs.init();
+    }
+    return *this;
+}
+
+String& String::operator=(const char* cstr) {
+    if (cstr) {
+        copy(cstr, strlen(cstr));
+    } else {
+        release();
+    }
+    return *this;
+}
+
+bool String::concat(const char* cstr, size_t length) {
+    if (!cstr || length == 0) {
+        return true;
+    }
+    reserve(len + length);
+    memmove(buffer + len, cstr, length);
+    len += length;
+    buffer[len] = 0;
+    return true;
+}
+
+bool String::concat(const char* cstr) { return cstr ? concat(cstr, strlen(cstr)) : true; }
+
+bool String::equals(const String& s) const {
+    return len == s.len && memcmp(buffer, s.buffer, len) == 0;
+}
+
+bool String::equals(const char* cstr) const {
+    if (!cstr) {
+        return len == 0;
+    }
+    return strcmp(buffer, cstr) == 0;
+}
+
+int String::indexOf(char c, size_t from) const {
+    if (from >= len) {
+        return -1;
+    }
+    const char* p = strchr(buffer + from, c);
+    return p ? static_cast<int>(p - buffer) : -1;
+}
+
+int String::indexOf(const char* s, size_t from) const {
+    if (from >= len) {
+        return -1;
+    }
+    const char* p = strstr(buffer + from, s);
+    return p ? static_cast<int>(p - buffer) : -1;
+}
+
+bool String::startsWith(const char* prefix) const {
+    return strncmp(buffer, prefix, strlen(prefix)) == 0;
+}
+
+bool String::endsWith(const char* suffix) const {
+    size_t n = strlen(suffix);
+    return n <= len && memcmp(buffer + len - n, suffix, n) == 0;
+}
+
+String String::substring(size_t from, size_t to) const {
+    if (from > to) {
+        size_t t = from;
+        from = to;
+        to = t;
+    }
+    if (from >= len) {
+        return String();
+    }
+    if (to > len) {
+        to = len;
+    }
+    return String(buffer + from, to - from);
+}
+
+long String::toInt() const { return strtol(buffer, nullptr, 10); }
+
+float String::toFloat() const { return strtof(buffer, nullptr); }
+
+void String::toLowerCase() {
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = tolower(static_cast<unsigned char>(buffer[i]));
+    }
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = toupper(static_cast<unsigned char>(buffer[i]));
+    }
+}
+
+void String::trim() {
+    size_t start = 0;
+    while (start < len && isspace(static_cast<unsigned char>(buffer[start]))) {
+        start++;
+    }
+    size_t end = len;
+    while (end > start && isspace(static_cast<unsigned char>(buffer[end - 1]))) {
+        end--;
+    }
+    if (start == 0 && end == len) {
+        return;
+    }
+    memmove(buffer, buffer + start, end - start);
+    len = end - start;
+    buffer[len] = 0;
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String out;
+    out.reserve(lhs.length() + rhs.length());
+    out.concat(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String out;
+    out.reserve(lhs.length() + (rhs ? strlen(rhs) : 0));
+    out.concat(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    String out;
+    out.reserve((lhs ? strlen(lhs) : 0) + rhs.length());
+    out.concat(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String& lhs, char rhs) {
+    String out;
+    out.reserve(lhs.length() + 1);
+    out.concat(lhs);
+    out.concat(rhs);
+    return out;
+}
@@ -0,0 +1,87 @@
+#ifndef HAL_SIM_WSTRING_H
+#define HAL_SIM_WSTRING_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Minimal Arduino String. Storage comes from operator new[] so the heap
+// accounting sees the same reallocation pattern firmware code produces.
+class String {
+public:
+    String(const char* cstr = "");
+    String(const char* cstr, size_t len);
+    String(const String& other);
+    String(String&& other) noexcept;
+    explicit String(char c);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+    ~String();
+
+    String& operator=(const String& rhs);
+    String& operator=(String&& rhs) noexcept;
+    String& operator=(const char* cstr);
+
+    bool reserve(size_t size);
+    bool concat(const char* cstr, size_t len);
+    bool concat(const char* cstr);
+    bool concat(const String& s) { return concat(s.buffer, s.len); }
+    bool concat(char c) { return concat(&c, 1); }
+    bool concat(int num) { return concat(String(num)); }
+    bool concat(unsigned int num) { return concat(String(num)); }
+    bool concat(long num) { return concat(String(num)); }
+    bool concat(unsigned long num) { return concat(String(num)); }
+
+    String& operator+=(const String& rhs) { concat(rhs); return *this; }
+    String& operator+=(const char* cstr) { concat(cstr); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    String& operator+=(int num) { concat(num); return *this; }
+    String& operator+=(unsigned int num) { concat(num); return *this; }
+    String& operator+=(long num) { concat(num); return *this; }
+    String& operator+=(unsigned long num) { concat(num); return *this; }
+
+    bool equals(const String& s) const;
+    bool equals(const char* cstr) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+
+    char operator[](size_t index) const { return index < len ? buffer[index] : 0; }
+    char charAt(size_t index) const { return (*this)[index]; }
+    const char* c_str() const { return buffer; }
+    size_t length() const { return len; }
+    bool isEmpty() const { return len == 0; }
+
+    int indexOf(char c, size_t from = 0) const;
+    int indexOf(const char* s, size_t from = 0) const;
+    bool startsWith(const char* prefix) const;
+    bool endsWith(const char* suffix) const;
+    String substring(size_t from) const { return substring(from, len); }
+    String substring(size_t from, size_t to) const;
+    long toInt() const;
+    float toFloat() const;
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+private:
+    char* buffer;
+    size_t len;
+    size_t capacity;
+    static char emptyBuffer[1];
+
+    void init();
+    void release();
+    void copy(const char* cstr, size_t length);
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+
+#endif
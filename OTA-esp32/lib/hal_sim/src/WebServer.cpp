@@ -0,0 +1,409 @@
+#include "WebServer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "WiFi.h"
+#include "sim.h"
+
+static std::vector<WebServer*>& instances() {
+    static std::vector<WebServer*> all;
+    return all;
+}
+
+static std::string urlDecode(const std::string& in) {
+    std::string out;
+    for (size_t i = 0; i < in.size(); i++) {
+        char c = in[i];
+        if (c == '+') {
+            out += ' ';
+        } else if (c == '%' && i + 2 < in.size()) {
+            out += static_cast<char>(strtol(in.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+static bool equalsIgnoreCase(const std::string& a, const char* b) {
+    return strcasecmp(a.c_str(), b) == 0;
+}
+
+static const char* statusText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        default: return "";
+    }
+}
+
+WebServer::WebServer(int port)
+    : port(port), running(false), currentUpload(nullptr), currentRaw(nullptr),
+      contentLength_(CONTENT_LENGTH_NOT_SET), headersSent(false) {
+    sim::Untracked untracked;
+    instances().push_back(this);
+}
+
+WebServer::~WebServer() {
+    std::vector<WebServer*>& all = instances();
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+    delete currentUpload;
+    delete currentRaw;
+}
+
+WebServer* WebServer::simOnPort(int port) {
+    std::vector<WebServer*>& all = instances();
+    for (auto it = all.rbegin(); it != all.rend(); ++it) {
+        if ((*it)->port == port) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+void WebServer::begin() {
+    sim::record("WebServer.begin");
+    running = true;
+}
+
+void WebServer::stop() { running = false; }
+
+void WebServer::on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn) {
+    on(uri, method, fn, nullptr);
+}
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn,
+                   THandlerFunction ufn) {
+    sim::Untracked untracked;
+    routes.push_back({uri.c_str(), method, fn, ufn});
+}
+
+String WebServer::arg(const String& name) {
+    for (auto& a : currentArgs) {
+        if (a.first == name.c_str()) {
+            return String(a.second.c_str(), a.second.size());
+        }
+    }
+    return String();
+}
+
+String WebServer::arg(int i) {
+    return i < args() ? String(currentArgs[i].second.c_str(), currentArgs[i].second.size())
+                      : String();
+}
+
+String WebServer::argName(int i) {
+    return i < args() ? String(currentArgs[i].first.c_str()) : String();
+}
+
+bool WebServer::hasArg(const String& name) {
+    for (auto& a : currentArgs) {
+        if (a.first == name.c_str()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    sim::Untracked untracked;
+    collected.clear();
+    for (size_t i = 0; i < headerKeysCount; i++) {
+        collected.push_back(headerKeys[i]);
+    }
+}
+
+String WebServer::header(const String& name) {
+    for (auto& key : collected) {
+        if (!equalsIgnoreCase(key, name.c_str())) {
+            continue;
+        }
+        for (auto& h : current.headers) {
+            if (equalsIgnoreCase(h.first, name.c_str())) {
+                return String(h.second.c_str());
+            }
+        }
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) { return header(name).length() > 0; }
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    sim::Untracked untracked;
+    std::pair<std::string, std::string> h(name.c_str(), value.c_str());
+    if (first) {
+        pendingHeaders.insert(pendingHeaders.begin(), h);
+    } else {
+        pendingHeaders.push_back(h);
+    }
+}
+
+void WebServer::sendHeaders(int code, const char* contentType, size_t length) {
+    sim::Untracked untracked;
+    std::shared_ptr<SimStream> stream = last.stream;
+    last = SimResponse();
+    last.stream = stream;
+    last.code = code;
+    last.contentType = contentType ? contentType : "text/html";
+    last.headers = pendingHeaders;
+    pendingHeaders.clear();
+    std::string head = "HTTP/1.1 " + std::to_string(code) + " " + statusText(code) + "\r\n";
+    head += "Content-Type: " + last.contentType + "\r\n";
+    if (length == CONTENT_LENGTH_UNKNOWN) {
+        head += "Transfer-Encoding: chunked\r\n";
+        last.chunked = true;
+    } else {
+        head += "Content-Length: " + std::to_string(length) + "\r\n";
+    }
+    for (auto& h : last.headers) {
+        head += h.first + ": " + h.second + "\r\n";
+    }
+    head += "\r\n";
+    last.wireBytes += head.size();
+    headersSent = true;
+}
+
+void WebServer::send(int code, const char* content_type, const String& content) {
+    send_P(code, content_type, content.c_str(), content.length());
+}
+
+void WebServer::send(int code, const char* content_type, const char* content) {
+    send_P(code, content_type, content, content ? strlen(content) : 0);
+}
+
+void WebServer::send_P(int code, PGM_P content_type, PGM_P content) {
+    send_P(code, content_type, content, content ? strlen(content) : 0);
+}
+
+void WebServer::send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength) {
+    sim::record("WebServer.send");
+    size_t length = contentLength_ == CONTENT_LENGTH_NOT_SET ? contentLength : contentLength_;
+    sendHeaders(code, content_type, length);
+    if (contentLength) {
+        sim::Untracked untracked;
+        last.body.append(content, contentLength);
+        last.wireBytes += contentLength;
+    }
+}
+
+void WebServer::sendContent(const char* content, size_t contentLength) {
+    sim::record("WebServer.sendContent");
+    sim::Untracked untracked;
+    if (last.chunked) {
+        // Chunk header "<hex>\r\n" and trailing "\r\n"; a zero chunk ends the body
+        char size[12];
+        int n = snprintf(size, sizeof(size), "%zx\r\n", contentLength);
+        last.wireBytes += n + 2;
+    }
+    last.body.append(content, contentLength);
+    last.wireBytes += contentLength;
+}
+
+WiFiClient WebServer::client() {
+    sim::Untracked untracked;
+    if (!last.stream) {
+        last.stream = std::make_shared<SimStream>();
+    }
+    return WiFiClient(last.stream);
+}
+
+void WebServer::simQueue(const SimRequest& request) {
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(pendingLock);
+    pending.push_back(request);
+    pending.back().queuedAt = sim::now();
+}
+
+void WebServer::parseArgs(const std::string& encoded) {
+    sim::Untracked untracked;
+    size_t pos = 0;
+    while (pos < encoded.size()) {
+        size_t amp = encoded.find('&', pos);
+        if (amp == std::string::npos) {
+            amp = encoded.size();
+        }
+        std::string pair = encoded.substr(pos, amp - pos);
+        size_t eq = pair.find('=');
+        if (!pair.empty()) {
+            if (eq == std::string::npos) {
+                currentArgs.push_back({urlDecode(pair), ""});
+            } else {
+                currentArgs.push_back({urlDecode(pair.substr(0, eq)), urlDecode(pair.substr(eq + 1))});
+            }
+        }
+        pos = amp + 1;
+    }
+}
+
+// Air time of bytes either way at sim::costs().linkBitsPerSecond
+void WebServer::chargeLink(size_t bytes) {
+    uint64_t bits = static_cast<uint64_t>(bytes) * 8;
+    sim::advance(bits * 1000000 / sim::costs().linkBitsPerSecond);
+}
+
+// Both return false when the link dropped part way; the route's completion
+// handler is then never called and no response goes out.
+bool WebServer::runUpload(const Route& route) {
+    {
+        sim::Untracked untracked;
+        if (!currentUpload) {
+            currentUpload = new HTTPUpload();
+        }
+    }
+    HTTPUpload& up = *currentUpload;
+    up.filename = current.filename.c_str();
+    up.name = "update";
+    up.type = "application/octet-stream";
+    up.totalSize = 0;
+    up.currentSize = 0;
+    up.status = UPLOAD_FILE_START;
+    route.ufn();
+
+    const std::string& body = current.body;
+    size_t end = body.size() < current.dropAfter ? body.size() : current.dropAfter;
+    size_t offset = 0;
+    while (offset < end) {
+        size_t n = end - offset;
+        if (n > HTTP_UPLOAD_BUFLEN) {
+            n = HTTP_UPLOAD_BUFLEN;
+        }
+        chargeLink(n);
+        memcpy(up.buf, body.data() + offset, n);
+        up.currentSize = n;
+        up.status = UPLOAD_FILE_WRITE;
+        route.ufn();
+        up.totalSize += n;
+        offset += n;
+        if (current.onProgress) {
+            current.onProgress(offset);
+        }
+    }
+    up.currentSize = 0;
+    up.status = end < body.size() ? UPLOAD_FILE_ABORTED : UPLOAD_FILE_END;
+    route.ufn();
+    return up.status == UPLOAD_FILE_END;
+}
+
+bool WebServer::runRaw(const Route& route) {
+    {
+        sim::Untracked untracked;
+        if (!currentRaw) {
+            currentRaw = new HTTPRaw();
+        }
+    }
+    HTTPRaw& raw = *currentRaw;
+    raw.totalSize = 0;
+    raw.currentSize = 0;
+    raw.data = nullptr;
+    raw.status = RAW_START;
+    route.ufn();
+
+    const std::string& body = current.body;
+    size_t end = body.size() < current.dropAfter ? body.size() : current.dropAfter;
+    while (raw.totalSize < end) {
+        size_t n = end - raw.totalSize;
+        if (n > HTTP_RAW_BUFLEN) {
+            n = HTTP_RAW_BUFLEN;
+        }
+        chargeLink(n);
+        memcpy(raw.buf, body.data() + raw.totalSize, n);
+        raw.currentSize = n;
+        raw.totalSize += n;
+        raw.status = RAW_WRITE;
+        route.ufn();
+        if (current.onProgress) {
+            current.onProgress(raw.totalSize);
+        }
+    }
+    raw.currentSize = 0;
+    raw.status = end < body.size() ? RAW_ABORTED : RAW_END;
+    route.ufn();
+    return raw.status == RAW_END;
+}
+
+void WebServer::handleClient() {
+    sim::record("WebServer.handleClient");
+    if (!running || !arrived()) {
+        return;
+    }
+    {
+        sim::Untracked untracked;
+        {
+            std::lock_guard<std::mutex> lock(pendingLock);
+            current = pending.front();
+        }
+        currentArgs.clear();
+        last = SimResponse();
+        pendingHeaders.clear();
+    }
+    uint64_t heardAt = sim::radioHeardAt(current.queuedAt);
+    if (heardAt > sim::now()) {
+        sim::setNow(heardAt);
+    }
+    serve();
+    chargeLink(last.wireBytes);  // the response goes out on the same link
+    last.doneAt = sim::now();
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(pendingLock);
+    pending.pop_front();
+}
+
+bool WebServer::arrived() {
+    std::lock_guard<std::mutex> lock(pendingLock);
+    if (pending.empty()) {
+        return false;
+    }
+    return !sim::isTaskThread() || sim::radioHeardAt(pending.front().queuedAt) < sim::now();
+}
+
+void WebServer::serve() {
+    contentLength_ = CONTENT_LENGTH_NOT_SET;
+    headersSent = false;
+    parseArgs(current.query);
+    bool formBody = current.filename.empty() &&
+                    current.contentType.find("application/x-www-form-urlencoded") == 0;
+    if (formBody) {
+        parseArgs(current.body);
+    }
+
+    for (auto& route : routes) {
+        if (route.uri != current.uri) {
+            continue;
+        }
+        if (route.method != HTTP_ANY && route.method != current.method) {
+            continue;
+        }
+        bool delivered = true;
+        if (!current.filename.empty() && route.ufn) {
+            delivered = runUpload(route);
+        } else if (!formBody && !current.body.empty() && route.ufn) {
+            delivered = runRaw(route);
+        } else if (!current.body.empty()) {
+            chargeLink(current.body.size());
+        }
+        if (delivered) {
+            route.fn();
+        }
+        return;
+    }
+    if (notFoundHandler) {
+        notFoundHandler();
+    } else {
+        send(404, "text/plain", "Not found");
+    }
+}
@@ -0,0 +1,192 @@
+#ifndef HAL_SIM_WEBSERVER_H
+#define HAL_SIM_WEBSERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "WString.h"
+#include "WiFiClient.h"
+
+enum HTTPMethod {
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS
+};
+
+enum HTTPUploadStatus {
+    UPLOAD_FILE_START,
+    UPLOAD_FILE_WRITE,
+    UPLOAD_FILE_END,
+    UPLOAD_FILE_ABORTED
+};
+
+enum HTTPRawStatus {
+    RAW_START,
+    RAW_WRITE,
+    RAW_END,
+    RAW_ABORTED
+};
+
+#define HTTP_UPLOAD_BUFLEN 1436
+#define HTTP_RAW_BUFLEN 1436
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+struct HTTPUpload {
+    HTTPUploadStatus status;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+struct HTTPRaw {
+    HTTPRawStatus status;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_RAW_BUFLEN];
+    void* data;
+};
+
+// Single-client server with the same polling model as the ESP32 core: one
+// queued request is served, start to finish, per handleClient() call.
+// Requests are injected with simQueue(), from any thread, and stamped with
+// the caller's clock. A task polling the server only sees a request once
+// its own clock has passed the stamp; the harness thread sees it at once
+// and moves its clock up to the stamp if needed.
+// Air time for request bodies and responses is charged to the serving
+// thread's clock at sim::costs().linkBitsPerSecond. As in
+// the core, a non-form body sent to a route with an upload handler is
+// delivered through raw() in HTTP_RAW_BUFLEN pieces. A handler may keep
+// client() past its return and go on writing to it, as event streams do.
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    struct SimRequest {
+        HTTPMethod method = HTTP_GET;
+        std::string uri = "/";
+        std::string query;
+        std::string contentType;
+        std::string body;
+        std::string filename;  // non-empty: body is sent as a multipart file upload
+        std::vector<std::pair<std::string, std::string>> headers;
+        size_t dropAfter = SIZE_MAX;  // link drops after this many body bytes
+        std::function<void(size_t)> onProgress;  // after each body piece, bytes so far
+        uint64_t queuedAt = 0;  // set by simQueue()
+    };
+
+    struct SimResponse {
+        int code = 0;
+        std::string contentType;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+        size_t wireBytes = 0;  // status line, headers and body as sent
+        bool chunked = false;
+        uint64_t doneAt = 0;  // serving thread's clock when the handler returned
+        std::shared_ptr<SimStream> stream;  // set when a handler took client()
+    };
+
+    explicit WebServer(int port = 80);
+    ~WebServer();
+
+    void begin();
+    void begin(uint16_t port) { (void)port; begin(); }
+    void stop();
+    void close() { stop(); }
+    void handleClient();
+
+    void on(const String& uri, THandlerFunction handler);
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn);
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void onNotFound(THandlerFunction fn) { notFoundHandler = fn; }
+
+    String uri() { return String(current.uri.c_str()); }
+    HTTPMethod method() { return current.method; }
+    String arg(const String& name);
+    String arg(int i);
+    String argName(int i);
+    int args() { return static_cast<int>(currentArgs.size()); }
+    bool hasArg(const String& name);
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    String header(const String& name);
+    bool hasHeader(const String& name);
+    HTTPUpload& upload() { return *currentUpload; }
+    HTTPRaw& raw() { return *currentRaw; }
+    WiFiClient client();
+    size_t clientContentLength() { return current.body.size(); }  // uploads carry no multipart framing here
+
+    void send(int code, const char* content_type = nullptr, const String& content = String(""));
+    void send(int code, const String& content_type, const String& content) {
+        send(code, content_type.c_str(), content);
+    }
+    void send(int code, const char* content_type, const char* content);
+    void send_P(int code, PGM_P content_type, PGM_P content);
+    void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength);
+    void setContentLength(const size_t contentLength) { contentLength_ = contentLength; }
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t contentLength);
+    void sendContent_P(PGM_P content) { sendContent(content, strlen(content)); }
+    void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+    // Simulation hooks.
+    void simQueue(const SimRequest& request);
+    // True until the last queued request has been served completely
+    bool simPending() const {
+        std::lock_guard<std::mutex> lock(pendingLock);
+        return !pending.empty();
+    }
+    const SimResponse& simLastResponse() const { return last; }
+    // The most recently constructed server still alive on the port, so the
+    // harness can reach servers the firmware keeps private.
+    static WebServer* simOnPort(int port);
+
+private:
+    struct Route {
+        std::string uri;
+        HTTPMethod method;
+        THandlerFunction fn;
+        THandlerFunction ufn;
+    };
+
+    int port;
+    bool running;
+    std::vector<Route> routes;
+    THandlerFunction notFoundHandler;
+    std::deque<SimRequest> pending;  // front is the one being served
+    mutable std::mutex pendingLock;
+    SimRequest current;
+    std::vector<std::pair<std::string, std::string>> currentArgs;
+    std::vector<std::string> collected;
+    HTTPUpload* currentUpload;
+    HTTPRaw* currentRaw;
+    size_t contentLength_;
+    bool headersSent;
+    std::vector<std::pair<std::string, std::string>> pendingHeaders;
+    SimResponse last;
+
+    bool arrived();
+    void serve();
+    void parseArgs(const std::string& encoded);
+    void sendHeaders(int code, const char* contentType, size_t length);
+    bool runUpload(const Route& route);
+    bool runRaw(const Route& route);
+    void chargeLink(size_t bytes);
+};
+
+#endif
@@ -0,0 +1,511 @@
+#include "WiFi.h"
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim.h"
+
+WiFiClass WiFi;
+
+namespace {
+
+const sim::AccessPoint defaultAccessPoints[] = {
+    {"HomeNet", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x01}, 6, -42, WIFI_AUTH_WPA2_PSK, "password123"},
+    {"CafeGuest", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x02}, 1, -55, WIFI_AUTH_OPEN, nullptr},
+    {"Office-5F", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x03}, 11, -61, WIFI_AUTH_WPA2_PSK, "office"},
+    {"Lab-IoT", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x04}, 6, -48, WIFI_AUTH_WPA_WPA2_PSK, "iot-lab"},
+    {"Neighbor", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x05}, 3, -77, WIFI_AUTH_WPA2_PSK, "n"},
+    {"PrinterDirect", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x06}, 1, -70, WIFI_AUTH_WPA2_PSK, "p"},
+    {"FreeWiFi", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x07}, 9, -83, WIFI_AUTH_OPEN, nullptr},
+    {"TP-LINK_8F2A", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x08}, 4, -66, WIFI_AUTH_WPA2_PSK, "t"},
+    {"Viettel_5C1D", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x09}, 7, -73, WIFI_AUTH_WPA2_PSK, "v"},
+    {"FPT-Telecom", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x0A}, 13, -80, WIFI_AUTH_WPA2_PSK, "f"},
+    {"VNPT-Home", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x0B}, 2, -58, WIFI_AUTH_WPA2_PSK, "h"},
+    {"Meeting Room", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x0C}, 11, -64, WIFI_AUTH_WPA3_PSK, "m"},
+    {"Guest-2G", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x0D}, 5, -86, WIFI_AUTH_OPEN, nullptr},
+    {"Warehouse", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x0E}, 8, -89, WIFI_AUTH_WPA2_PSK, "w"},
+    {"ESP_7A31C0", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x0F}, 1, -52, WIFI_AUTH_OPEN, nullptr},
+    {"AndroidAP", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x10}, 6, -68, WIFI_AUTH_WPA2_PSK, "a"},
+    {"iPhone", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x11}, 11, -71, WIFI_AUTH_WPA2_PSK, "i"},
+    {"Cam-Yard", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x12}, 3, -79, WIFI_AUTH_WPA2_PSK, "c"},
+    {"SmartTV", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x13}, 10, -75, WIFI_AUTH_WPA2_PSK, "s"},
+    {"Mesh-Node-2", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x14}, 6, -60, WIFI_AUTH_WPA2_PSK, "password123"},
+    {"Old-WEP", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x15}, 12, -88, WIFI_AUTH_WEP, "12345"},
+    {"Shop-POS", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x16}, 4, -82, WIFI_AUTH_WPA2_ENTERPRISE, "x"},
+    {"Balcony", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x17}, 9, -69, WIFI_AUTH_WPA2_PSK, "b"},
+    {"", {0x24, 0x0A, 0xC4, 0x10, 0x00, 0x18}, 1, -74, WIFI_AUTH_WPA2_PSK, "hidden"},
+};
+
+const int SCAN_RESULT_MAX = 64;
+
+struct ScanResult {
+    const sim::AccessPoint* ap;
+    int32_t rssi;
+};
+
+const sim::AccessPoint* accessPoints = defaultAccessPoints;
+int accessPointCount = sizeof(defaultAccessPoints) / sizeof(defaultAccessPoints[0]);
+
+wifi_mode_t currentMode = WIFI_MODE_NULL;
+char hostname[33] = "esp32-sim";
+
+ScanResult scanResults[SCAN_RESULT_MAX];
+wifi_ap_record_t scanRecords[SCAN_RESULT_MAX];
+int scanResultCount = 0;
+bool scanRunning = false;
+uint64_t scanDoneAt = 0;
+uint32_t scanSeed = 1;
+
+const sim::AccessPoint* connectTarget = nullptr;
+bool connectAccepted = false;
+uint64_t connectDoneAt = 0;
+bool stationActive = false;
+uint32_t staticIp = 0;  // set by config(); 0 means DHCP
+
+bool apUp = false;
+uint8_t apChannel = 1;
+bool apExpected = false;
+uint64_t apDownSince = 0;
+uint64_t apDowntime = 0;
+
+// The last off-channel stretch, read by server tasks
+std::atomic<uint64_t> awayFrom(0);
+std::atomic<uint64_t> awayUntil(0);
+
+// The event task: events queue up in the order they happen and are
+// delivered one after the other, as the core's event loop does
+struct EventHandler {
+    arduino_event_id_t event;
+    WiFiEventFuncCb callback;
+};
+struct PendingEvent {
+    uint64_t at;
+    arduino_event_id_t event;
+    arduino_event_info_t info;
+};
+std::mutex eventLock;
+std::vector<EventHandler> eventHandlers;
+TaskHandle_t eventTask = nullptr;
+std::deque<PendingEvent> pendingEvents;  // by time due, oldest first
+
+// Delivers each queued event once the harness clock reaches it, on this
+// task's thread, as the core's event task would
+void eventLoop(void* arg) {
+    (void)arg;
+    for (;;) {
+        uint64_t due = 0;
+        {
+            std::lock_guard<std::mutex> lock(eventLock);
+            if (!pendingEvents.empty()) {
+                due = pendingEvents.front().at;
+            }
+        }
+        if (due == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (sim::now() < due) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((due - sim::now() + 999) / 1000));
+            continue;
+        }
+        PendingEvent pending;
+        std::vector<EventHandler> handlers;
+        {
+            sim::Untracked untracked;
+            std::lock_guard<std::mutex> lock(eventLock);
+            if (pendingEvents.empty() || pendingEvents.front().at > sim::now()) {
+                continue;
+            }
+            pending = pendingEvents.front();
+            pendingEvents.pop_front();
+            handlers = eventHandlers;
+        }
+        for (const EventHandler& handler : handlers) {
+            if (handler.event == ARDUINO_EVENT_MAX || handler.event == pending.event) {
+                handler.callback(pending.event, pending.info);
+            }
+        }
+    }
+}
+
+// Queues an event for the time it happens: behind everything due at or
+// before it, so events at the same time arrive in the order posted
+void postEvent(uint64_t at, arduino_event_id_t event, uint8_t reason) {
+    {
+        sim::Untracked untracked;
+        std::lock_guard<std::mutex> lock(eventLock);
+        PendingEvent pending;
+        memset(&pending, 0, sizeof(pending));
+        pending.at = at ? at : 1;
+        pending.event = event;
+        pending.info.wifi_sta_disconnected.reason = reason;
+        auto it = pendingEvents.end();
+        while (it != pendingEvents.begin() && (it - 1)->at > pending.at) {
+            --it;
+        }
+        pendingEvents.insert(it, pending);
+    }
+    if (eventTask) {
+        xTaskNotifyGive(eventTask);
+    }
+}
+
+// Drops the outcome of an attempt that is being abandoned: it never
+// happens. Events already due stay queued, as they would on the device.
+void cancelFutureEvents() {
+    std::lock_guard<std::mutex> lock(eventLock);
+    uint64_t now = sim::now();
+    while (!pendingEvents.empty() && pendingEvents.back().at > now) {
+        pendingEvents.pop_back();
+    }
+}
+
+uint32_t nextRandom() {
+    scanSeed = scanSeed * 1103515245u + 12345u;
+    return (scanSeed >> 16) & 0x7FFF;
+}
+
+void collectResults(bool show_hidden, uint8_t channel) {
+    scanResultCount = 0;
+    for (int i = 0; i < accessPointCount && scanResultCount < SCAN_RESULT_MAX; i++) {
+        const sim::AccessPoint& ap = accessPoints[i];
+        if (channel && ap.channel != channel) {
+            continue;
+        }
+        if (!show_hidden && ap.ssid[0] == 0) {
+            continue;
+        }
+        // +/-4 dB of per-scan jitter, like a real indoor environment
+        int32_t rssi = ap.rssi + static_cast<int32_t>(nextRandom() % 9) - 4;
+        scanResults[scanResultCount++] = {&ap, rssi};
+    }
+    // The driver reports strongest first
+    for (int i = 1; i < scanResultCount; i++) {
+        ScanResult r = scanResults[i];
+        int j = i - 1;
+        while (j >= 0 && scanResults[j].rssi < r.rssi) {
+            scanResults[j + 1] = scanResults[j];
+            j--;
+        }
+        scanResults[j + 1] = r;
+    }
+}
+
+const sim::AccessPoint* findAccessPoint(const char* ssid) {
+    for (int i = 0; i < accessPointCount; i++) {
+        if (strcmp(accessPoints[i].ssid, ssid) == 0) {
+            return &accessPoints[i];
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+namespace sim {
+
+void setAccessPoints(const AccessPoint* aps, int count) {
+    if (!aps) {
+        aps = defaultAccessPoints;
+        count = sizeof(defaultAccessPoints) / sizeof(defaultAccessPoints[0]);
+    }
+    accessPoints = aps;
+    accessPointCount = count;
+}
+
+uint64_t apDowntimeUs() {
+    return apDowntime + (apExpected && !apUp ? sim::now() - apDownSince : 0);
+}
+
+uint64_t radioHeardAt(uint64_t at) {
+    uint64_t until = awayUntil.load();
+    return at >= awayFrom.load() && at < until ? until : at;
+}
+
+}  // namespace sim
+
+bool WiFiClass::mode(wifi_mode_t m) {
+    sim::record("WiFi.mode");
+    currentMode = m;
+    if (m != WIFI_MODE_AP && m != WIFI_MODE_APSTA && apUp) {
+        apUp = false;
+        apExpected = false;
+    }
+    return true;
+}
+
+wifi_mode_t WiFiClass::getMode() { return currentMode; }
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    sim::record("WiFi.begin");
+    if (currentMode == WIFI_MODE_NULL || currentMode == WIFI_MODE_AP) {
+        currentMode = currentMode == WIFI_MODE_AP ? WIFI_MODE_APSTA : WIFI_MODE_STA;
+    }
+    cancelFutureEvents();
+    if (WiFi.status() == WL_CONNECTED) {
+        // Leaves the current AP first, as the driver does
+        postEvent(sim::now(), ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    }
+    connectTarget = findAccessPoint(ssid);
+    uint32_t ms = sim::costs().connectMs;
+    bool missed = false;
+    if (channel && bssid) {
+        ms -= sim::costs().connectScanMs;
+        if (connectTarget && (connectTarget->channel != channel ||
+                              memcmp(connectTarget->bssid, bssid, 6) != 0)) {
+            connectTarget = nullptr;  // not where it was: nothing answers there
+            missed = true;
+        }
+    }
+    connectAccepted = false;
+    if (connectTarget) {
+        const char* expected = connectTarget->password ? connectTarget->password : "";
+        connectAccepted = strcmp(expected, passphrase ? passphrase : "") == 0;
+    }
+    stationActive = connect;
+    if (staticIp) {
+        ms -= sim::costs().dhcpMs;
+    }
+    if (missed) {
+        ms = sim::costs().connectMissMs;
+    }
+    connectDoneAt = sim::now() + static_cast<uint64_t>(ms) * 1000;
+    if (connect) {
+        if (connectAccepted) {
+            postEvent(connectDoneAt, ARDUINO_EVENT_WIFI_STA_GOT_IP, 0);
+        } else {
+            postEvent(connectDoneAt, ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+                      connectTarget ? WIFI_REASON_AUTH_FAIL : WIFI_REASON_NO_AP_FOUND);
+        }
+    }
+    return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+    if (!stationActive) {
+        return WL_DISCONNECTED;
+    }
+    if (sim::now() < connectDoneAt) {
+        return WL_DISCONNECTED;
+    }
+    if (!connectTarget) {
+        return WL_NO_SSID_AVAIL;
+    }
+    return connectAccepted ? WL_CONNECTED : WL_CONNECT_FAILED;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+    (void)eraseap;
+    sim::record("WiFi.disconnect");
+    cancelFutureEvents();
+    if (stationActive) {
+        postEvent(sim::now(), ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    }
+    stationActive = false;
+    connectTarget = nullptr;
+    if (wifioff) {
+        currentMode = WIFI_MODE_NULL;
+    }
+    return true;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+    (void)autoReconnect;
+    return true;
+}
+
+bool WiFiClass::setHostname(const char* name) {
+    strncpy(hostname, name, sizeof(hostname) - 1);
+    return true;
+}
+
+const char* WiFiClass::getHostname() { return hostname; }
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event) {
+    size_t id;
+    {
+        sim::Untracked untracked;
+        std::lock_guard<std::mutex> lock(eventLock);
+        eventHandlers.push_back({event, cbEvent});
+        id = eventHandlers.size();
+    }
+    if (!eventTask) {
+        xTaskCreate(eventLoop, "sys_evt", 4096, nullptr, 20, &eventTask);
+    }
+    return id;
+}
+
+bool WiFiClass::config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1,
+                       IPAddress dns2) {
+    (void)gateway;
+    (void)subnet;
+    (void)dns1;
+    (void)dns2;
+    staticIp = local_ip;
+    return true;
+}
+
+IPAddress WiFiClass::localIP() {
+    if (status() != WL_CONNECTED) {
+        return IPAddress();
+    }
+    return staticIp ? IPAddress(staticIp) : IPAddress(192, 168, 0, 42);
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 0, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask() {
+    return status() == WL_CONNECTED ? IPAddress(255, 255, 255, 0) : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t dns_no) {
+    return status() == WL_CONNECTED && dns_no == 0 ? IPAddress(192, 168, 0, 1) : IPAddress();
+}
+
+uint8_t* WiFiClass::BSSID() {
+    return status() == WL_CONNECTED ? const_cast<uint8_t*>(connectTarget->bssid) : nullptr;
+}
+
+String WiFiClass::macAddress() { return String("24:0A:C4:00:5E:11"); }
+
+String WiFiClass::SSID() {
+    return status() == WL_CONNECTED ? String(connectTarget->ssid) : String();
+}
+
+int32_t WiFiClass::RSSI() { return status() == WL_CONNECTED ? connectTarget->rssi : 0; }
+
+int32_t WiFiClass::channel() { return status() == WL_CONNECTED ? connectTarget->channel : 0; }
+
+int16_t WiFiClass::scanNetworks(bool async, bool show_hidden, bool passive,
+                                uint32_t max_ms_per_chan, uint8_t channel, const char* ssid,
+                                const uint8_t* bssid) {
+    (void)ssid;
+    (void)bssid;
+    sim::record("WiFi.scanNetworks");
+    if (scanRunning) {
+        return WIFI_SCAN_RUNNING;
+    }
+    if (currentMode == WIFI_MODE_NULL || currentMode == WIFI_MODE_AP) {
+        currentMode = currentMode == WIFI_MODE_AP ? WIFI_MODE_APSTA : WIFI_MODE_STA;
+    }
+    uint32_t dwell = passive ? max_ms_per_chan
+                             : (max_ms_per_chan < sim::costs().scanDwellMs
+                                    ? max_ms_per_chan
+                                    : sim::costs().scanDwellMs);
+    uint32_t channels = channel ? 1 : 13;
+    uint64_t duration = static_cast<uint64_t>(dwell) * channels * 1000;
+    collectResults(show_hidden, channel);
+    // Away from the home channel for the whole scan, unless it only looks there
+    uint8_t home = status() == WL_CONNECTED ? connectTarget->channel : (apUp ? apChannel : 0);
+    if (home && channel != home) {
+        awayUntil = 0;
+        awayFrom = sim::now();
+        awayUntil = sim::now() + duration;
+    }
+    if (async) {
+        scanRunning = true;
+        scanDoneAt = sim::now() + duration;
+        return WIFI_SCAN_RUNNING;
+    }
+    sim::advance(duration);
+    return scanResultCount;
+}
+
+int16_t WiFiClass::scanComplete() {
+    if (scanRunning) {
+        if (sim::now() < scanDoneAt) {
+            return WIFI_SCAN_RUNNING;
+        }
+        scanRunning = false;
+    }
+    return scanResultCount;
+}
+
+void WiFiClass::scanDelete() {
+    sim::record("WiFi.scanDelete");
+    scanResultCount = 0;
+}
+
+String WiFiClass::SSID(uint8_t i) {
+    return i < scanResultCount ? String(scanResults[i].ap->ssid) : String();
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t i) {
+    return i < scanResultCount ? scanResults[i].ap->auth : WIFI_AUTH_OPEN;
+}
+
+int32_t WiFiClass::RSSI(uint8_t i) { return i < scanResultCount ? scanResults[i].rssi : 0; }
+
+uint8_t* WiFiClass::BSSID(uint8_t i) {
+    return i < scanResultCount ? const_cast<uint8_t*>(scanResults[i].ap->bssid) : nullptr;
+}
+
+int32_t WiFiClass::channel(uint8_t i) {
+    return i < scanResultCount ? scanResults[i].ap->channel : 0;
+}
+
+void* WiFiClass::getScanInfoByIndex(int i) {
+    if (i < 0 || i >= scanResultCount) {
+        return nullptr;
+    }
+    const ScanResult& result = scanResults[i];
+    wifi_ap_record_t& record = scanRecords[i];
+    memcpy(record.bssid, result.ap->bssid, sizeof(record.bssid));
+    strncpy(reinterpret_cast<char*>(record.ssid), result.ap->ssid, sizeof(record.ssid) - 1);
+    record.ssid[sizeof(record.ssid) - 1] = 0;
+    record.primary = result.ap->channel;
+    record.rssi = static_cast<int8_t>(result.rssi);
+    record.authmode = result.ap->auth;
+    return &record;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* passphrase, int channel, int ssid_hidden,
+                       int max_connection, bool ftm_responder) {
+    (void)ssid;
+    (void)passphrase;
+    (void)ssid_hidden;
+    (void)max_connection;
+    (void)ftm_responder;
+    sim::record("WiFi.softAP");
+    if (apExpected && !apUp) {
+        apDowntime += sim::now() - apDownSince;
+    }
+    apUp = true;
+    apExpected = true;
+    apChannel = channel;
+    currentMode = currentMode == WIFI_MODE_STA ? WIFI_MODE_APSTA
+                                               : (currentMode == WIFI_MODE_NULL ? WIFI_MODE_AP
+                                                                                : currentMode);
+    return true;
+}
+
+bool WiFiClass::softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet) {
+    (void)local_ip;
+    (void)gateway;
+    (void)subnet;
+    return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool wifioff) {
+    sim::record("WiFi.softAPdisconnect");
+    if (apUp) {
+        apUp = false;
+        apDownSince = sim::now();
+    }
+    if (wifioff) {
+        apExpected = false;
+    }
+    return true;
+}
+
+IPAddress WiFiClass::softAPIP() { return apUp ? IPAddress(192, 168, 1, 1) : IPAddress(); }
+
+uint8_t WiFiClass::softAPgetStationNum() { return 0; }
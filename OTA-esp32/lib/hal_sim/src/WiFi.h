@@ -0,0 +1,169 @@
+#ifndef HAL_SIM_WIFI_H
+#define HAL_SIM_WIFI_H
+
+#include <cstdint>
+#include <functional>
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WString.h"
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+    WIFI_MODE_MAX
+} wifi_mode_t;
+
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+    WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+// The fields of esp_wifi_types.h's scan record the firmware reads.
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;  // channel
+    int8_t rssi;
+    wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+// The station events the firmware listens for, as in the ESP32 core
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE = 8,
+    WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+    WIFI_REASON_NO_AP_FOUND = 201,
+    WIFI_REASON_AUTH_FAIL = 202
+} wifi_err_reason_t;
+
+typedef struct {
+    uint8_t reason;  // wifi_err_reason_t
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+// Simulated radio environment.
+namespace sim {
+
+struct AccessPoint {
+    const char* ssid;
+    uint8_t bssid[6];
+    uint8_t channel;
+    int32_t rssi;
+    wifi_auth_mode_t auth;
+    const char* password;
+};
+
+// Replaces the visible networks; the table must outlive the simulation.
+// nullptr brings back the built-in table.
+void setAccessPoints(const AccessPoint* aps, int count);
+
+// Total time the soft-AP was not beaconing while it was supposed to be up
+// (between softAPdisconnect() and the next softAP()).
+uint64_t apDowntimeUs();
+
+// When a frame sent to the device at `at` is heard: right away, or when
+// the radio is back from a scan that had it off its home channel (the
+// soft-AP's, or the connected network's) at that moment. Safe to call
+// from server tasks.
+uint64_t radioHeardAt(uint64_t at);
+
+}  // namespace sim
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t m);
+    wifi_mode_t getMode();
+
+    // With channel and bssid the station goes straight to that AP instead
+    // of scanning for it, and fails fast if it is not there; after
+    // config() with an address it skips DHCP as well.
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet,
+                IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+    wl_status_t status();
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    bool setAutoReconnect(bool autoReconnect);
+    bool setHostname(const char* hostname);
+    const char* getHostname();
+
+    // Handlers run on the event task (a thread of its own in the sim) when
+    // a connection attempt ends: GOT_IP, or DISCONNECTED with a reason.
+    // ARDUINO_EVENT_MAX hears every event.
+    wifi_event_id_t onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t dns_no = 0);
+    String macAddress();
+    String SSID();
+    uint8_t* BSSID();
+    int32_t RSSI();
+    int32_t channel();
+
+    int16_t scanNetworks(bool async = false, bool show_hidden = false, bool passive = false,
+                         uint32_t max_ms_per_chan = 300, uint8_t channel = 0,
+                         const char* ssid = nullptr, const uint8_t* bssid = nullptr);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t networkItem);
+    wifi_auth_mode_t encryptionType(uint8_t networkItem);
+    int32_t RSSI(uint8_t networkItem);
+    uint8_t* BSSID(uint8_t networkItem);
+    int32_t channel(uint8_t networkItem);
+    void* getScanInfoByIndex(int i);  // wifi_ap_record_t*, nullptr past the end
+
+    bool softAP(const char* ssid, const char* passphrase = nullptr, int channel = 1,
+                int ssid_hidden = 0, int max_connection = 4, bool ftm_responder = false);
+    bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet);
+    bool softAPdisconnect(bool wifioff = false);
+    IPAddress softAPIP();
+    uint8_t softAPgetStationNum();
+};
+
+extern WiFiClass WiFi;
+
+#endif
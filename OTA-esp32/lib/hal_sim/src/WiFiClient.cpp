@@ -0,0 +1,36 @@
+#include "WiFiClient.h"
+
+#include "sim.h"
+
+bool WiFiClient::connected() {
+    if (!stream) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(stream->lock);
+    return stream->open;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    sim::record("WiFiClient.write");
+    if (!connected()) {
+        return 0;
+    }
+    uint64_t bits = static_cast<uint64_t>(size) * 8;
+    sim::advance(bits * 1000000 / sim::costs().linkBitsPerSecond);
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(stream->lock);
+    stream->data.append(reinterpret_cast<const char*>(buffer), size);
+    stream->writes.push_back(std::make_pair(sim::now(), size));
+    return size;
+}
+
+std::string WiFiClient::simReceived(const std::shared_ptr<SimStream>& stream) {
+    sim::Untracked untracked;
+    std::lock_guard<std::mutex> lock(stream->lock);
+    return stream->data;
+}
+
+void WiFiClient::simClose(const std::shared_ptr<SimStream>& stream) {
+    std::lock_guard<std::mutex> lock(stream->lock);
+    stream->open = false;
+}
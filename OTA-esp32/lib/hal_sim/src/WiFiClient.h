@@ -0,0 +1,47 @@
+#ifndef HAL_SIM_WIFICLIENT_H
+#define HAL_SIM_WIFICLIENT_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "Print.h"
+
+// What the server wrote to one connection, shared between every copy of
+// the WiFiClient that owns it and the harness reading it.
+struct SimStream {
+    std::mutex lock;
+    std::string data;
+    std::vector<std::pair<uint64_t, size_t>> writes;  // writer's clock, bytes
+    bool open = true;  // false once the peer has gone away
+};
+
+// Copies share the connection, as in the ESP32 core; stop() drops this
+// handle only. Writes cost air time at sim::costs().linkBitsPerSecond on
+// the writing thread, as the server's responses do.
+class WiFiClient : public Print {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(const std::shared_ptr<SimStream>& stream) : stream(stream) {}
+
+    bool connected();
+    void stop() { stream.reset(); }
+    explicit operator bool() { return connected(); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    // Simulation hooks.
+    static std::string simReceived(const std::shared_ptr<SimStream>& stream);
+    static void simClose(const std::shared_ptr<SimStream>& stream);
+
+private:
+    std::shared_ptr<SimStream> stream;
+};
+
+#endif
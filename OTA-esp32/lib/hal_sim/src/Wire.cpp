@@ -0,0 +1,60 @@
+#include "Wire.h"
+
+#include "sim.h"
+
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    (void)sda;
+    (void)scl;
+    if (frequency) {
+        setClock(frequency);
+    }
+    return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+    sim::record("Wire.setClock");
+    clock = frequency ? frequency : 100000;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLength = 0;
+    transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (!transmitting || txLength >= I2C_BUFFER_LENGTH) {
+        return 0;
+    }
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    size_t n = 0;
+    while (n < quantity && write(data[n])) {
+        n++;
+    }
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    (void)txAddress;
+    if (!transmitting) {
+        return 4;
+    }
+    transmitting = false;
+    // Address byte + payload, 9 SCL periods each, plus start and stop.
+    uint64_t bits = (txLength + 1) * 9 + 2;
+    uint64_t us = (bits * 1000000 + clock - 1) / clock;
+    sim::advance(us);
+    sim::record("Wire.endTransmission");
+    counters.transactions++;
+    counters.bytes += txLength;
+    counters.busUs += us;
+    return 0;
+}
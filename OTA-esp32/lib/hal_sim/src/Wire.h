@@ -0,0 +1,45 @@
+#ifndef HAL_SIM_WIRE_H
+#define HAL_SIM_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define I2C_BUFFER_LENGTH 128
+
+// I2C master that charges bus time to the simulated clock: nine clocks per
+// byte (data + ACK) plus start/stop, at the configured SCL frequency.
+class TwoWire {
+public:
+    TwoWire() : clock(100000), txLength(0), transmitting(false) {}
+
+    bool begin() { return true; }
+    bool begin(int sda, int scl, uint32_t frequency = 0);
+    bool setClock(uint32_t frequency);
+    uint32_t getClock() { return clock; }
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t quantity);
+    uint8_t endTransmission(bool sendStop = true);
+
+    // Simulation counters since the last resetStats().
+    struct Stats {
+        unsigned long transactions;
+        unsigned long bytes;
+        uint64_t busUs;
+    };
+    Stats stats() const { return counters; }
+    void resetStats() { counters = {0, 0, 0}; }
+
+private:
+    uint32_t clock;
+    uint8_t txAddress;
+    uint8_t txBuffer[I2C_BUFFER_LENGTH];
+    size_t txLength;
+    bool transmitting;
+    Stats counters = {0, 0, 0};
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef HAL_SIM_ESP_OTA_OPS_H
+#define HAL_SIM_ESP_OTA_OPS_H
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+// The running app is app0 of min_spiffs.csv; its contents are whatever the
+// benchmark installed with sim::setRunningImage().
+const esp_partition_t* esp_ota_get_running_partition(void);
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from);
+
+#endif
@@ -0,0 +1,58 @@
+#include <cstring>
+#include <vector>
+
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "sim.h"
+
+namespace {
+
+const esp_partition_t app0 = {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x10000,
+                              0x1E0000, "app0", false};
+const esp_partition_t app1 = {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x1F0000,
+                              0x1E0000, "app1", false};
+
+std::vector<uint8_t>& runningImage() {
+    static std::vector<uint8_t> image;
+    return image;
+}
+
+}  // namespace
+
+const esp_partition_t* esp_ota_get_running_partition(void) { return &app0; }
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+    (void)start_from;
+    return &app1;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst,
+                             size_t size) {
+    sim::record("esp_partition_read");
+    if (!partition || !dst) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (src_offset > partition->size || size > partition->size - src_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    sim::advance((static_cast<uint64_t>(sim::costs().flashReadSectorUs) * size + 4095) / 4096);
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    memset(out, 0xFF, size);
+    if (partition == &app0) {
+        const std::vector<uint8_t>& image = runningImage();
+        if (src_offset < image.size()) {
+            size_t n = image.size() - src_offset < size ? image.size() - src_offset : size;
+            memcpy(out, image.data() + src_offset, n);
+        }
+    }
+    return ESP_OK;
+}
+
+namespace sim {
+
+void setRunningImage(const uint8_t* data, size_t size) {
+    Untracked untracked;
+    runningImage().assign(data, data + size);
+}
+
+}  // namespace sim
@@ -0,0 +1,431 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sim.h"
+
+namespace {
+
+// Thrown inside a task thread to unwind it on vTaskDelete(NULL) or shutdown.
+struct TaskExit {};
+
+// Real time a finite timeout may block before it is treated as expired.
+const auto MAX_REAL_WAIT = std::chrono::milliseconds(50);
+const auto POLL_INTERVAL = std::chrono::milliseconds(5);
+
+// How often a task in a timed wait, or settleTasks(), looks again.
+const auto GATE_INTERVAL = std::chrono::microseconds(100);
+
+std::atomic<bool> shuttingDown{false};
+
+}  // namespace
+
+struct SimTask {
+    TaskFunction_t fn;
+    void* param;
+    UBaseType_t priority;
+    BaseType_t core;
+    std::thread thread;
+    std::atomic<bool> deleted{false};
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t notifyCount = 0;
+    uint64_t notifyTime = 0;
+    std::atomic<bool> finished{false};
+
+    // What the task is blocked on, for sim::settleTasks(); guarded by
+    // waitState. waitSerial counts waits, so a task that woke and blocked
+    // again between two looks is told apart from one that never woke.
+    std::mutex waitState;
+    bool waiting = false;
+    uint64_t waitSerial = 0;
+    std::mutex* waitLock = nullptr;
+    std::function<bool()> waitReady;
+    uint64_t waitUntil = UINT64_MAX;
+};
+
+struct SimQueue {
+    struct Item {
+        std::vector<uint8_t> data;
+        uint64_t time;
+    };
+    size_t itemSize;
+    std::deque<Item> items;
+    std::deque<uint64_t> freeSlots;  // time each free slot became available
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+namespace {
+
+thread_local SimTask* currentTask = nullptr;
+std::mutex registryMutex;
+std::vector<SimTask*> tasks;
+
+void syncClock(uint64_t t) {
+    if (t > sim::now()) {
+        sim::setNow(t);
+    }
+}
+
+void checkExit() {
+    if (currentTask && (shuttingDown || currentTask->deleted)) {
+        throw TaskExit();
+    }
+}
+
+// Simulated time a wait of ticks can last until; queue items stamped later
+// are not there yet as far as the waiter is concerned.
+uint64_t waitLimit(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return UINT64_MAX;
+    }
+    return sim::now() + static_cast<uint64_t>(ticks) * portTICK_PERIOD_MS * 1000;
+}
+
+// Publishes what the current task is blocked on for as long as it waits.
+class WaitScope {
+public:
+    WaitScope(std::mutex* lock, const std::function<bool()>& ready, uint64_t until)
+        : task(currentTask) {
+        if (!task) {
+            return;
+        }
+        sim::Untracked untracked;
+        std::lock_guard<std::mutex> guard(task->waitState);
+        task->waiting = true;
+        task->waitSerial++;
+        task->waitLock = lock;
+        task->waitReady = ready;
+        task->waitUntil = until;
+    }
+
+    ~WaitScope() {
+        if (!task) {
+            return;
+        }
+        sim::Untracked untracked;
+        std::lock_guard<std::mutex> guard(task->waitState);
+        task->waiting = false;
+        task->waitReady = nullptr;
+    }
+
+private:
+    SimTask* task;
+};
+
+// Waits on cv until ready() holds. Returns false when a finite timeout
+// expires, with the clock set to the end of it. A task's timeout expires
+// once the harness clock reaches it; on the harness thread it expires
+// after a short real wait.
+template <typename Ready>
+bool waitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, TickType_t ticks,
+             uint64_t limit, Ready ready) {
+    if (ready()) {
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+    bool gated = currentTask && ticks != portMAX_DELAY;
+    WaitScope scope(lock.mutex(), ready, gated ? limit : UINT64_MAX);
+    auto deadline = std::chrono::steady_clock::now() + MAX_REAL_WAIT;
+    while (!ready()) {
+        if (shuttingDown || (currentTask && currentTask->deleted)) {
+            lock.unlock();
+            checkExit();
+            lock.lock();
+            return false;
+        }
+        if (gated && sim::harnessNow() >= limit) {
+            sim::setNow(limit);
+            return false;
+        }
+        cv.wait_for(lock, gated ? GATE_INTERVAL : std::chrono::microseconds(POLL_INTERVAL));
+        if (!gated && ticks != portMAX_DELAY && std::chrono::steady_clock::now() > deadline &&
+            !ready()) {
+            sim::setNow(limit);
+            return false;
+        }
+    }
+    return true;
+}
+
+void taskEntry(SimTask* task, uint64_t startTime) {
+    sim::taskThread();
+    currentTask = task;
+    sim::setNow(startTime);
+    try {
+        task->fn(task->param);
+    } catch (const TaskExit&) {
+    }
+    task->finished = true;
+}
+
+}  // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName,
+                                   uint32_t usStackDepth, void* pvParameters,
+                                   UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask,
+                                   BaseType_t xCoreID) {
+    (void)pcName;
+    (void)usStackDepth;
+    sim::record("xTaskCreate");
+    sim::Untracked untracked;
+    SimTask* task = new SimTask();
+    task->fn = pvTaskCode;
+    task->param = pvParameters;
+    task->priority = uxPriority;
+    task->core = xCoreID;
+    if (pvCreatedTask) {
+        *pvCreatedTask = task;
+    }
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        tasks.push_back(task);
+    }
+    task->thread = std::thread(taskEntry, task, sim::now());
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth,
+                       void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask) {
+    return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority,
+                                   pvCreatedTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    SimTask* task = xTaskToDelete ? xTaskToDelete : currentTask;
+    if (!task) {
+        return;
+    }
+    task->deleted = true;
+    task->cv.notify_all();
+    if (task == currentTask) {
+        throw TaskExit();
+    }
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+    checkExit();
+    sim::advance(static_cast<uint64_t>(xTicksToDelay) * portTICK_PERIOD_MS * 1000);
+    std::this_thread::yield();
+}
+
+TickType_t xTaskGetTickCount() {
+    return static_cast<TickType_t>(sim::now() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return currentTask; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+    std::lock_guard<std::mutex> lock(xTaskToNotify->m);
+    xTaskToNotify->notifyCount++;
+    if (sim::now() > xTaskToNotify->notifyTime) {
+        xTaskToNotify->notifyTime = sim::now();
+    }
+    xTaskToNotify->cv.notify_all();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    SimTask* task = currentTask;
+    if (!task) {
+        return 0;
+    }
+    std::unique_lock<std::mutex> lock(task->m);
+    if (!waitFor(lock, task->cv, xTicksToWait, waitLimit(xTicksToWait),
+                 [task] { return task->notifyCount > 0; })) {
+        return 0;
+    }
+    uint32_t count = task->notifyCount;
+    task->notifyCount = xClearCountOnExit ? 0 : count - 1;
+    syncClock(task->notifyTime);
+    return count;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask) {
+    SimTask* task = xTask ? xTask : currentTask;
+    return task ? task->priority : 1;
+}
+
+BaseType_t xPortGetCoreID() {
+    return currentTask && currentTask->core != tskNO_AFFINITY ? currentTask->core : 1;
+}
+
+QueueHandle_t simQueueCreate(UBaseType_t length, UBaseType_t itemSize, UBaseType_t initialItems) {
+    sim::Untracked untracked;
+    SimQueue* q = new SimQueue();
+    q->itemSize = itemSize;
+    for (UBaseType_t i = 0; i < length; i++) {
+        if (i < initialItems) {
+            q->items.push_back({std::vector<uint8_t>(itemSize), 0});
+        } else {
+            q->freeSlots.push_back(0);
+        }
+    }
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    return simQueueCreate(uxQueueLength, uxItemSize, 0);
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+    sim::Untracked untracked;
+    delete xQueue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait) {
+    std::unique_lock<std::mutex> lock(xQueue->m);
+    if (!waitFor(lock, xQueue->cv, xTicksToWait, waitLimit(xTicksToWait),
+                 [xQueue] { return !xQueue->freeSlots.empty(); })) {
+        return errQUEUE_FULL;
+    }
+    syncClock(xQueue->freeSlots.front());
+    xQueue->freeSlots.pop_front();
+    sim::Untracked untracked;
+    SimQueue::Item item;
+    item.data.resize(xQueue->itemSize);
+    if (xQueue->itemSize) {
+        memcpy(item.data.data(), pvItemToQueue, xQueue->itemSize);
+    }
+    item.time = sim::now();
+    xQueue->items.push_back(std::move(item));
+    xQueue->cv.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void* pvItemToQueue,
+                            TickType_t xTicksToWait) {
+    return xQueueSend(xQueue, pvItemToQueue, xTicksToWait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue,
+                             BaseType_t* pxHigherPriorityTaskWoken) {
+    if (pxHigherPriorityTaskWoken) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return xQueueSend(xQueue, pvItemToQueue, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait) {
+    if (!currentTask && xTicksToWait != portMAX_DELAY) {
+        // Tasks on the other core would have run up to now
+        sim::settleTasks();
+    }
+    std::unique_lock<std::mutex> lock(xQueue->m);
+    uint64_t limit = waitLimit(xTicksToWait);
+    if (!waitFor(lock, xQueue->cv, xTicksToWait, limit, [xQueue, limit] {
+            return !xQueue->items.empty() && xQueue->items.front().time <= limit;
+        })) {
+        return pdFALSE;
+    }
+    SimQueue::Item& item = xQueue->items.front();
+    syncClock(item.time);
+    if (xQueue->itemSize && pvBuffer) {
+        memcpy(pvBuffer, item.data.data(), xQueue->itemSize);
+    }
+    sim::Untracked untracked;
+    xQueue->items.pop_front();
+    xQueue->freeSlots.push_back(sim::now());
+    xQueue->cv.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->m);
+    sim::Untracked untracked;
+    while (!xQueue->items.empty()) {
+        xQueue->items.pop_front();
+        xQueue->freeSlots.push_back(sim::now());
+    }
+    xQueue->cv.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->m);
+    return xQueue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->m);
+    return xQueue->freeSlots.size();
+}
+
+namespace sim {
+
+void stopTasks() {
+    shuttingDown = true;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (SimTask* task : tasks) {
+        task->cv.notify_all();
+        if (task->thread.joinable()) {
+            task->thread.join();
+        }
+    }
+}
+
+void settleTasks() {
+    if (currentTask) {
+        return;
+    }
+    sim::Untracked untracked;
+    std::vector<uint64_t> previous;
+    bool wasBlocked = false;
+    for (;;) {
+        // Two looks in a row that find every task in the same wait, with
+        // nothing there for it, mean none of them can still move
+        std::vector<uint64_t> serials;
+        bool blocked = true;
+        {
+            std::lock_guard<std::mutex> registry(registryMutex);
+            for (SimTask* task : tasks) {
+                if (task->finished) {
+                    serials.push_back(0);
+                    continue;
+                }
+                std::mutex* lock;
+                std::function<bool()> ready;
+                uint64_t until;
+                {
+                    std::lock_guard<std::mutex> guard(task->waitState);
+                    if (!task->waiting) {
+                        blocked = false;
+                        break;
+                    }
+                    lock = task->waitLock;
+                    ready = task->waitReady;
+                    until = task->waitUntil;
+                    serials.push_back(task->waitSerial);
+                }
+                std::lock_guard<std::mutex> guard(*lock);
+                if (until <= sim::harnessNow() || ready()) {
+                    blocked = false;
+                    break;
+                }
+            }
+        }
+        if (blocked && wasBlocked && serials == previous) {
+            return;
+        }
+        wasBlocked = blocked;
+        previous.swap(serials);
+        if (!blocked) {
+            std::this_thread::sleep_for(GATE_INTERVAL);
+        }
+    }
+}
+
+}  // namespace sim
@@ -0,0 +1,50 @@
+#ifndef HAL_SIM_FREERTOS_H
+#define HAL_SIM_FREERTOS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// FreeRTOS stand-in: tasks are host threads, queues and semaphores are
+// mutex/condition-variable FIFOs. Every queued item and every freed slot
+// carries the simulated time it was produced at, and the receiving task's
+// clock is advanced to it, so work overlapped on two tasks shows up as
+// overlapped in simulated time.
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS (pdTRUE)
+#define pdFAIL (pdFALSE)
+#define errQUEUE_FULL ((BaseType_t)0)
+#define errQUEUE_EMPTY ((BaseType_t)0)
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+#define configMAX_PRIORITIES 25
+#define portYIELD_FROM_ISR() ((void)0)
+
+namespace sim {
+
+// Asks every simulated task to exit at its next blocking call and waits for
+// them. The benchmark harness calls this before returning from main().
+void stopTasks();
+
+// Waits until every simulated task is blocked with nothing there for it:
+// no queue item or free slot, no notification, no timeout the harness
+// clock has reached. A non-blocking receive on the harness thread does
+// this first, since a task on the other core would have run by then;
+// benchmarks call it before looking at state a task owns.
+void settleTasks();
+
+}  // namespace sim
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HAL_SIM_FREERTOS_SEMPHR_H
+#define HAL_SIM_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+// As in FreeRTOS, semaphores are queues of zero-sized items.
+typedef QueueHandle_t SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return simQueueCreate(1, 0, 0); }
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return simQueueCreate(1, 0, 1); }
+inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount,
+                                                  UBaseType_t uxInitialCount) {
+    return simQueueCreate(uxMaxCount, 0, uxInitialCount);
+}
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime) {
+    return xQueueReceive(xSemaphore, nullptr, xBlockTime);
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+    return xQueueSend(xSemaphore, nullptr, 0);
+}
+inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore,
+                                        BaseType_t* pxHigherPriorityTaskWoken) {
+    return xQueueSendFromISR(xSemaphore, nullptr, pxHigherPriorityTaskWoken);
+}
+inline void vSemaphoreDelete(SemaphoreHandle_t xSemaphore) { vQueueDelete(xSemaphore); }
+
+#endif
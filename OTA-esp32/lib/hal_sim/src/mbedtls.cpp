@@ -0,0 +1,209 @@
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include <cstring>
+#include <string>
+
+#include "mbedtls/pk.h"
+#include "mbedtls/sha256.h"
+#include "ota_signing_key.h"
+#include "sim.h"
+
+namespace {
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+// The run's signing key, made on first use
+EVP_PKEY* signingKey() {
+    static EVP_PKEY* key = [] {
+        sim::Untracked untracked;
+        return EVP_EC_gen("P-256");
+    }();
+    return key;
+}
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+void transform(uint32_t state[8], const unsigned char block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] +
+                      w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+}  // namespace
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx) { memset(ctx, 0, sizeof(*ctx)); }
+
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx) {
+    if (ctx) {
+        memset(ctx, 0, sizeof(*ctx));
+    }
+}
+
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context* ctx, int is224) {
+    static const uint32_t init256[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    ctx->total[0] = ctx->total[1] = 0;
+    memcpy(ctx->state, init256, sizeof(init256));
+    ctx->is224 = is224;  // SHA-224 is not used by the firmware
+    return 0;
+}
+
+int mbedtls_sha256_update_ret(mbedtls_sha256_context* ctx, const unsigned char* input,
+                              size_t ilen) {
+    sim::advance(static_cast<uint64_t>(ilen) * 1000000 / sim::costs().shaBytesPerSecond);
+    size_t fill = ctx->total[0] & 63;
+    ctx->total[0] += static_cast<uint32_t>(ilen);
+    if (ctx->total[0] < ilen) {
+        ctx->total[1]++;
+    }
+    if (fill && ilen >= 64 - fill) {
+        memcpy(ctx->buffer + fill, input, 64 - fill);
+        transform(ctx->state, ctx->buffer);
+        input += 64 - fill;
+        ilen -= 64 - fill;
+        fill = 0;
+    }
+    while (ilen >= 64) {
+        transform(ctx->state, input);
+        input += 64;
+        ilen -= 64;
+    }
+    memcpy(ctx->buffer + fill, input, ilen);
+    return 0;
+}
+
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context* ctx, unsigned char output[32]) {
+    uint64_t bits = ((static_cast<uint64_t>(ctx->total[1]) << 32) | ctx->total[0]) * 8;
+    size_t fill = ctx->total[0] & 63;
+    ctx->buffer[fill++] = 0x80;
+    if (fill > 56) {
+        memset(ctx->buffer + fill, 0, 64 - fill);
+        transform(ctx->state, ctx->buffer);
+        fill = 0;
+    }
+    memset(ctx->buffer + fill, 0, 56 - fill);
+    for (int i = 0; i < 8; i++) {
+        ctx->buffer[56 + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    transform(ctx->state, ctx->buffer);
+    for (int i = 0; i < 8; i++) {
+        output[i * 4] = static_cast<unsigned char>(ctx->state[i] >> 24);
+        output[i * 4 + 1] = static_cast<unsigned char>(ctx->state[i] >> 16);
+        output[i * 4 + 2] = static_cast<unsigned char>(ctx->state[i] >> 8);
+        output[i * 4 + 3] = static_cast<unsigned char>(ctx->state[i]);
+    }
+    return 0;
+}
+
+void mbedtls_pk_init(mbedtls_pk_context* ctx) { ctx->pk_ctx = nullptr; }
+
+void mbedtls_pk_free(mbedtls_pk_context* ctx) {
+    if (ctx && ctx->pk_ctx) {
+        sim::Untracked untracked;
+        EVP_PKEY_free(static_cast<EVP_PKEY*>(ctx->pk_ctx));
+        ctx->pk_ctx = nullptr;
+    }
+}
+
+int mbedtls_pk_parse_public_key(mbedtls_pk_context* ctx, const unsigned char* key,
+                                size_t keylen) {
+    if (keylen == 0 || key[keylen - 1] != '\0') {
+        return MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+    }
+    sim::Untracked untracked;
+    BIO* bio = BIO_new_mem_buf(key, static_cast<int>(keylen - 1));
+    EVP_PKEY* pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    if (!pkey) {
+        return MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+    }
+    ctx->pk_ctx = pkey;
+    return 0;
+}
+
+int mbedtls_pk_verify(mbedtls_pk_context* ctx, mbedtls_md_type_t md_alg,
+                      const unsigned char* hash, size_t hash_len, const unsigned char* sig,
+                      size_t sig_len) {
+    sim::record("mbedtls_pk_verify");
+    if (!ctx->pk_ctx || md_alg != MBEDTLS_MD_SHA256 || hash_len != 32) {
+        return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+    }
+    sim::advance(sim::costs().ecdsaVerifyUs);
+    sim::Untracked untracked;
+    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new(static_cast<EVP_PKEY*>(ctx->pk_ctx), nullptr);
+    int ok = pctx && EVP_PKEY_verify_init(pctx) == 1 &&
+             EVP_PKEY_verify(pctx, sig, sig_len, hash, hash_len) == 1;
+    EVP_PKEY_CTX_free(pctx);
+    return ok ? 0 : MBEDTLS_ERR_ECP_VERIFY_FAILED;
+}
+
+namespace sim {
+
+const char* signingPublicKey() {
+    static const std::string pem = [] {
+        sim::Untracked untracked;
+        BIO* bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PUBKEY(bio, signingKey());
+        char* data = nullptr;
+        long length = BIO_get_mem_data(bio, &data);
+        std::string text(data, length);
+        BIO_free(bio);
+        return text;
+    }();
+    return pem.c_str();
+}
+
+size_t sign(const uint8_t* data, size_t size, uint8_t* signature, size_t capacity) {
+    Untracked untracked;
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    size_t length = 0;
+    bool ok = EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, signingKey()) == 1 &&
+              EVP_DigestSign(ctx, nullptr, &length, data, size) == 1 && length <= capacity &&
+              EVP_DigestSign(ctx, signature, &length, data, size) == 1;
+    EVP_MD_CTX_free(ctx);
+    return ok ? length : 0;
+}
+
+}  // namespace sim
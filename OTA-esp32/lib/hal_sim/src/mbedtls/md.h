@@ -0,0 +1,9 @@
+#ifndef HAL_SIM_MBEDTLS_MD_H
+#define HAL_SIM_MBEDTLS_MD_H
+
+typedef enum {
+    MBEDTLS_MD_NONE = 0,
+    MBEDTLS_MD_SHA256 = 6,
+} mbedtls_md_type_t;
+
+#endif
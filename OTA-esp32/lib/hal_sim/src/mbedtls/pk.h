@@ -0,0 +1,28 @@
+#ifndef HAL_SIM_MBEDTLS_PK_H
+#define HAL_SIM_MBEDTLS_PK_H
+
+#include <cstddef>
+
+#include "mbedtls/md.h"
+
+#define MBEDTLS_ERR_PK_BAD_INPUT_DATA -0x3E80
+#define MBEDTLS_ERR_PK_KEY_INVALID_FORMAT -0x3D00
+#define MBEDTLS_ERR_ECP_VERIFY_FAILED -0x4E00
+
+// Public-key subset of mbedtls 2.x, backed by host OpenSSL. Verification
+// is charged sim::costs().ecdsaVerifyUs.
+typedef struct {
+    void* pk_ctx;
+} mbedtls_pk_context;
+
+void mbedtls_pk_init(mbedtls_pk_context* ctx);
+void mbedtls_pk_free(mbedtls_pk_context* ctx);
+// PEM input must include the terminating NUL in keylen, as in mbedtls
+int mbedtls_pk_parse_public_key(mbedtls_pk_context* ctx, const unsigned char* key,
+                                size_t keylen);
+// sig is a DER-encoded ECDSA signature
+int mbedtls_pk_verify(mbedtls_pk_context* ctx, mbedtls_md_type_t md_alg,
+                      const unsigned char* hash, size_t hash_len, const unsigned char* sig,
+                      size_t sig_len);
+
+#endif
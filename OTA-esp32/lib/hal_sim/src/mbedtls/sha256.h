@@ -0,0 +1,23 @@
+#ifndef HAL_SIM_MBEDTLS_SHA256_H
+#define HAL_SIM_MBEDTLS_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+// mbedtls 2.x SHA-256 API (the ESP32 port routes it to the SHA
+// accelerator). Hashing is charged at sim::costs().shaBytesPerSecond.
+typedef struct {
+    uint32_t total[2];
+    uint32_t state[8];
+    unsigned char buffer[64];
+    int is224;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx);
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context* ctx, int is224);
+int mbedtls_sha256_update_ret(mbedtls_sha256_context* ctx, const unsigned char* input,
+                              size_t ilen);
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context* ctx, unsigned char output[32]);
+
+#endif
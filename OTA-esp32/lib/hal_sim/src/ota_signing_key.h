@@ -0,0 +1,16 @@
+#ifndef HAL_SIM_OTA_SIGNING_KEY_H
+#define HAL_SIM_OTA_SIGNING_KEY_H
+
+// Stand-in for the ota_signing_key.h that tools/sign_firmware.py --new-key
+// writes: the native build checks images against a P-256 key the
+// simulation makes when it starts, so no private key lives in the tree.
+namespace sim {
+
+// PEM public key, NUL-terminated; sim::sign() signs with its private half.
+const char* signingPublicKey();
+
+}  // namespace sim
+
+#define OTA_PUBLIC_KEY_PEM sim::signingPublicKey()
+
+#endif
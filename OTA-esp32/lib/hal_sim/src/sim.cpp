@@ -0,0 +1,179 @@
+#include "sim.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace sim {
+
+static thread_local uint64_t clockUs = 0;
+static thread_local bool onTask = false;
+static std::atomic<uint64_t> harnessClockUs{0};
+
+uint64_t now() { return clockUs; }
+
+void advance(uint64_t us) {
+    clockUs += us;
+    if (!onTask) {
+        harnessClockUs = clockUs;
+    }
+}
+
+void setNow(uint64_t us) {
+    clockUs = us;
+    if (!onTask) {
+        harnessClockUs = clockUs;
+    }
+}
+
+uint64_t harnessNow() { return harnessClockUs; }
+void taskThread() { onTask = true; }
+bool isTaskThread() { return onTask; }
+
+struct CallSlot {
+    const char* name;
+    unsigned long count;
+};
+static const int MAX_CALL_SLOTS = 256;
+static CallSlot callSlots[MAX_CALL_SLOTS];
+static int callSlotCount = 0;
+static std::mutex callMutex;
+
+static CallSlot* findSlot(const char* what, bool create) {
+    for (int i = 0; i < callSlotCount; i++) {
+        if (callSlots[i].name == what || strcmp(callSlots[i].name, what) == 0) {
+            return &callSlots[i];
+        }
+    }
+    if (!create || callSlotCount == MAX_CALL_SLOTS) {
+        return nullptr;
+    }
+    callSlots[callSlotCount] = {what, 0};
+    return &callSlots[callSlotCount++];
+}
+
+void record(const char* what) {
+    std::lock_guard<std::mutex> lock(callMutex);
+    CallSlot* slot = findSlot(what, true);
+    if (slot) {
+        slot->count++;
+    }
+}
+
+unsigned long calls(const char* what) {
+    std::lock_guard<std::mutex> lock(callMutex);
+    CallSlot* slot = findSlot(what, false);
+    return slot ? slot->count : 0;
+}
+
+void resetCalls() {
+    std::lock_guard<std::mutex> lock(callMutex);
+    callSlotCount = 0;
+}
+
+static std::atomic<size_t> allocCount{0};
+static std::atomic<size_t> freeCount{0};
+static std::atomic<size_t> bytesInUse{0};
+static std::atomic<size_t> peakBytes{0};
+static thread_local int untrackedDepth = 0;
+
+HeapStats heap() {
+    return {allocCount.load(), freeCount.load(), bytesInUse.load(), peakBytes.load()};
+}
+
+void resetHeapPeak() { peakBytes = bytesInUse.load(); }
+
+Untracked::Untracked() { untrackedDepth++; }
+Untracked::~Untracked() { untrackedDepth--; }
+
+// Every block carries a small header with its size and whether it was
+// counted, so frees balance even when they cross an Untracked scope.
+struct BlockHeader {
+    size_t size;
+    size_t tracked;
+};
+static_assert(sizeof(BlockHeader) % alignof(std::max_align_t) == 0,
+              "header keeps payload aligned");
+
+void* trackedAlloc(size_t size) {
+    BlockHeader* h = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+    if (!h) {
+        throw std::bad_alloc();
+    }
+    h->size = size;
+    h->tracked = untrackedDepth == 0;
+    if (h->tracked) {
+        allocCount++;
+        size_t inUse = bytesInUse += size;
+        size_t peak = peakBytes.load();
+        while (inUse > peak && !peakBytes.compare_exchange_weak(peak, inUse)) {
+        }
+    }
+    return h + 1;
+}
+
+void trackedFree(void* p) {
+    if (!p) {
+        return;
+    }
+    BlockHeader* h = static_cast<BlockHeader*>(p) - 1;
+    if (h->tracked) {
+        freeCount++;
+        bytesInUse -= h->size;
+    }
+    free(h);
+}
+
+Costs& costs() {
+    static Costs c = {
+        25000,    // flashEraseSectorUs
+        9000,     // flashProgramSectorUs
+        300,      // flashReadSectorUs
+        5000000,  // shaBytesPerSecond
+        40000,    // ecdsaVerifyUs
+        8000000,  // linkBitsPerSecond
+        120,      // scanDwellMs
+        1800,     // connectMs
+        1000,     // connectScanMs
+        600,      // dhcpMs
+        800,      // connectMissMs
+        3000,     // nvsWriteUs
+        150,      // nvsReadUs
+    };
+    return c;
+}
+
+bool verbose() {
+    static int v = -1;
+    if (v < 0) {
+        const char* env = getenv("SIM_VERBOSE");
+        v = env && env[0] == '1';
+    }
+    return v;
+}
+
+}  // namespace sim
+
+void* operator new(size_t size) { return sim::trackedAlloc(size); }
+void* operator new[](size_t size) { return sim::trackedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return sim::trackedAlloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return sim::trackedAlloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void operator delete(void* p) noexcept { sim::trackedFree(p); }
+void operator delete[](void* p) noexcept { sim::trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { sim::trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { sim::trackedFree(p); }
@@ -0,0 +1,89 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Control surface of the host simulation. Firmware code never includes this;
+// the stand-in headers (Arduino.h, WiFi.h, ...) use it to advance simulated
+// time and record calls, and the benchmark harness uses it to drive and
+// observe them.
+namespace sim {
+
+// Simulated clock in microseconds. millis()/micros() read it, delay() and the
+// modelled hardware costs (I2C transfers, flash erase/program, radio time)
+// advance it. The clock is per thread so work overlapped on two tasks is
+// not counted twice.
+uint64_t now();
+void advance(uint64_t us);
+void setNow(uint64_t us);
+
+// Clock of the harness thread (the Arduino loop task), readable from any
+// thread. Simulated tasks time their timeouts against it: a task's timed
+// wait only expires once the harness has got that far, so its clock never
+// runs ahead of the loop it is racing. taskThread() marks the calling
+// thread as a task; the FreeRTOS stand-in calls it.
+uint64_t harnessNow();
+void taskThread();
+bool isTaskThread();
+
+// Counts calls by name. Names must be string literals; lookups compare
+// pointers first so recording is cheap and never allocates.
+void record(const char* what);
+unsigned long calls(const char* what);
+void resetCalls();
+
+// Heap accounting from the global operator new/delete overrides.
+struct HeapStats {
+    size_t allocations;
+    size_t frees;
+    size_t bytesInUse;
+    size_t peakBytes;
+};
+HeapStats heap();
+void resetHeapPeak();
+
+// Allocations made by the simulation itself (captured responses, flash
+// image, ...) are excluded from HeapStats while one of these is alive.
+class Untracked {
+public:
+    Untracked();
+    ~Untracked();
+};
+
+// Modelled hardware costs. Defaults approximate an ESP32 with the stock
+// SSD1306 module and QIO flash; benchmarks may override them.
+struct Costs {
+    uint32_t flashEraseSectorUs;   // 4 KiB sector erase
+    uint32_t flashProgramSectorUs; // 16 x 256 byte page programs
+    uint32_t flashReadSectorUs;    // 4 KiB read through the cache-bypassing API
+    uint32_t shaBytesPerSecond;    // SHA-256 through the hardware accelerator
+    uint32_t ecdsaVerifyUs;        // one P-256 signature check in mbedtls
+    uint32_t linkBitsPerSecond;    // HTTP upload payload rate
+    uint32_t scanDwellMs;          // per channel, active scan default
+    uint32_t connectMs;            // association + DHCP
+    uint32_t connectScanMs;        // of which finding the AP, when no channel/BSSID is given
+    uint32_t dhcpMs;               // of which DHCP, when no static IP is set
+    uint32_t connectMissMs;        // a channel/BSSID connect where nothing answers, to giving up
+    uint32_t nvsWriteUs;           // one Preferences put, committed
+    uint32_t nvsReadUs;            // one Preferences key lookup
+};
+Costs& costs();
+
+// Environment variable SIM_VERBOSE=1 echoes Serial output to stderr.
+bool verbose();
+
+// GPIO: drive a pin level and fire any interrupt attached to the edge.
+void setPin(uint8_t pin, int level);
+
+// Contents of the running app partition, as read by esp_partition_read().
+void setRunningImage(const uint8_t* data, size_t size);
+
+// Signs with the P-256 key made for this run, whose public half the native
+// build trusts (ota_signing_key.h): writes the DER ECDSA signature over
+// SHA-256(data) and returns its length, 0 when it does not fit.
+size_t sign(const uint8_t* data, size_t size, uint8_t* signature, size_t capacity);
+
+}  // namespace sim
+
+#endif
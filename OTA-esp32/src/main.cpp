@@ -4,88 +4,313 @@
 #include <WiFiClient.h>
 #include <WebServer.h>
 #include <Update.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <atomic>
 #include "config.h"
 #include "display.h"
+#include "http_task.h"
 #include "wifi_scanner.h"
 #include "menu.h"
+#include "input_events.h"
+#include "ota_pipeline.h"
+#include "ota_progress.h"
+#include "ota_resume.h"
+#include "settings.h"
+#include "static_assets.h"
+#include "task_messages.h"
 
 // Global objects
 Display* display;
 WiFiScanner* wifiScanner;
 Menu* menu;
+Settings settings;
 WebServer server(OTA_PORT);
+OtaPipeline otaPipeline;
+OtaResume otaResume(otaPipeline);
+OtaProgress otaProgress(otaPipeline);
+HttpTask* otaHttp;
 
-// Button states
-volatile bool upPressed = false;
-volatile bool downPressed = false;
-volatile bool selectPressed = false;
+// loop() runs scans and connects on core 1 next to the web server tasks,
+// and the UI task runs the menu, buttons and display on core 0; the menu
+// and the network side only talk through these queues
+QueueHandle_t uiQueue;   // UiMessage: button edges and network events
+QueueHandle_t netQueue;  // NetMessage: requests from the menu
 
-// Button debounce
-unsigned long lastDebounceTime = 0;
-const unsigned long debounceDelay = 50;
+// Debounce for the ISRs, press/hold timing for the UI task
+InputEvents inputEvents;
 
-void IRAM_ATTR handleUpButton() {
-    if((millis() - lastDebounceTime) > debounceDelay) {
-        upPressed = true;
-        lastDebounceTime = millis();
+// Boot to mDNS up and the OTA server answering by name, 0 until then
+unsigned long otaReadyMs = 0;
+
+// Latest upload percentage for the OLED bar. At most one UI_OTA_PROGRESS
+// is queued at a time and the UI task reads the newest value when it gets
+// there, so progress never crowds button edges out of the UI queue.
+std::atomic<int> otaPercent(-1);
+std::atomic<bool> otaPercentQueued(false);
+
+void IRAM_ATTR postEdge(uint8_t button, uint8_t pin) {
+    UiMessage message;
+    message.type = UI_BUTTON;
+    message.button = button;
+    message.pressed = digitalRead(pin) == LOW;
+    message.value = 0;
+    message.time = millis();
+    if (!inputEvents.edge(button, message.time)) {
+        return;
+    }
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(uiQueue, &message, &woken) != pdTRUE) {
+        inputEvents.dropEdge();
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
     }
 }
 
+void IRAM_ATTR handleUpButton() {
+    postEdge(BTN_UP, BUTTON_UP);
+}
+
 void IRAM_ATTR handleDownButton() {
-    if((millis() - lastDebounceTime) > debounceDelay) {
-        downPressed = true;
-        lastDebounceTime = millis();
-    }
+    postEdge(BTN_DOWN, BUTTON_DOWN);
 }
 
 void IRAM_ATTR handleSelectButton() {
-    if((millis() - lastDebounceTime) > debounceDelay) {
-        selectPressed = true;
-        lastDebounceTime = millis();
+    postEdge(BTN_SELECT, BUTTON_SELECT);
+}
+
+// Network side: tells the UI task what happened
+bool postToUi(uint8_t type, int16_t value) {
+    UiMessage message;
+    message.type = type;
+    message.button = 0;
+    message.pressed = false;
+    message.value = value;
+    message.time = millis();
+    if (xQueueSend(uiQueue, &message, 0) != pdTRUE) {
+        Serial.printf("UI queue full, event %u dropped\n", type);
+        return false;
+    }
+    return true;
+}
+
+void postOtaProgress(int percent) {
+    otaPercent = percent;
+    if (!otaPercentQueued.exchange(true) && !postToUi(UI_OTA_PROGRESS, percent)) {
+        otaPercentQueued = false;
+    }
+}
+
+void runAction(const InputEvents::Event& event) {
+    switch (event.action) {
+        case ACTION_UP:     menu->handleUpButton(); break;
+        case ACTION_DOWN:   menu->handleDownButton(); break;
+        case ACTION_SELECT: menu->handleSelectButton(); break;
+        case ACTION_BACK:   menu->handleBackButton(); break;
+    }
+}
+
+void handleUiMessage(const UiMessage& message) {
+    InputEvents::Event event;
+    switch (message.type) {
+        case UI_BUTTON:
+            if (inputEvents.apply(message.button, message.pressed, message.time, &event)) {
+                runAction(event);
+            }
+            break;
+        case UI_SCAN_COMPLETE:  menu->handleScanComplete(message.value); break;
+        case UI_CONNECT_RESULT:
+            menu->handleConnectResult(message.value > 0, message.value > 0 ? 0 : -message.value);
+            break;
+        case UI_AP_MODE:        menu->handleAPModeChanged(message.value != 0); break;
+        case UI_OTA_READY:      menu->noteOtaReady(message.time); break;
+        case UI_OTA_PROGRESS:
+            otaPercentQueued = false;
+            display->showProgress(otaPercent);
+            break;
+        case UI_OTA_RESULT:
+            display->showProgress(-1);
+            display->showNotification(message.value ? "Update OK" : "Update failed");
+            break;
+    }
+}
+
+// Core 0: sleeps on the UI queue until a message comes in, a button
+// timer is due or the status bar needs its tick, so a busy network side
+// (an OTA upload takes seconds) never delays a press.
+void uiTask(void*) {
+    unsigned long lastUpdate = millis();
+    for (;;) {
+        unsigned long sinceUpdate = millis() - lastUpdate;
+        long wait = sinceUpdate < STATUS_BAR_UPDATE_INTERVAL ?
+                    STATUS_BAR_UPDATE_INTERVAL - sinceUpdate : 0;
+        long timer = inputEvents.nextTimer();
+        if (timer >= 0 && timer < wait) {
+            wait = timer;
+        }
+        long commit = settings.nextCommit();
+        if (commit >= 0 && commit < wait) {
+            wait = commit;
+        }
+        UiMessage message;
+        if (xQueueReceive(uiQueue, &message, pdMS_TO_TICKS(wait)) == pdTRUE) {
+            handleUiMessage(message);
+        }
+        InputEvents::Event event;
+        while (inputEvents.poll(&event)) {
+            runAction(event);
+        }
+        if (millis() - lastUpdate >= STATUS_BAR_UPDATE_INTERVAL) {
+            lastUpdate = millis();
+            menu->update();
+        }
+        settings.commitIfDue();
+    }
+}
+
+// Core 1: runs what the menu asked for and reports back
+void handleNetCommand(const NetMessage& command) {
+    switch (command.command) {
+        case NET_START_SCAN:
+            if (!wifiScanner->startScan()) {
+                postToUi(UI_SCAN_COMPLETE, 0);
+            }
+            break;
+        case NET_CONNECT:
+            wifiScanner->connect(command.ssid, "");  // see onConnectResult() in setup()
+            break;
+        case NET_SET_AP_MODE:
+            wifiScanner->enableAPMode(command.enable);
+            postToUi(UI_AP_MODE, wifiScanner->isAPMode() ? 1 : 0);
+            break;
+    }
+}
+
+// The OTA server's task: its handlers and the resumable session timeout
+// run on the same thread, so they never race
+void serveOta() {
+    if (WiFi.status() == WL_CONNECTED) {
+        server.handleClient();
+    }
+    otaResume.poll();  // Drop abandoned resumable updates
+    if (!otaPipeline.isActive()) {
+        otaProgress.finish(OtaProgress::OTA_ABORTED);  // no-op unless a session was dropped
     }
 }
 
 void setupOTA() {
     // OTA Update webpage
+    collectAssetHeaders(server);
     server.on("/", HTTP_GET, []() {
         server.sendHeader("Connection", "close");
-        server.send(200, "text/html", 
-            "<form method='POST' action='/update' enctype='multipart/form-data'>"
-            "<input type='file' name='update'>"
-            "<input type='submit' value='Update'>"
-            "</form>");
+        sendAsset(server, WEB_UPDATE_HTML);
     });
 
     server.on("/update", HTTP_POST, []() {
+        otaProgress.finish(otaPipeline.hasError() ? OtaProgress::OTA_FAILED : OtaProgress::OTA_DONE);
         server.sendHeader("Connection", "close");
-        server.send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
+        server.send(200, "text/plain", (otaPipeline.hasError()) ? "FAIL" : "OK");
+        settings.commit();  // a change still waiting out its delay
         ESP.restart();
     }, []() {
         HTTPUpload& upload = server.upload();
         if(upload.status == UPLOAD_FILE_START) {
             Serial.printf("Update: %s\n", upload.filename.c_str());
-            if(!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+            if(!otaPipeline.begin(UPDATE_SIZE_UNKNOWN)) {
                 Update.printError(Serial);
+            } else {
+                otaProgress.begin(server.clientContentLength());
             }
         } else if(upload.status == UPLOAD_FILE_WRITE) {
-            if(Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
+            // Copies into the sector buffers; flash writes happen on the writer task
+            if(otaPipeline.isActive() && !otaPipeline.write(upload.buf, upload.currentSize)) {
                 Update.printError(Serial);
             }
+            otaProgress.update();
         } else if(upload.status == UPLOAD_FILE_END) {
-            if(Update.end(true)) {
-                Serial.printf("Update Success: %u\nRebooting...\n", upload.totalSize);
+            if(otaPipeline.end()) {
+                Serial.printf("Update Success: %u%s%s\nRebooting...\n", (unsigned)otaPipeline.written(),
+                              otaPipeline.isCompressed() ? " (gzip)" : "",
+                              otaPipeline.isDelta() ? " (delta)" : "");
             } else {
                 Update.printError(Serial);
             }
+        } else if(upload.status == UPLOAD_FILE_ABORTED) {
+            otaPipeline.abort();
+            otaProgress.finish(OtaProgress::OTA_ABORTED);
+            Serial.println("Update aborted");
+        }
+    });
+
+    // Resumable update: PUT one chunk at a time, see ota_resume.h
+    server.on("/update", HTTP_PUT, []() {
+        switch (otaResume.lastResult()) {
+            case OtaResume::RESUME_COMPLETE: otaProgress.finish(OtaProgress::OTA_DONE); break;
+            case OtaResume::RESUME_FAILED:   otaProgress.finish(OtaProgress::OTA_FAILED); break;
+            default:                         otaProgress.update(); break;
+        }
+        server.send(otaResume.httpCode(), "application/json", otaResume.statusJson());
+        if (otaResume.lastResult() == OtaResume::RESUME_COMPLETE) {
+            Serial.println("Update Success (resumable)\nRebooting...");
+            settings.commit();
+            ESP.restart();
+        }
+    }, []() {
+        HTTPRaw& raw = server.raw();
+        if(raw.status == RAW_START) {
+            size_t offset = server.arg("offset").toInt();
+            size_t total = server.arg("total").toInt();
+            otaResume.beginChunk(offset, strtoul(server.arg("crc").c_str(), nullptr, 16), total);
+            if (offset == 0 && otaResume.lastResult() == OtaResume::RESUME_ACCEPTED) {
+                otaProgress.begin(total);
+            }
+        } else if(raw.status == RAW_WRITE) {
+            otaResume.chunkData(raw.buf, raw.currentSize);
+        } else if(raw.status == RAW_END) {
+            otaResume.endChunk();
+        } else if(raw.status == RAW_ABORTED) {
+            otaResume.abortChunk();
+            Serial.printf("Update chunk dropped, resume at %u\n", (unsigned)otaResume.offset());
         }
     });
 
+    server.on("/update/status", HTTP_GET, []() {
+        server.send(200, "application/json", otaResume.statusJson());
+    });
+
+    // Server-Sent Events while an upload runs, see ota_progress.h
+    server.on("/update/events", HTTP_GET, []() {
+        otaProgress.addClient(server.client());
+    });
+
+    // Plain-text counters for whoever watches a fleet of these
+    server.on("/metrics", HTTP_GET, []() {
+        char body[160];
+        snprintf(body, sizeof(body),
+                 "boot_to_ota_ready_ms %lu\n"
+                 "time_to_ip_ms %lu\n"
+                 "fast_reconnect %d\n"
+                 "uptime_ms %lu\n",
+                 otaReadyMs, wifiScanner->lastTimeToIp(),
+                 wifiScanner->lastConnectWasCached() ? 1 : 0, millis());
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "text/plain", body);
+    });
+
     server.begin();
 }
 
 void setup() {
     Serial.begin(115200);
     Wire.begin();
+    Wire.setClock(OLED_I2C_CLOCK);
+
+    // Everything the Settings menu stored, in one read
+    unsigned long settingsStart = micros();
+    settings.begin();
+    Serial.printf("Settings loaded in %lu us\n", micros() - settingsStart);
     
     // Initialize display
     display = new Display();
@@ -93,68 +318,87 @@ void setup() {
         Serial.println("Display initialization failed!");
         while(1);
     }
+    if (settings.brightness() != DEFAULT_BRIGHTNESS) {
+        display->setBrightness(settings.brightness());
+    }
     display->showNotification("Starting...");
 
     // Initialize WiFi
-    wifiScanner = new WiFiScanner();
+    wifiScanner = new WiFiScanner(&settings);
     WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(settings.autoConnect());
+    
+    // Queues between the network side and the UI task
+    uiQueue = xQueueCreate(UI_QUEUE_LENGTH, sizeof(UiMessage));
+    netQueue = xQueueCreate(NET_QUEUE_LENGTH, sizeof(NetMessage));
+    wifiScanner->onScanComplete([](int count) {
+        postToUi(UI_SCAN_COMPLETE, count);
+    });
+    wifiScanner->onConnectResult([](bool connected, uint8_t reason) {
+        postToUi(UI_CONNECT_RESULT, connected ? 1 : -(int)reason);
+    });
+    otaProgress.onChange([](OtaProgress::State state, int percent) {
+        if (state != OtaProgress::OTA_RECEIVING) {
+            postToUi(UI_OTA_RESULT, state == OtaProgress::OTA_DONE ? 1 : 0);
+        } else if (percent >= 0) {
+            postOtaProgress(percent);
+        }
+    });
     
     // Initialize menu system
-    menu = new Menu(display, wifiScanner);
+    menu = new Menu(display, wifiScanner, &settings, netQueue);
     
     // Setup button pins with interrupts
     pinMode(BUTTON_UP, INPUT_PULLUP);
     pinMode(BUTTON_DOWN, INPUT_PULLUP);
     pinMode(BUTTON_SELECT, INPUT_PULLUP);
     
-    attachInterrupt(BUTTON_UP, handleUpButton, FALLING);
-    attachInterrupt(BUTTON_DOWN, handleDownButton, FALLING);
-    attachInterrupt(BUTTON_SELECT, handleSelectButton, FALLING);
+    attachInterrupt(BUTTON_UP, handleUpButton, CHANGE);
+    attachInterrupt(BUTTON_DOWN, handleDownButton, CHANGE);
+    attachInterrupt(BUTTON_SELECT, handleSelectButton, CHANGE);
     
-    // Initialize MDNS for OTA - only after WiFi is connected
-    display->showNotification("Connect to WiFi first");
+    // Straight back to the last network when there is one and Auto WiFi
+    // Connect is on; mDNS follows in loop() once it has an address
+    bool reconnecting = settings.autoConnect() && wifiScanner->reconnect();
+    display->showNotification(reconnecting ? "Reconnecting..." : "Connect to WiFi first");
     
     setupOTA();
+    otaHttp = new HttpTask("ota_http", serveOta);
+    otaHttp->start();
     
     // Show main menu
     menu->drawMainMenu();
+    
+    // From here on only the UI task touches the menu and display
+    xTaskCreatePinnedToCore(uiTask, "ui", UI_TASK_STACK, nullptr, UI_TASK_PRIORITY, nullptr,
+                            UI_TASK_CORE);
 }
 
 void loop() {
     static bool mdnsStarted = false;
     
-    // Handle button presses
-    if(upPressed) {
-        menu->handleUpButton();
-        upPressed = false;
-    }
-    if(downPressed) {
-        menu->handleDownButton();
-        downPressed = false;
-    }
-    if(selectPressed) {
-        menu->handleSelectButton();
-        selectPressed = false;
+    // Requests from the menu, every one queued since the last pass
+    NetMessage command;
+    while (xQueueReceive(netQueue, &command, 0) == pdTRUE) {
+        handleNetCommand(command);
     }
     
-    // Start mDNS once WiFi is connected
+    // Start mDNS once WiFi is connected; the OTA routes are already up
+    // from setup() and served by ota_http
     if (WiFi.status() == WL_CONNECTED && !mdnsStarted) {
         if (MDNS.begin(OTA_HOSTNAME)) {
-            display->showNotification("OTA Ready");
+            otaReadyMs = millis();
+            Serial.printf("OTA ready %lu ms after boot\n", otaReadyMs);
+            postToUi(UI_OTA_READY, 0);
             mdnsStarted = true;
-            setupOTA();
         }
     }
     
-    // Handle web servers
-    if (WiFi.status() == WL_CONNECTED) {
-        server.handleClient();  // Handle OTA server
-    }
-    wifiScanner->handleClient();  // Handle AP mode server if active
-    
-    // Regular menu updates (status bar, etc)
-    menu->update();
+    // Web servers, unless they run on their own tasks
+    otaHttp->poll();              // OTA server
+    wifiScanner->handleClient();  // AP mode server and rescans, if active
+    wifiScanner->poll();          // Advance any in-flight WiFi scan
     
-    // Small delay to prevent excessive CPU usage
-    delay(10);
+    // Let the WiFi stack and idle task run
+    delay(NET_LOOP_DELAY_MS);
 }
@@ -0,0 +1,147 @@
+// DeltaPatch against the simulated running partition:
+//
+//   pio test -e native -f test_delta_patch
+//
+// A patch made the way tools/make_delta.py lays it out has to rebuild the
+// target byte for byte, however the upload happens to split it.
+
+#include <esp_ota_ops.h>
+#include <sim.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "delta_patch.h"
+
+namespace {
+
+const size_t IMAGE_SIZE = 96 * 1024;
+const size_t INSERT_AT = 40 * 1024;
+const size_t INSERTED = 300;
+
+std::string source;
+std::string target;
+std::string patch;
+
+std::string randomBytes(size_t size, uint32_t seed) {
+    std::string out(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        out[i] = static_cast<char>(seed);
+    }
+    return out;
+}
+
+uint32_t crcOf(const std::string& data) {
+    return crc32Update(0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+void appendLE32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out += static_cast<char>(v >> (8 * i));
+    }
+}
+
+// One release to the next: a run inserted mid-image and the code after it
+// relocated, which shows up as small diffs every few bytes
+void makeRelease() {
+    source = randomBytes(IMAGE_SIZE, 2463534242u);
+    target = source.substr(0, INSERT_AT) + randomBytes(INSERTED, 88172645u) +
+             source.substr(INSERT_AT);
+    for (size_t i = INSERT_AT + INSERTED; i < target.size(); i += 61) {
+        target[i] = static_cast<char>(target[i] + 4);
+    }
+
+    patch = "DLT1";
+    appendLE32(patch, source.size());
+    appendLE32(patch, crcOf(source));
+    appendLE32(patch, target.size());
+    appendLE32(patch, crcOf(target));
+    size_t tail = source.size() - INSERT_AT;
+    appendLE32(patch, INSERT_AT);
+    appendLE32(patch, INSERTED);
+    appendLE32(patch, 0);
+    for (size_t i = 0; i < INSERT_AT; i++) {
+        patch += static_cast<char>(target[i] - source[i]);
+    }
+    patch += target.substr(INSERT_AT, INSERTED);
+    appendLE32(patch, tail);
+    appendLE32(patch, 0);
+    appendLE32(patch, 0);
+    for (size_t i = 0; i < tail; i++) {
+        patch += static_cast<char>(target[INSERT_AT + INSERTED + i] - source[INSERT_AT + i]);
+    }
+}
+
+// Applies data in pieces of the given size; false if the patch refused
+bool apply(const std::string& data, size_t piece, std::string& output) {
+    output.clear();
+    DeltaPatch delta(esp_ota_get_running_partition(), [&output](const uint8_t* out, size_t n) {
+        output.append(reinterpret_cast<const char*>(out), n);
+        return true;
+    });
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+    for (size_t at = 0; at < data.size(); at += piece) {
+        size_t n = data.size() - at < piece ? data.size() - at : piece;
+        if (!delta.write(p + at, n)) {
+            return false;
+        }
+    }
+    return delta.finish();
+}
+
+}  // namespace
+
+void setUp() {
+    sim::setRunningImage(reinterpret_cast<const uint8_t*>(source.data()), source.size());
+}
+
+void tearDown() {}
+
+void test_rebuilds_target() {
+    std::string output;
+    TEST_ASSERT_TRUE(apply(patch, 1436, output));  // one TCP segment at a time
+    TEST_ASSERT_EQUAL_UINT32(target.size(), output.size());
+    TEST_ASSERT_TRUE(output == target);
+}
+
+void test_any_split() {
+    const size_t pieces[] = {1, 7, 12, 20, 4096, patch.size()};
+    for (size_t piece : pieces) {
+        std::string output;
+        TEST_ASSERT_TRUE(apply(patch, piece, output));
+        TEST_ASSERT_TRUE(output == target);
+    }
+}
+
+void test_rejects_wrong_base() {
+    sim::setRunningImage(reinterpret_cast<const uint8_t*>(target.data()), target.size());
+    std::string output;
+    TEST_ASSERT_FALSE(apply(patch, 1436, output));
+}
+
+void test_rejects_corrupt_patch() {
+    std::string corrupt = patch;
+    corrupt[corrupt.size() / 2] ^= 0x01;
+    std::string output;
+    TEST_ASSERT_FALSE(apply(corrupt, 1436, output));
+}
+
+void test_rejects_truncated_patch() {
+    std::string output;
+    TEST_ASSERT_FALSE(apply(patch.substr(0, patch.size() - 1), 1436, output));
+}
+
+int main() {
+    makeRelease();
+    UNITY_BEGIN();
+    RUN_TEST(test_rebuilds_target);
+    RUN_TEST(test_any_split);
+    RUN_TEST(test_rejects_wrong_base);
+    RUN_TEST(test_rejects_corrupt_patch);
+    RUN_TEST(test_rejects_truncated_patch);
+    return UNITY_END();
+}
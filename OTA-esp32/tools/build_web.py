@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Minify and gzip the web assets in web/ into include/web_assets.h.
+
+    python3 tools/build_web.py
+
+Also runs as a PlatformIO pre-build script, so edits to web/ are picked up
+by the next build. The header is only rewritten when its content changes.
+
+Each asset becomes a gzip byte array in flash plus a WebAsset record with
+its content type and an ETag (hash of the compressed bytes), served as is
+by include/static_assets.h with Content-Encoding: gzip.
+
+The minifier is deliberately conservative: it drops comments and
+indentation, and collapses whitespace between tags and around CSS
+punctuation. Line breaks inside scripts are kept, so code that relies on
+automatic semicolon insertion still works.
+"""
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(ROOT, "web")
+OUTPUT = os.path.join(ROOT, "include", "web_assets.h")
+
+TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+}
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    # Inline style and script blocks get their own minifier
+    text = re.sub(r"(<style[^>]*>)(.*?)(</style>)",
+                  lambda m: m.group(1) + minify_css(m.group(2)) + m.group(3), text, flags=re.S)
+    parts = re.split(r"(<script[^>]*>.*?</script>)", text, flags=re.S)
+    for i, part in enumerate(parts):
+        if i % 2:
+            m = re.match(r"(<script[^>]*>)(.*?)(</script>)", part, flags=re.S)
+            parts[i] = m.group(1) + minify_js(m.group(2)) + m.group(3)
+        else:
+            part = re.sub(r">\s+<", "><", part)
+            part = re.sub(r"\s+", " ", part)
+            # Whitespace next to a script block is never significant
+            if i > 0:
+                part = part.lstrip()
+            if i < len(parts) - 1:
+                part = part.rstrip()
+            parts[i] = part
+    return "".join(parts).strip()
+
+
+MINIFIERS = {".html": minify_html, ".css": minify_css, ".js": minify_js}
+
+
+def symbol(name):
+    return "WEB_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def render(assets):
+    out = [
+        "// Generated by tools/build_web.py from web/; do not edit.",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "    const char* type;",
+        "    const char* etag;",
+        "    const uint8_t* data;  // gzip",
+        "    size_t length;",
+        "};",
+    ]
+    for name, source, minified, packed in assets:
+        sym = symbol(name)
+        etag = hashlib.sha256(packed).hexdigest()[:16]
+        out.append("")
+        out.append("// web/%s: %d bytes, %d minified, %d gzip"
+                   % (name, len(source), len(minified), len(packed)))
+        out.append("const uint8_t %s_GZ[] PROGMEM = {" % sym)
+        for i in range(0, len(packed), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        out.append("};")
+        out.append('const WebAsset %s = { "%s", "\\"%s\\"", %s_GZ, sizeof(%s_GZ) };'
+                   % (sym, TYPES[os.path.splitext(name)[1]], etag, sym, sym))
+    out += ["", "#endif", ""]
+    return "\r\n".join(out)
+
+
+def build():
+    assets = []
+    for name in sorted(os.listdir(WEB_DIR)):
+        ext = os.path.splitext(name)[1]
+        if ext not in MINIFIERS:
+            continue
+        with open(os.path.join(WEB_DIR, name), "rb") as f:
+            source = f.read()
+        minified = MINIFIERS[ext](source.decode("utf-8")).encode("utf-8")
+        # mtime=0 keeps the output, and so the ETags, reproducible
+        packed = gzip.compress(minified, compresslevel=9, mtime=0)
+        assets.append((name, source, minified, packed))
+
+    header = render(assets).encode("utf-8")
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, "rb") as f:
+            if f.read() == header:
+                return
+    with open(OUTPUT, "wb") as f:
+        f.write(header)
+    for name, source, minified, packed in assets:
+        print("web/%s: %d -> %d -> %d bytes" % (name, len(source), len(minified), len(packed)))
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO as a pre: script)
+except NameError:
+    pass  # run by hand
+build()
@@ -0,0 +1,35 @@
+# PlatformIO post-build script: signs firmware.bin with tools/keys/signing_key.pem
+# and writes firmware.signed.bin and firmware.signed.bin.gz next to it.
+# The /update endpoint detects the gzip header and inflates on the device,
+# so uploading the .gz file cuts the bytes sent over WiFi. The signature is
+# taken over the image before compression, which is what the device hashes.
+import gzip
+import os
+import sys
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "tools"))  # noqa: F821
+import sign_firmware  # noqa: E402
+
+
+def gzip_firmware(source, target, env):
+    firmware = os.path.join(env.subst("$BUILD_DIR"), env.subst("${PROGNAME}.bin"))
+    if not os.path.exists(sign_firmware.DEFAULT_KEY):
+        print("%s not found, nothing signed: run tools/sign_firmware.py --new-key"
+              % sign_firmware.DEFAULT_KEY)
+        return
+    with open(firmware, "rb") as f:
+        data = sign_firmware.sign_image(f.read(), sign_firmware.DEFAULT_KEY)
+    signed = os.path.splitext(firmware)[0] + ".signed.bin"
+    with open(signed, "wb") as f:
+        f.write(data)
+    # mtime=0 keeps a build timestamp out of the gzip header
+    packed = gzip.compress(data, compresslevel=9, mtime=0)
+    with open(signed + ".gz", "wb") as f:
+        f.write(packed)
+    print("firmware.signed.bin.gz: %d -> %d bytes (%.0f%%)"
+          % (len(data), len(packed), 100.0 * len(packed) / len(data)))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", gzip_firmware)  # noqa: F821
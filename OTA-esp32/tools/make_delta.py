@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Build a delta patch for OTA updates against the firmware currently running.
+
+    python3 tools/make_delta.py old/firmware.bin .pio/build/esp32dev/firmware.signed.bin update.dlt
+
+The output is gzip-compressed unless --no-gzip is given; upload it on the
+/update page like a normal firmware file. The device checks that its running
+image matches old/firmware.bin (CRC-32) before applying anything.
+
+The source is the unsigned firmware.bin of the version the device runs: the
+signature trailer is stripped on the way to flash, so the running partition
+never holds it. The target is the signed new image, so the patch rebuilds
+the trailer and the device can verify the result.
+
+Format (all integers 32-bit little endian, see include/delta_patch.h):
+    header: b"DLT1", source size, source CRC-32, target size, target CRC-32
+    record: diff length, extra length, source seek (signed)
+            diff bytes  - added (mod 256) to the source at the current position
+            extra bytes - copied to the output unchanged
+
+Matching follows bsdiff: find exact matches through a k-gram index of the
+source, then extend each one forward while most bytes still agree, so code
+that only moved (and whose embedded addresses changed) costs mostly zero
+diff bytes, which gzip squeezes to almost nothing.
+"""
+import argparse
+import gzip
+import struct
+import sys
+import zlib
+
+K = 16            # bytes per index key
+INDEX_STEP = 4    # index every 4th source position; target is scanned at every position
+MIN_MATCH = 24    # shorter exact matches are sent as extra bytes
+FUZZ_WINDOW = 64  # stop extending a match after this many bytes without gain
+
+SIG_TRAILER_SIZE = 80  # see tools/sign_firmware.py
+SIG_MAGIC = b"OSG1"
+
+
+def build_index(source):
+    index = {}
+    for pos in range(0, len(source) - K + 1, INDEX_STEP):
+        index.setdefault(source[pos:pos + K], pos)
+    return index
+
+
+def exact_length(source, src, target, tgt):
+    """Length of the common run starting at source[src], target[tgt]."""
+    limit = min(len(source) - src, len(target) - tgt)
+    n = 0
+    step = 256
+    while n + step <= limit and source[src + n:src + n + step] == target[tgt + n:tgt + n + step]:
+        n += step
+    while n < limit and source[src + n] == target[tgt + n]:
+        n += 1
+    return n
+
+
+def fuzzy_length(source, src, target, tgt, start):
+    """Extends a match past its exact part while equal bytes outnumber unequal ones."""
+    limit = min(len(source) - src, len(target) - tgt)
+    best, best_score, score = start, 0, 0
+    i = start
+    while i < limit and i - best < FUZZ_WINDOW:
+        score += 1 if source[src + i] == target[tgt + i] else -1
+        i += 1
+        if score > best_score:
+            best, best_score = i, score
+    return best
+
+
+def find_matches(source, target):
+    """Returns (target pos, source pos, length) for each match, in target order."""
+    index = build_index(source)
+    matches = []
+    tgt = 0
+    offset = 0  # source - target of the previous match, tried first
+    while tgt + K <= len(target):
+        key = target[tgt:tgt + K]
+        candidates = []
+        if 0 <= tgt + offset <= len(source) - K and source[tgt + offset:tgt + offset + K] == key:
+            candidates.append(tgt + offset)
+        pos = index.get(key)
+        if pos is not None:
+            candidates.append(pos)
+
+        best_src, best_len = None, 0
+        for src in candidates:
+            length = exact_length(source, src, target, tgt)
+            if length > best_len:
+                best_src, best_len = src, length
+        if best_len < MIN_MATCH:
+            tgt += 1
+            continue
+
+        # Grow backwards over bytes the previous match did not cover
+        covered = matches[-1][0] + matches[-1][2] if matches else 0
+        while tgt > covered and best_src > 0 and source[best_src - 1] == target[tgt - 1]:
+            tgt -= 1
+            best_src -= 1
+            best_len += 1
+
+        length = fuzzy_length(source, best_src, target, tgt, best_len)
+        matches.append((tgt, best_src, length))
+        offset = best_src - tgt
+        tgt += length
+    return matches
+
+
+def make_patch(source, target):
+    out = bytearray(b"DLT1")
+    out += struct.pack("<IIII", len(source), zlib.crc32(source) & 0xFFFFFFFF,
+                       len(target), zlib.crc32(target) & 0xFFFFFFFF)
+    matches = find_matches(source, target)
+
+    # A leading record carries target bytes before the first match
+    first_tgt, first_src = (matches[0][0], matches[0][1]) if matches else (len(target), 0)
+    out += struct.pack("<IIi", 0, first_tgt, first_src)
+    out += target[:first_tgt]
+
+    for i, (tgt, src, length) in enumerate(matches):
+        if i + 1 < len(matches):
+            next_tgt, next_src = matches[i + 1][0], matches[i + 1][1]
+        else:
+            next_tgt, next_src = len(target), src + length
+        out += struct.pack("<IIi", length, next_tgt - tgt - length, next_src - (src + length))
+        out += bytes((target[tgt + j] - source[src + j]) & 0xFF for j in range(length))
+        out += target[tgt + length:next_tgt]
+    return bytes(out), matches
+
+
+def apply_patch(source, patch):
+    """Reference implementation, used to check the patch before writing it."""
+    magic, src_size, src_crc, tgt_size, tgt_crc = struct.unpack_from("<4sIIII", patch, 0)
+    assert magic == b"DLT1" and src_size == len(source)
+    pos, src, out = 20, 0, bytearray()
+    while len(out) < tgt_size:
+        diff, extra, seek = struct.unpack_from("<IIi", patch, pos)
+        pos += 12
+        out += bytes((source[src + j] + patch[pos + j]) & 0xFF for j in range(diff))
+        pos += diff
+        src += diff
+        out += patch[pos:pos + extra]
+        pos += extra
+        src += seek
+    assert zlib.crc32(bytes(out)) & 0xFFFFFFFF == tgt_crc
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("source", help="unsigned firmware.bin currently running on the device")
+    parser.add_argument("target", help="new firmware.signed.bin")
+    parser.add_argument("output", help="patch file to upload")
+    parser.add_argument("--no-gzip", action="store_true", help="write the patch uncompressed")
+    args = parser.parse_args()
+
+    with open(args.source, "rb") as f:
+        source = f.read()
+    with open(args.target, "rb") as f:
+        target = f.read()
+    if source[-SIG_TRAILER_SIZE:-SIG_TRAILER_SIZE + 4] == SIG_MAGIC:
+        sys.exit("%s is signed; the device runs the image without its trailer, "
+                 "diff against the unsigned firmware.bin" % args.source)
+
+    patch, matches = make_patch(source, target)
+    if apply_patch(source, patch) != target:
+        sys.exit("internal error: patch does not reproduce the target")
+    data = patch if args.no_gzip else gzip.compress(patch, compresslevel=9, mtime=0)
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    copied = sum(m[2] for m in matches)
+    print("%s: %d bytes (target %d bytes, %d matches covering %.1f%%)"
+          % (args.output, len(data), len(target), len(matches),
+             100.0 * copied / max(1, len(target))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Append an ECDSA P-256 signature trailer to a firmware image.
+
+    python3 tools/sign_firmware.py .pio/build/esp32dev/firmware.bin firmware.signed.bin
+
+The device hashes the image while it is written and checks the trailer
+against OTA_PUBLIC_KEY_PEM before committing the update.
+Sign before compressing (gzip) or diffing (make_delta.py): the signature
+covers the final image, not the transfer encoding. tools/gzip_firmware.py
+does this after every build, writing firmware.signed.bin(.gz).
+
+Trailer layout (OTA_SIG_TRAILER_SIZE = 80 bytes, see include/image_verifier.h):
+    b"OSG1", DER signature length (uint16 LE), 2 reserved bytes,
+    DER ECDSA signature over SHA-256(image), zero padded to 72 bytes
+
+New key pair, once per project:
+    python3 tools/sign_firmware.py --new-key
+
+writes tools/keys/signing_key.pem (the private key, the default for --key)
+and tools/keys/ota_signing_key.h, which defines OTA_PUBLIC_KEY_PEM for the
+firmware build. tools/keys/ is not in git: back it up, the devices in the
+field only accept images signed with that key.
+"""
+import argparse
+import os
+import struct
+import subprocess
+import sys
+
+TRAILER_SIZE = 80
+KEY_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "keys")
+DEFAULT_KEY = os.path.join(KEY_DIR, "signing_key.pem")
+KEY_HEADER = os.path.join(KEY_DIR, "ota_signing_key.h")
+
+
+def sign(image, key):
+    result = subprocess.run(["openssl", "dgst", "-sha256", "-sign", key, "-binary"],
+                            input=image, stdout=subprocess.PIPE, check=True)
+    return result.stdout
+
+
+def sign_image(image, key):
+    """Returns image with its signature trailer appended."""
+    if image[-TRAILER_SIZE:-TRAILER_SIZE + 4] == b"OSG1":
+        raise ValueError("already signed")
+    signature = sign(image, key)
+    trailer = b"OSG1" + struct.pack("<HH", len(signature), 0) + signature
+    if len(trailer) > TRAILER_SIZE:
+        raise ValueError("signature too long (%d bytes); is the key P-256?" % len(signature))
+    return image + trailer + b"\0" * (TRAILER_SIZE - len(trailer))
+
+
+def new_key(key):
+    if os.path.exists(key):
+        sys.exit("%s already exists; remove it first to replace the key" % key)
+    os.makedirs(os.path.dirname(key), exist_ok=True)
+    subprocess.run(["openssl", "ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", key],
+                   check=True)
+    os.chmod(key, 0o600)
+    public = subprocess.run(["openssl", "ec", "-in", key, "-pubout"], stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, check=True).stdout.decode()
+    lines = ["    \"%s\\n\"" % line for line in public.strip().splitlines()]
+    with open(KEY_HEADER, "w") as f:
+        f.write("// Made by tools/sign_firmware.py --new-key; pairs with %s\n"
+                % os.path.basename(key))
+        f.write("#define OTA_PUBLIC_KEY_PEM \\\n%s\n" % " \\\n".join(lines))
+    print("%s: private key\n%s: OTA_PUBLIC_KEY_PEM" % (key, KEY_HEADER))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("image", nargs="?", help="firmware.bin to sign")
+    parser.add_argument("output", nargs="?", help="signed image to write")
+    parser.add_argument("--key", default=DEFAULT_KEY, help="PEM private key (P-256)")
+    parser.add_argument("--new-key", action="store_true",
+                        help="make a key pair in tools/keys/ instead of signing")
+    args = parser.parse_args()
+    if args.new_key:
+        new_key(args.key)
+        return
+    if not args.output:
+        parser.error("image and output are required")
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    try:
+        signed = sign_image(image, args.key)
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.image, e))
+
+    with open(args.output, "wb") as f:
+        f.write(signed)
+    print("%s: %d bytes + %d byte trailer" % (args.output, len(image), TRAILER_SIZE))
+
+
+if __name__ == "__main__":
+    main()